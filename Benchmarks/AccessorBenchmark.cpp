@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <Core/Vertex.h>
+#include <Utils/Loaders/AccessorReader.h>
+#include <Utils/Logger.hpp>
+
+namespace
+{
+
+using Lucid::Loaders::AccessorReader;
+
+const std::string Usage = "Usage: AccessorBenchmark [--vertices count] [--iterations count]";
+
+double
+Measure(std::size_t iterations, const std::function<void()>& function)
+{
+    double best = 0.0;
+
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (i == 0 || elapsed.count() < best)
+        {
+            best = elapsed.count();
+        }
+    }
+
+    return best;
+}
+
+AccessorReader::Accessor
+MakeFloatAccessor(const std::uint8_t* data, std::size_t count, std::size_t stride, std::size_t components)
+{
+    AccessorReader::Accessor accessor;
+    accessor.data = data;
+    accessor.count = count;
+    accessor.stride = stride;
+    accessor.components = components;
+    return accessor;
+}
+
+const float*
+AsFloats(const std::uint8_t* data)
+{
+    return static_cast<const float*>(static_cast<const void*>(data));
+}
+
+// The loop GltfLoader used before the accessor layer, one vertex and one attribute at a time
+void
+PerVertex(
+    std::vector<Lucid::Core::Vertex>& vertices,
+    const AccessorReader::Accessor& positions,
+    const AccessorReader::Accessor& normals,
+    const AccessorReader::Accessor& uvs)
+{
+    for (std::size_t i = 0; i < vertices.size(); i++)
+    {
+        Lucid::Core::Vertex& vertex = vertices[i];
+
+        const float* position = AsFloats(positions.data + i * positions.stride);
+        vertex.position = { position[0], position[1], position[2] };
+        vertex.color = { 1.0f, 1.0f, 1.0f };
+
+        const float* normal = AsFloats(normals.data + i * normals.stride);
+        vertex.normal = { normal[0], normal[1], normal[2] };
+
+        const float* uv = AsFloats(uvs.data + i * uvs.stride);
+        vertex.uv = { uv[0], uv[1] };
+    }
+}
+
+void
+PerIndex(std::vector<std::uint32_t>& indices, const std::uint8_t* data)
+{
+    for (std::size_t i = 0; i < indices.size(); i++)
+    {
+        std::uint16_t index;
+        std::memcpy(&index, data + i * sizeof(index), sizeof(index));
+        indices[i] = index;
+    }
+}
+
+} // namespace
+
+/*
+        Compares the per vertex glTF decoding loop against AccessorReader on a synthetic interleaved mesh.
+        Positions, normals and uvs share one buffer view with a 32 byte stride, indices are 16 bit.
+*/
+auto
+main(int argc, char** argv) -> int
+try
+{
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+    std::size_t vertexCount = 4'000'000;
+    std::size_t iterations = 5;
+
+    for (std::size_t i = 0; i + 1 < arguments.size(); i += 2)
+    {
+        if (arguments.at(i) == "--vertices")
+        {
+            vertexCount = std::max<std::size_t>(std::stoul(arguments.at(i + 1)), 1);
+        }
+        else if (arguments.at(i) == "--iterations")
+        {
+            iterations = std::max<std::size_t>(std::stoul(arguments.at(i + 1)), 1);
+        }
+        else
+        {
+            throw std::runtime_error(Usage);
+        }
+    }
+
+    const std::size_t floatsPerVertex = 8;
+    std::vector<float> interleaved(vertexCount * floatsPerVertex);
+    for (std::size_t i = 0; i < interleaved.size(); i++)
+    {
+        interleaved[i] = static_cast<float>(i % 1000) * 0.001f;
+    }
+
+    std::vector<std::uint16_t> shortIndices(vertexCount * 3 / 2);
+    for (std::size_t i = 0; i < shortIndices.size(); i++)
+    {
+        shortIndices[i] = static_cast<std::uint16_t>(i * 7919);
+    }
+
+    auto bytes = static_cast<const std::uint8_t*>(static_cast<const void*>(interleaved.data()));
+    std::size_t stride = floatsPerVertex * sizeof(float);
+
+    AccessorReader::Accessor positions = MakeFloatAccessor(bytes, vertexCount, stride, 3);
+    AccessorReader::Accessor normals = MakeFloatAccessor(bytes + 12, vertexCount, stride, 3);
+    AccessorReader::Accessor uvs = MakeFloatAccessor(bytes + 24, vertexCount, stride, 2);
+
+    AccessorReader::Accessor indices;
+    indices.data = static_cast<const std::uint8_t*>(static_cast<const void*>(shortIndices.data()));
+    indices.count = shortIndices.size();
+    indices.stride = sizeof(std::uint16_t);
+    indices.components = 1;
+    indices.type = AccessorReader::ComponentType::UnsignedShort;
+
+    std::vector<Lucid::Core::Vertex> expected(vertexCount), actual(vertexCount);
+    std::vector<std::uint32_t> expectedIndices(shortIndices.size()), actualIndices(shortIndices.size());
+
+    double perVertex = Measure(iterations, [&]() { PerVertex(expected, positions, normals, uvs); });
+    double batch = Measure(iterations, [&]() { AccessorReader::Interleave(actual, positions, &normals, &uvs); });
+    double perIndex = Measure(iterations, [&]() { PerIndex(expectedIndices, indices.data); });
+    double widened = Measure(iterations, [&]() { AccessorReader::ReadIndices(indices, actualIndices); });
+
+    if (std::memcmp(expected.data(), actual.data(), expected.size() * sizeof(Lucid::Core::Vertex)) != 0
+        || expectedIndices != actualIndices)
+    {
+        throw std::runtime_error("Batch decoding disagrees with the per vertex loop");
+    }
+
+    double megabytes = static_cast<double>(vertexCount * sizeof(Lucid::Core::Vertex)) / (1024.0 * 1024.0);
+    LoggerInfo << vertexCount << " vertices, " << shortIndices.size() << " indices, best of " << iterations;
+    LoggerInfo << "Per vertex: " << perVertex << " ms, " << megabytes / (perVertex / 1000.0) << " MB/s";
+    LoggerInfo << "Interleave: " << batch << " ms, " << megabytes / (batch / 1000.0) << " MB/s";
+    LoggerInfo << "Vertex speedup " << perVertex / batch << "x";
+    LoggerInfo << "Per index: " << perIndex << " ms, widened: " << widened << " ms, speedup " << perIndex / widened
+               << "x";
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception& ex)
+{
+    LoggerError << ex.what();
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <Core/Bvh.h>
+#include <Utils/Logger.hpp>
+#include <Utils/ThreadPool.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+
+using Lucid::Core::Aabb;
+using Lucid::Core::Bvh;
+
+const std::string Usage = "Usage: BvhBenchmark [--nodes count] [--queries count] [--iterations count]";
+
+double
+Measure(std::size_t iterations, const std::function<void()>& function)
+{
+    double best = 0.0;
+
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (i == 0 || elapsed.count() < best)
+        {
+            best = elapsed.count();
+        }
+    }
+
+    return best;
+}
+
+// City like layout, small boxes spread over a wide and flat area with a few dense clusters
+std::vector<Aabb>
+MakeBounds(std::size_t count, std::mt19937& random)
+{
+    std::uniform_real_distribution<float> position(-2000.0f, 2000.0f);
+    std::uniform_real_distribution<float> height(0.0f, 50.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+    std::normal_distribution<float> cluster(0.0f, 20.0f);
+
+    std::vector<Aabb> bounds(count);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        glm::vec3 center(position(random), height(random), position(random));
+        if (i % 8 == 0)
+        {
+            center = glm::vec3(cluster(random) + 100.0f * static_cast<float>(i % 5), height(random), cluster(random));
+        }
+
+        glm::vec3 extent(size(random), size(random), size(random));
+        bounds[i].min = center - extent;
+        bounds[i].max = center + extent;
+    }
+
+    return bounds;
+}
+
+} // namespace
+
+/*
+        Builds a BVH over synthetic node bounds and times its queries against a linear scan of every node,
+        the way culling and picking worked before. Reports the best of several runs.
+*/
+auto
+main(int argc, char** argv) -> int
+try
+{
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+    std::size_t nodeCount = 1'000'000;
+    std::size_t queryCount = 1000;
+    std::size_t iterations = 3;
+
+    for (std::size_t i = 0; i + 1 < arguments.size(); i += 2)
+    {
+        if (arguments.at(i) == "--nodes")
+        {
+            nodeCount = std::max<std::size_t>(std::stoul(arguments.at(i + 1)), 1);
+        }
+        else if (arguments.at(i) == "--queries")
+        {
+            queryCount = std::max<std::size_t>(std::stoul(arguments.at(i + 1)), 1);
+        }
+        else if (arguments.at(i) == "--iterations")
+        {
+            iterations = std::max<std::size_t>(std::stoul(arguments.at(i + 1)), 1);
+        }
+        else
+        {
+            throw std::runtime_error(Usage);
+        }
+    }
+
+    std::mt19937 random(42);
+    std::vector<Aabb> bounds = MakeBounds(nodeCount, random);
+
+    LoggerInfo << nodeCount << " nodes on " << Lucid::ThreadPool::Instance().GetThreadCount() << " threads, best of "
+               << iterations;
+
+    Bvh bvh;
+    double build = Measure(iterations, [&]() { bvh.Build(bounds); });
+    LoggerInfo << "Build: " << build << " ms, " << bvh.GetNodeCount() << " tree nodes";
+
+    // Frustum of a camera looking over the area, against the bounding sphere test of the renderer
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    glm::mat4 view
+        = glm::lookAt(glm::vec3(0.0f, 30.0f, 0.0f), glm::vec3(1.0f, 25.0f, 0.3f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Lucid::Core::Frustum frustum(projection * view);
+
+    std::vector<std::uint32_t> items;
+    std::size_t linearVisible = 0;
+
+    double frustumQuery = Measure(iterations, [&]() { bvh.QueryFrustum(frustum, items); });
+    double frustumLinear = Measure(
+        iterations,
+        [&]()
+        {
+            linearVisible = 0;
+            for (const Aabb& box : bounds)
+            {
+                glm::vec3 center = box.GetCenter();
+                glm::vec4 sphere(center, glm::length(box.max - center));
+                linearVisible += frustum.IsOutside(sphere) ? 0u : 1u;
+            }
+        });
+
+    LoggerInfo << "Frustum: " << frustumQuery << " ms for " << items.size() << " nodes, linear " << frustumLinear
+               << " ms for " << linearVisible << ", speedup " << frustumLinear / frustumQuery << "x";
+
+    // Boxes around random points, checked against the linear scan
+    std::uniform_real_distribution<float> position(-2000.0f, 2000.0f);
+    std::vector<Aabb> boxes(queryCount);
+    for (Aabb& box : boxes)
+    {
+        glm::vec3 center(position(random), 25.0f, position(random));
+        box.min = center - glm::vec3(40.0f);
+        box.max = center + glm::vec3(40.0f);
+    }
+
+    std::size_t boxHits = 0;
+    double aabbQuery = Measure(
+        iterations,
+        [&]()
+        {
+            boxHits = 0;
+            for (const Aabb& box : boxes)
+            {
+                bvh.QueryAabb(box, items);
+                boxHits += items.size();
+            }
+        });
+
+    // The linear scan is only timed on a few boxes
+    std::vector<std::size_t> linearBoxHits(std::min<std::size_t>(queryCount, 10));
+    double aabbLinear = Measure(
+        1,
+        [&]()
+        {
+            for (std::size_t i = 0; i < linearBoxHits.size(); i++)
+            {
+                auto intersects = [&box = boxes[i]](const Aabb& node) { return box.Intersects(node); };
+                linearBoxHits[i] = static_cast<std::size_t>(std::count_if(bounds.begin(), bounds.end(), intersects));
+            }
+        });
+
+    for (std::size_t i = 0; i < linearBoxHits.size(); i++)
+    {
+        bvh.QueryAabb(boxes[i], items);
+        if (items.size() != linearBoxHits[i])
+        {
+            throw std::runtime_error("BVH and linear scan disagree on a box query");
+        }
+    }
+
+    auto perQuery = [&](double milliseconds) { return milliseconds * 1000.0 / static_cast<double>(queryCount); };
+    double linearPerQuery = aabbLinear * 1000.0 / static_cast<double>(linearBoxHits.size());
+
+    LoggerInfo << "Box: " << perQuery(aabbQuery) << " us per query, " << boxHits / queryCount
+               << " nodes on average, linear " << linearPerQuery << " us";
+
+    // Picking rays from the camera height in random directions
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<std::pair<glm::vec3, glm::vec3>> rays(queryCount);
+    for (auto& [origin, direction] : rays)
+    {
+        origin = glm::vec3(position(random), 30.0f, position(random));
+        direction = glm::normalize(glm::vec3(unit(random), unit(random) * 0.2f - 0.1f, unit(random)));
+    }
+
+    std::size_t rayHits = 0;
+    double raycast = Measure(
+        iterations,
+        [&]()
+        {
+            rayHits = 0;
+            for (const auto& [origin, direction] : rays)
+            {
+                rayHits += bvh.Raycast(origin, direction).has_value() ? 1u : 0u;
+            }
+        });
+
+    LoggerInfo << "Raycast: " << perQuery(raycast) << " us per ray, " << rayHits << " of " << queryCount << " hit";
+
+    // Nearest neighbours of random points
+    std::vector<Bvh::Hit> hits;
+    double nearest = Measure(
+        iterations,
+        [&]()
+        {
+            for (const Aabb& box : boxes)
+            {
+                bvh.QueryNearest(box.GetCenter(), 16, hits);
+            }
+        });
+
+    LoggerInfo << "Nearest 16: " << perQuery(nearest) << " us per query";
+
+    // Small moves keep the topology useful, refit against a full rebuild
+    std::uniform_real_distribution<float> move(-1.0f, 1.0f);
+    for (Aabb& box : bounds)
+    {
+        glm::vec3 offset(move(random), 0.0f, move(random));
+        box.min += offset;
+        box.max += offset;
+    }
+
+    double refit = Measure(iterations, [&]() { bvh.Refit(bounds); });
+    double frustumRefitted = Measure(iterations, [&]() { bvh.QueryFrustum(frustum, items); });
+
+    LoggerInfo << "Refit: " << refit << " ms, " << build / refit << "x faster than the build, frustum after "
+               << frustumRefitted << " ms";
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception& ex)
+{
+    LoggerError << ex.what();
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <tiny_obj_loader.h>
+
+#include <Utils/Loaders/ObjParser.h>
+#include <Utils/Logger.hpp>
+#include <Utils/ThreadPool.h>
+
+namespace
+{
+
+const std::string Usage = "Usage: ObjParserBenchmark [--iterations count] model.obj";
+
+struct Measurement
+{
+    double milliseconds;
+    std::size_t positions;
+    std::size_t corners;
+};
+
+Measurement
+Measure(std::size_t iterations, const std::function<std::pair<std::size_t, std::size_t>()>& function)
+{
+    Measurement best { 0.0, 0, 0 };
+
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto [positions, corners] = function();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (i == 0 || elapsed.count() < best.milliseconds)
+        {
+            best = { elapsed.count(), positions, corners };
+        }
+    }
+
+    return best;
+}
+
+} // namespace
+
+/*
+        Compares the native parallel OBJ parser against tinyobjloader on the same file.
+        Reports the best of several runs, the page cache is warm after the first one.
+*/
+auto
+main(int argc, char** argv) -> int
+try
+{
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+    std::filesystem::path path;
+    std::size_t iterations = 3;
+
+    for (std::size_t i = 0; i < arguments.size(); i++)
+    {
+        if (arguments.at(i) == "--iterations" && i + 1 < arguments.size())
+        {
+            iterations = std::max<std::size_t>(std::stoul(arguments.at(++i)), 1);
+        }
+        else
+        {
+            path = arguments.at(i);
+        }
+    }
+
+    if (path.empty())
+    {
+        throw std::runtime_error(Usage);
+    }
+
+    double megabytes = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+    LoggerInfo << "Parsing " << path.string() << " (" << megabytes << " MB) on "
+               << Lucid::ThreadPool::Instance().GetThreadCount() << " threads";
+
+    Measurement tinyobj = Measure(
+        iterations,
+        [&path]()
+        {
+            tinyobj::attrib_t attrib;
+            std::vector<tinyobj::shape_t> shapes;
+            std::vector<tinyobj::material_t> materials;
+            std::string error, warning;
+
+            if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, path.string().c_str()))
+            {
+                throw std::runtime_error("tinyobj failed: " + error);
+            }
+
+            std::size_t corners = 0;
+            for (const auto& shape : shapes)
+            {
+                corners += shape.mesh.indices.size();
+            }
+
+            return std::make_pair(attrib.vertices.size() / 3, corners);
+        });
+
+    Measurement native = Measure(
+        iterations,
+        [&path]()
+        {
+            Lucid::Loaders::ObjParser::Result result = Lucid::Loaders::ObjParser::Parse(path);
+            return std::make_pair(result.positions.size() / 3, result.corners.size());
+        });
+
+    for (const auto& [name, measurement] : { std::make_pair("tinyobj", tinyobj), std::make_pair("ObjParser", native) })
+    {
+        LoggerInfo << name << ": " << measurement.milliseconds << " ms, "
+                   << megabytes / (measurement.milliseconds / 1000.0) << " MB/s, " << measurement.positions
+                   << " positions, " << measurement.corners << " corners";
+    }
+
+    if (tinyobj.positions != native.positions || tinyobj.corners != native.corners)
+    {
+        throw std::runtime_error("Parsers disagree on the element counts");
+    }
+
+    LoggerInfo << "Speedup " << tinyobj.milliseconds / native.milliseconds << "x";
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception& ex)
+{
+    LoggerError << ex.what();
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <Utils/Defaults.hpp>
+#include <Utils/Files.h>
+#include <Utils/Loaders/Ktx2Loader.h>
+#include <Utils/Logger.hpp>
+#include <Utils/Textures/TextureCooker.h>
+
+using Compression = Lucid::Textures::TextureCooker::Compression;
+using Filter = Lucid::Textures::MipGenerator::Filter;
+
+namespace
+{
+
+const std::string Usage
+    = "Usage: Cooker [--format auto|bc1|bc7|none] [--filter box|kaiser] [--output file.ktx2] [--cubemap] texture...";
+
+Compression
+ParseCompression(const std::string& value)
+{
+    if (value == "auto")
+    {
+        return Compression::Auto;
+    }
+    else if (value == "bc1")
+    {
+        return Compression::Bc1;
+    }
+    else if (value == "bc7")
+    {
+        return Compression::Bc7;
+    }
+    else if (value == "none")
+    {
+        return Compression::None;
+    }
+
+    throw std::runtime_error("Unknown format " + value + "\n" + Usage);
+}
+
+Filter
+ParseFilter(const std::string& value)
+{
+    if (value == "box")
+    {
+        return Filter::Box;
+    }
+    else if (value == "kaiser")
+    {
+        return Filter::Kaiser;
+    }
+
+    throw std::runtime_error("Unknown filter " + value + "\n" + Usage);
+}
+
+} // namespace
+
+/*
+        Offline texture cooker. Writes KTX2 files that the engine picks up on load,
+        by default straight into the engine texture cache.
+*/
+auto
+main(int argc, char** argv) -> int
+try
+{
+    LoggerInfo << "Version " << Defaults::Version;
+
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+    std::vector<std::filesystem::path> inputs;
+    std::filesystem::path output;
+    Compression compression = Compression::Auto;
+    Filter filter = Filter::Box;
+    bool cubemap = false;
+
+    for (std::size_t i = 0; i < arguments.size(); i++)
+    {
+        const std::string& argument = arguments.at(i);
+
+        if ((argument == "--format" || argument == "--filter" || argument == "--output") && i + 1 == arguments.size())
+        {
+            throw std::runtime_error("Missing value for " + argument + "\n" + Usage);
+        }
+
+        if (argument == "--format")
+        {
+            compression = ParseCompression(arguments.at(++i));
+        }
+        else if (argument == "--filter")
+        {
+            filter = ParseFilter(arguments.at(++i));
+        }
+        else if (argument == "--output")
+        {
+            output = arguments.at(++i);
+        }
+        else if (argument == "--cubemap")
+        {
+            cubemap = true;
+        }
+        else if (argument == "--help" || argument == "-h")
+        {
+            std::cout << Usage << '\n';
+            return EXIT_SUCCESS;
+        }
+        else
+        {
+            inputs.emplace_back(argument);
+        }
+    }
+
+    if (cubemap)
+    {
+        // Faces in the order the engine samples them: back, front, left, right, up, down
+        if (inputs.size() != 6)
+        {
+            throw std::runtime_error("Cubemap requires exactly 6 faces\n" + Usage);
+        }
+
+        std::array<std::filesystem::path, 6> faces;
+        std::copy(inputs.begin(), inputs.end(), faces.begin());
+
+        std::filesystem::path destination
+            = output.empty() ? Lucid::Textures::TextureCooker::GetCachePath(inputs, compression) : output;
+
+        Lucid::Core::TexturePtr texture
+            = Lucid::Textures::TextureCooker::Cook(*Lucid::Files::DecodeCubemap(faces), compression, filter);
+        Lucid::Loaders::Ktx2Loader::Save(destination, *texture);
+
+        LoggerInfo << "Cooked cubemap -> " << destination.string() << " (" << texture->pixels.size() << " bytes, "
+                   << texture->mipLevels << " levels)";
+
+        return EXIT_SUCCESS;
+    }
+
+    if (inputs.empty() || (!output.empty() && inputs.size() > 1))
+    {
+        throw std::runtime_error(Usage);
+    }
+
+    for (const auto& input : inputs)
+    {
+        std::filesystem::path destination
+            = output.empty() ? Lucid::Textures::TextureCooker::GetCachePath(input, compression) : output;
+
+        Lucid::Core::TexturePtr texture
+            = Lucid::Textures::TextureCooker::Cook(*Lucid::Files::DecodeTexture(input), compression, filter);
+        Lucid::Loaders::Ktx2Loader::Save(destination, *texture);
+
+        LoggerInfo << "Cooked " << input.string() << " -> " << destination.string() << " (" << texture->pixels.size()
+                   << " bytes, " << texture->mipLevels << " levels)";
+    }
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception& ex)
+{
+    LoggerError << ex.what();
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,6 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Depth only, color writes are masked by the pipeline
+void main() {
+}
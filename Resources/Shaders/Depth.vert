@@ -0,0 +1,20 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 projection;
+} ubo;
+
+// Position of the packed vertex alone, quantized exactly as for Shader.vert
+layout(location = 0) in vec3 inPosition;
+layout(location = 4) in mat4 inInstanceModel;
+
+// Depth must match Shader.vert bit for bit, the shading pass tests it for equality
+invariant gl_Position;
+
+void main() {
+    vec4 worldPosition = inInstanceModel * ubo.model * vec4(inPosition, 1.0);
+    gl_Position = ubo.projection * ubo.view * worldPosition;
+}
@@ -7,20 +7,35 @@ layout(binding = 0) uniform UniformBufferObject {
     mat4 projection;
 } ubo;
 
+// Packed vertex, position is normalized to the mesh bounds which the model matrix maps back
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
+layout(location = 1) in vec2 inNormal; // Octahedral
 layout(location = 2) in vec3 inColor;
 layout(location = 3) in vec2 inTextCoordinate;
 
+// Node transform per instance with the mesh dequantization folded in, ubo.model is identity
+layout(location = 4) in mat4 inInstanceModel;
+
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTextCoord;
 layout(location = 2) out vec3 fragNormal;
 layout(location = 3) out vec3 fragPosition;
 
+vec3 DecodeOctahedral(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-normal.z, 0.0);
+    normal.x += normal.x >= 0.0 ? -fold : fold;
+    normal.y += normal.y >= 0.0 ? -fold : fold;
+    return normalize(normal);
+}
+
+invariant gl_Position;
+
 void main() {
-    gl_Position = ubo.projection * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    vec4 worldPosition = inInstanceModel * ubo.model * vec4(inPosition, 1.0);
+    gl_Position = ubo.projection * ubo.view * worldPosition;
     fragColor = inColor;
     fragTextCoord = inTextCoordinate;
-    fragNormal = inNormal;
-    fragPosition = vec3(ubo.model * vec4(inPosition, 1.0));
+    fragNormal = DecodeOctahedral(inNormal);
+    fragPosition = vec3(worldPosition);
 }
@@ -0,0 +1,869 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+
+#include <Utils/ThreadPool.h>
+
+namespace Lucid::Core
+{
+
+namespace
+{
+
+struct Bin
+{
+    Aabb bounds;
+    std::uint32_t count = 0;
+};
+
+using Bins = std::array<std::array<Bin, Bvh::BinCount>, 3>;
+
+// Of visiting an inner node, relative to testing one item box
+const float TraversalCost = 1.0f;
+
+// Depth stays below MaxSahDepth plus 32 median splits
+const std::size_t StackSize = 128;
+
+const float Miss = std::numeric_limits<float>::max();
+
+enum class Containment
+{
+    Outside,
+    Intersecting,
+    Inside
+};
+
+Containment
+Classify(const Frustum& frustum, const Aabb& box)
+{
+    Containment result = Containment::Inside;
+
+    for (const glm::vec4& plane : frustum.GetPlanes())
+    {
+        // Corners furthest along and against the plane normal
+        glm::vec3 positive(
+            plane.x >= 0.0f ? box.max.x : box.min.x,
+            plane.y >= 0.0f ? box.max.y : box.min.y,
+            plane.z >= 0.0f ? box.max.z : box.min.z);
+        glm::vec3 negative(
+            plane.x >= 0.0f ? box.min.x : box.max.x,
+            plane.y >= 0.0f ? box.min.y : box.max.y,
+            plane.z >= 0.0f ? box.min.z : box.max.z);
+
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+        {
+            return Containment::Outside;
+        }
+
+        if (glm::dot(glm::vec3(plane), negative) + plane.w < 0.0f)
+        {
+            result = Containment::Intersecting;
+        }
+    }
+
+    return result;
+}
+
+bool
+Contains(const Aabb& outer, const Aabb& inner)
+{
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z
+        && inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+}
+
+// Distance along the ray to where it enters the box, Miss when that is past maxDistance
+float
+Enter(const Aabb& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+{
+    if (box.IsEmpty())
+    {
+        return Miss;
+    }
+
+    glm::vec3 toMin = (box.min - origin) * inverseDirection;
+    glm::vec3 toMax = (box.max - origin) * inverseDirection;
+    glm::vec3 low = glm::min(toMin, toMax);
+    glm::vec3 high = glm::max(toMin, toMax);
+
+    float enter = std::max({ low.x, low.y, low.z, 0.0f });
+    float exit = std::min({ high.x, high.y, high.z, maxDistance });
+
+    return enter <= exit ? enter : Miss;
+}
+
+} // namespace
+
+void
+Aabb::Grow(const glm::vec3& point)
+{
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+}
+
+void
+Aabb::Grow(const Aabb& box)
+{
+    min = glm::min(min, box.min);
+    max = glm::max(max, box.max);
+}
+
+bool
+Aabb::IsEmpty() const
+{
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+glm::vec3
+Aabb::GetCenter() const
+{
+    return IsEmpty() ? glm::vec3(0.0f) : (min + max) * 0.5f;
+}
+
+float
+Aabb::GetSurfaceArea() const
+{
+    if (IsEmpty())
+    {
+        return 0.0f;
+    }
+
+    glm::vec3 extent = max - min;
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+bool
+Aabb::Intersects(const Aabb& box) const
+{
+    return min.x <= box.max.x && box.min.x <= max.x && min.y <= box.max.y && box.min.y <= max.y
+        && min.z <= box.max.z && box.min.z <= max.z;
+}
+
+float
+Aabb::GetDistanceSquared(const glm::vec3& point) const
+{
+    if (IsEmpty())
+    {
+        return Miss;
+    }
+
+    glm::vec3 outside = glm::max(glm::max(min - point, point - max), glm::vec3(0.0f));
+    return glm::dot(outside, outside);
+}
+
+Aabb
+Aabb::Transformed(const glm::mat4& transform) const
+{
+    if (IsEmpty())
+    {
+        return *this;
+    }
+
+    // Each matrix element moves one side of the box by the smaller or larger of its products with the extremes
+    Aabb result;
+    result.min = glm::vec3(transform[3]);
+    result.max = result.min;
+
+    for (glm::length_t column = 0; column < 3; column++)
+    {
+        for (glm::length_t row = 0; row < 3; row++)
+        {
+            float a = transform[column][row] * min[column];
+            float b = transform[column][row] * max[column];
+            result.min[row] += std::min(a, b);
+            result.max[row] += std::max(a, b);
+        }
+    }
+
+    return result;
+}
+
+void
+Bvh::Build(std::span<const Aabb> bounds)
+{
+    mNodes.clear();
+    mItems.clear();
+    mBounds.clear();
+
+    if (bounds.empty())
+    {
+        return;
+    }
+
+    if (bounds.size() > std::numeric_limits<std::uint32_t>::max() / 2)
+    {
+        throw std::runtime_error("Can't build a BVH over " + std::to_string(bounds.size()) + " items");
+    }
+
+    auto count = static_cast<std::uint32_t>(bounds.size());
+    ThreadPool& pool = ThreadPool::Instance();
+
+    std::vector<Reference> references(count);
+    std::mutex mutex;
+    Aabb root;
+
+    pool.ParallelFor(
+        count,
+        [&](std::size_t begin, std::size_t end)
+        {
+            Aabb partial;
+            for (std::size_t i = begin; i < end; i++)
+            {
+                references[i].bounds = bounds[i];
+                references[i].center = bounds[i].GetCenter();
+                references[i].item = static_cast<std::uint32_t>(i);
+                partial.Grow(bounds[i]);
+            }
+
+            std::lock_guard lock(mutex);
+            root.Grow(partial);
+        },
+        ParallelThreshold);
+
+    // A binary tree over count leaves at most
+    mNodes.resize(2 * static_cast<std::size_t>(count) - 1);
+    mNodes[0].bounds = root;
+
+    std::atomic<std::uint32_t> nodeCount = 1;
+    BuildNode(references, nodeCount, 0, 0, count, 0);
+    mNodes.resize(nodeCount);
+
+    mItems.resize(count);
+    mBounds.resize(count);
+    pool.ParallelFor(
+        count,
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                mItems[i] = references[i].item;
+                mBounds[i] = references[i].bounds;
+            }
+        },
+        ParallelThreshold);
+}
+
+void
+Bvh::BuildNode(
+    std::span<Reference> references,
+    std::atomic<std::uint32_t>& nodeCount,
+    std::uint32_t index,
+    std::uint32_t begin,
+    std::uint32_t end,
+    std::size_t depth)
+{
+    std::uint32_t count = end - begin;
+    mNodes[index].first = begin;
+    mNodes[index].count = count;
+
+    if (count == 1)
+    {
+        return;
+    }
+
+    ThreadPool& pool = ThreadPool::Instance();
+    std::span<Reference> items = references.subspan(begin, count);
+    std::mutex mutex;
+
+    // Only large ranges are worth the thread pool
+    bool parallel = count >= ParallelThreshold;
+
+    // Bins split the bounds of the item centers evenly, small nodes get fewer of them
+    Aabb centroids;
+    if (parallel)
+    {
+        pool.ParallelFor(
+            count,
+            [&](std::size_t first, std::size_t last)
+            {
+                Aabb partial;
+                for (std::size_t i = first; i < last; i++)
+                {
+                    partial.Grow(items[i].center);
+                }
+
+                std::lock_guard lock(mutex);
+                centroids.Grow(partial);
+            },
+            ParallelThreshold);
+    }
+    else
+    {
+        for (const Reference& reference : items)
+        {
+            centroids.Grow(reference.center);
+        }
+    }
+
+    std::size_t binCount = std::min<std::size_t>(BinCount, count);
+    glm::vec3 extent = centroids.max - centroids.min;
+    glm::vec3 scale(0.0f);
+
+    for (glm::length_t axis = 0; axis < 3; axis++)
+    {
+        if (extent[axis] > 0.0f)
+        {
+            scale[axis] = static_cast<float>(binCount) * 0.9999f / extent[axis];
+        }
+    }
+
+    auto binOf = [&](const Reference& reference, glm::length_t axis)
+    {
+        auto bin = static_cast<std::size_t>((reference.center[axis] - centroids.min[axis]) * scale[axis]);
+        return std::min(bin, binCount - 1);
+    };
+
+    auto binItems = [&](std::size_t first, std::size_t last, Bins& target)
+    {
+        for (std::size_t i = first; i < last; i++)
+        {
+            for (glm::length_t axis = 0; axis < 3; axis++)
+            {
+                Bin& bin = target[static_cast<std::size_t>(axis)][binOf(items[i], axis)];
+                bin.bounds.Grow(items[i].bounds);
+                bin.count++;
+            }
+        }
+    };
+
+    Bins bins;
+    if (parallel)
+    {
+        pool.ParallelFor(
+            count,
+            [&](std::size_t first, std::size_t last)
+            {
+                Bins partial;
+                binItems(first, last, partial);
+
+                std::lock_guard lock(mutex);
+                for (std::size_t axis = 0; axis < 3; axis++)
+                {
+                    for (std::size_t i = 0; i < binCount; i++)
+                    {
+                        bins[axis][i].bounds.Grow(partial[axis][i].bounds);
+                        bins[axis][i].count += partial[axis][i].count;
+                    }
+                }
+            },
+            ParallelThreshold);
+    }
+    else
+    {
+        binItems(0, count, bins);
+    }
+
+    // Sweep every axis for the split between bins with the lowest surface area cost
+    float bestCost = Miss;
+    glm::length_t bestAxis = 0;
+    std::size_t bestSplit = 0;
+    Aabb left;
+    Aabb right;
+
+    for (glm::length_t axis = 0; axis < 3 && depth < MaxSahDepth; axis++)
+    {
+        if (scale[axis] == 0.0f)
+        {
+            continue;
+        }
+
+        const std::array<Bin, BinCount>& axisBins = bins[static_cast<std::size_t>(axis)];
+        std::array<float, BinCount> leftCosts;
+        std::array<std::uint32_t, BinCount> leftCounts;
+        Bin accumulated;
+
+        for (std::size_t i = 0; i + 1 < binCount; i++)
+        {
+            accumulated.bounds.Grow(axisBins[i].bounds);
+            accumulated.count += axisBins[i].count;
+            leftCosts[i] = accumulated.bounds.GetSurfaceArea() * static_cast<float>(accumulated.count);
+            leftCounts[i] = accumulated.count;
+        }
+
+        Bin suffix;
+        for (std::size_t i = binCount - 1; i > 0; i--)
+        {
+            suffix.bounds.Grow(axisBins[i].bounds);
+            suffix.count += axisBins[i].count;
+
+            if (leftCounts[i - 1] == 0 || suffix.count == 0)
+            {
+                continue;
+            }
+
+            float cost = leftCosts[i - 1] + suffix.bounds.GetSurfaceArea() * static_cast<float>(suffix.count);
+
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = i;
+                right = suffix.bounds;
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < bestSplit; i++)
+    {
+        left.Grow(bins[static_cast<std::size_t>(bestAxis)][i].bounds);
+    }
+
+    float area = mNodes[index].bounds.GetSurfaceArea();
+    bool found = bestCost < Miss;
+
+    if (count <= MaxLeafSize && (!found || TraversalCost * area + bestCost >= static_cast<float>(count) * area))
+    {
+        return;
+    }
+
+    std::uint32_t middle = begin + count / 2;
+
+    if (found)
+    {
+        auto partition = std::partition(
+            items.begin(),
+            items.end(),
+            [&](const Reference& reference) { return binOf(reference, bestAxis) < bestSplit; });
+        middle = begin + static_cast<std::uint32_t>(partition - items.begin());
+    }
+    else
+    {
+        // Too deep or every center in one place, halve along the widest spread of centers
+        glm::length_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        std::nth_element(
+            items.begin(),
+            items.begin() + count / 2,
+            items.end(),
+            [axis](const Reference& a, const Reference& b) { return a.center[axis] < b.center[axis]; });
+
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            (i < count / 2 ? left : right).Grow(items[i].bounds);
+        }
+    }
+
+    std::uint32_t children = nodeCount.fetch_add(2);
+    mNodes[children].bounds = left;
+    mNodes[children + 1].bounds = right;
+    mNodes[index].first = children;
+    mNodes[index].count = 0;
+
+    auto buildChild = [&](std::size_t child)
+    {
+        if (child == 0)
+        {
+            BuildNode(references, nodeCount, children, begin, middle, depth + 1);
+        }
+        else
+        {
+            BuildNode(references, nodeCount, children + 1, middle, end, depth + 1);
+        }
+    };
+
+    if (parallel)
+    {
+        pool.ParallelFor(
+            2,
+            [&](std::size_t first, std::size_t last)
+            {
+                for (std::size_t child = first; child < last; child++)
+                {
+                    buildChild(child);
+                }
+            });
+    }
+    else
+    {
+        buildChild(0);
+        buildChild(1);
+    }
+}
+
+void
+Bvh::Refit(std::span<const Aabb> bounds)
+{
+    if (bounds.size() != mItems.size())
+    {
+        throw std::runtime_error("Can't refit a BVH built over a different item count");
+    }
+
+    ThreadPool& pool = ThreadPool::Instance();
+
+    pool.ParallelFor(
+        mItems.size(),
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                mBounds[i] = bounds[mItems[i]];
+            }
+        },
+        ParallelThreshold);
+
+    pool.ParallelFor(
+        mNodes.size(),
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                Node& node = mNodes[i];
+                if (node.count == 0)
+                {
+                    continue;
+                }
+
+                node.bounds = Aabb();
+                for (std::uint32_t item = node.first; item < node.first + node.count; item++)
+                {
+                    node.bounds.Grow(mBounds[item]);
+                }
+            }
+        },
+        ParallelThreshold);
+
+    // Children follow their parents, walking backwards visits them first
+    for (std::size_t i = mNodes.size(); i-- > 0;)
+    {
+        Node& node = mNodes[i];
+        if (node.count == 0)
+        {
+            node.bounds = mNodes[node.first].bounds;
+            node.bounds.Grow(mNodes[node.first + 1].bounds);
+        }
+    }
+}
+
+void
+Bvh::QueryFrustum(const Frustum& frustum, std::vector<std::uint32_t>& result) const
+{
+    result.clear();
+
+    if (mNodes.empty())
+    {
+        return;
+    }
+
+    std::array<std::uint32_t, StackSize> stack;
+    std::size_t size = 0;
+    stack[size++] = 0;
+
+    while (size > 0)
+    {
+        std::uint32_t index = stack[--size];
+        const Node& node = mNodes[index];
+
+        Containment containment = Classify(frustum, node.bounds);
+        if (containment == Containment::Outside)
+        {
+            continue;
+        }
+
+        if (containment == Containment::Inside)
+        {
+            AppendSubtree(index, result);
+        }
+        else if (node.count == 0)
+        {
+            stack[size++] = node.first;
+            stack[size++] = node.first + 1;
+        }
+        else
+        {
+            for (std::uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                if (Classify(frustum, mBounds[i]) != Containment::Outside)
+                {
+                    result.push_back(mItems[i]);
+                }
+            }
+        }
+    }
+}
+
+void
+Bvh::QueryAabb(const Aabb& box, std::vector<std::uint32_t>& result) const
+{
+    result.clear();
+
+    if (mNodes.empty())
+    {
+        return;
+    }
+
+    std::array<std::uint32_t, StackSize> stack;
+    std::size_t size = 0;
+    stack[size++] = 0;
+
+    while (size > 0)
+    {
+        std::uint32_t index = stack[--size];
+        const Node& node = mNodes[index];
+
+        if (!box.Intersects(node.bounds))
+        {
+            continue;
+        }
+
+        if (Contains(box, node.bounds))
+        {
+            AppendSubtree(index, result);
+        }
+        else if (node.count == 0)
+        {
+            stack[size++] = node.first;
+            stack[size++] = node.first + 1;
+        }
+        else
+        {
+            for (std::uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                if (box.Intersects(mBounds[i]))
+                {
+                    result.push_back(mItems[i]);
+                }
+            }
+        }
+    }
+}
+
+void
+Bvh::QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<Hit>& result) const
+{
+    result.clear();
+
+    if (mNodes.empty())
+    {
+        return;
+    }
+
+    glm::vec3 inverseDirection = glm::vec3(1.0f) / direction;
+
+    std::array<std::uint32_t, StackSize> stack;
+    std::size_t size = 0;
+    stack[size++] = 0;
+
+    while (size > 0)
+    {
+        const Node& node = mNodes[stack[--size]];
+
+        if (Enter(node.bounds, origin, inverseDirection, maxDistance) == Miss)
+        {
+            continue;
+        }
+
+        if (node.count == 0)
+        {
+            stack[size++] = node.first;
+            stack[size++] = node.first + 1;
+            continue;
+        }
+
+        for (std::uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+            if (float distance = Enter(mBounds[i], origin, inverseDirection, maxDistance); distance != Miss)
+            {
+                Hit hit;
+                hit.item = mItems[i];
+                hit.distance = distance;
+                result.push_back(hit);
+            }
+        }
+    }
+
+    std::sort(
+        result.begin(), result.end(), [](const Hit& a, const Hit& b) { return a.distance < b.distance; });
+}
+
+std::optional<Bvh::Hit>
+Bvh::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+{
+    std::optional<Hit> best;
+
+    if (mNodes.empty())
+    {
+        return best;
+    }
+
+    glm::vec3 inverseDirection = glm::vec3(1.0f) / direction;
+
+    // Nodes with their entry distance, the nearer child is visited first and bounds the farther one
+    std::array<std::pair<std::uint32_t, float>, StackSize> stack;
+    std::size_t size = 0;
+
+    if (float distance = Enter(mNodes[0].bounds, origin, inverseDirection, maxDistance); distance != Miss)
+    {
+        stack[size++] = { 0, distance };
+    }
+
+    while (size > 0)
+    {
+        auto [index, entry] = stack[--size];
+        if (entry > maxDistance)
+        {
+            continue;
+        }
+
+        const Node& node = mNodes[index];
+
+        if (node.count == 0)
+        {
+            float leftEntry = Enter(mNodes[node.first].bounds, origin, inverseDirection, maxDistance);
+            float rightEntry = Enter(mNodes[node.first + 1].bounds, origin, inverseDirection, maxDistance);
+
+            std::pair<std::uint32_t, float> closer = { node.first, leftEntry };
+            std::pair<std::uint32_t, float> further = { node.first + 1, rightEntry };
+            if (rightEntry < leftEntry)
+            {
+                std::swap(closer, further);
+            }
+
+            if (further.second != Miss)
+            {
+                stack[size++] = further;
+            }
+
+            if (closer.second != Miss)
+            {
+                stack[size++] = closer;
+            }
+
+            continue;
+        }
+
+        for (std::uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+            if (float distance = Enter(mBounds[i], origin, inverseDirection, maxDistance); distance != Miss)
+            {
+                Hit hit;
+                hit.item = mItems[i];
+                hit.distance = distance;
+                best = hit;
+                maxDistance = distance;
+            }
+        }
+    }
+
+    return best;
+}
+
+void
+Bvh::QueryNearest(const glm::vec3& point, std::size_t count, std::vector<Hit>& result) const
+{
+    result.clear();
+
+    if (mNodes.empty() || count == 0)
+    {
+        return;
+    }
+
+    // Nodes nearest first, results with the farthest on top until there are count of them
+    using Candidate = std::pair<float, std::uint32_t>;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> nodes;
+    auto farther = [](const Hit& a, const Hit& b) { return a.distance < b.distance; };
+    auto limit = [&]() { return result.size() < count ? Miss : result.front().distance; };
+
+    nodes.push({ mNodes[0].bounds.GetDistanceSquared(point), 0 });
+
+    while (!nodes.empty())
+    {
+        auto [distance, index] = nodes.top();
+        nodes.pop();
+
+        if (distance >= limit())
+        {
+            break;
+        }
+
+        const Node& node = mNodes[index];
+
+        if (node.count == 0)
+        {
+            for (std::uint32_t child = node.first; child < node.first + 2; child++)
+            {
+                if (float childDistance = mNodes[child].bounds.GetDistanceSquared(point); childDistance < limit())
+                {
+                    nodes.push({ childDistance, child });
+                }
+            }
+
+            continue;
+        }
+
+        for (std::uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+            float itemDistance = mBounds[i].GetDistanceSquared(point);
+            if (itemDistance >= limit())
+            {
+                continue;
+            }
+
+            if (result.size() == count)
+            {
+                std::pop_heap(result.begin(), result.end(), farther);
+                result.pop_back();
+            }
+
+            Hit hit;
+            hit.item = mItems[i];
+            hit.distance = itemDistance;
+            result.push_back(hit);
+            std::push_heap(result.begin(), result.end(), farther);
+        }
+    }
+
+    std::sort_heap(result.begin(), result.end(), farther);
+
+    for (Hit& hit : result)
+    {
+        hit.distance = std::sqrt(hit.distance);
+    }
+}
+
+std::size_t
+Bvh::GetItemCount() const
+{
+    return mItems.size();
+}
+
+std::size_t
+Bvh::GetNodeCount() const
+{
+    return mNodes.size();
+}
+
+Aabb
+Bvh::GetBounds() const
+{
+    return mNodes.empty() ? Aabb() : mNodes[0].bounds;
+}
+
+void
+Bvh::AppendSubtree(std::uint32_t index, std::vector<std::uint32_t>& result) const
+{
+    std::uint32_t first = index;
+    while (mNodes[first].count == 0)
+    {
+        first = mNodes[first].first;
+    }
+
+    std::uint32_t last = index;
+    while (mNodes[last].count == 0)
+    {
+        last = mNodes[last].first + 1;
+    }
+
+    for (std::uint32_t i = mNodes[first].first; i < mNodes[last].first + mNodes[last].count; i++)
+    {
+        if (!mBounds[i].IsEmpty())
+        {
+            result.push_back(mItems[i]);
+        }
+    }
+}
+
+} // namespace Lucid::Core
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <Core/Frustum.h>
+
+namespace Lucid::Core
+{
+
+// Axis aligned box, empty until grown
+struct Aabb
+{
+    glm::vec3 min { std::numeric_limits<float>::max() };
+    glm::vec3 max { std::numeric_limits<float>::lowest() };
+
+    void Grow(const glm::vec3& point);
+    void Grow(const Aabb& box);
+
+    [[nodiscard]] bool IsEmpty() const;
+    [[nodiscard]] glm::vec3 GetCenter() const;
+    [[nodiscard]] float GetSurfaceArea() const;
+    [[nodiscard]] bool Intersects(const Aabb& box) const;
+
+    // Zero inside the box
+    [[nodiscard]] float GetDistanceSquared(const glm::vec3& point) const;
+
+    // Box around the transformed corners
+    [[nodiscard]] Aabb Transformed(const glm::mat4& transform) const;
+};
+
+/*
+        Bounding volume hierarchy over caller indexed boxes, built top down with a binned surface area heuristic.
+        Subtrees of at least ParallelThreshold items are split and built on the thread pool.
+        Refit keeps the topology and only regrows the node bounds, which is cheap but loosens the tree
+        as items move away from where they were when it was built.
+*/
+class Bvh
+{
+public:
+    static const std::size_t BinCount = 16;
+    static const std::size_t MaxLeafSize = 4;
+    static const std::size_t ParallelThreshold = 16384;
+
+    struct Hit
+    {
+        std::uint32_t item = 0;
+        float distance = 0.0f; // Along the ray, or from the query point
+    };
+
+    // Items are indices into bounds, empty boxes are kept but never reported
+    void Build(std::span<const Aabb> bounds);
+
+    // Bounds of the same items the tree was built over
+    void Refit(std::span<const Aabb> bounds);
+
+    // Queries replace the contents of result
+    void QueryFrustum(const Frustum& frustum, std::vector<std::uint32_t>& result) const;
+    void QueryAabb(const Aabb& box, std::vector<std::uint32_t>& result) const;
+
+    // Every item box the ray enters before maxDistance, nearest first
+    void QueryRay(
+        const glm::vec3& origin,
+        const glm::vec3& direction,
+        float maxDistance,
+        std::vector<Hit>& result) const;
+
+    // Nearest item box the ray enters, distances are zero from inside a box
+    [[nodiscard]] std::optional<Hit> Raycast(
+        const glm::vec3& origin,
+        const glm::vec3& direction,
+        float maxDistance = std::numeric_limits<float>::max()) const;
+
+    // Up to count items by distance from point to their boxes, nearest first
+    void QueryNearest(const glm::vec3& point, std::size_t count, std::vector<Hit>& result) const;
+
+    [[nodiscard]] std::size_t GetItemCount() const;
+    [[nodiscard]] std::size_t GetNodeCount() const;
+
+    // Empty without items
+    [[nodiscard]] Aabb GetBounds() const;
+
+private:
+    struct Node
+    {
+        Aabb bounds;
+        std::uint32_t first = 0; // Left child of inner nodes, the right one follows it, or first item of leaves
+        std::uint32_t count = 0; // Items of leaves, zero for inner nodes
+    };
+
+    // Copy of an item partitioned by the build, so every node reads its items sequentially
+    struct Reference
+    {
+        Aabb bounds;
+        glm::vec3 center { 0.0f };
+        std::uint32_t item = 0;
+    };
+
+    // Deeper nodes split at the median, which bounds the depth of skewed inputs for the query stacks
+    static const std::size_t MaxSahDepth = 64;
+
+    void BuildNode(
+        std::span<Reference> references,
+        std::atomic<std::uint32_t>& nodeCount,
+        std::uint32_t index,
+        std::uint32_t begin,
+        std::uint32_t end,
+        std::size_t depth);
+
+    // Leaves cover consecutive items, so do subtrees
+    void AppendSubtree(std::uint32_t index, std::vector<std::uint32_t>& result) const;
+
+    std::vector<Node> mNodes; // Children always follow their parent
+    std::vector<std::uint32_t> mItems; // Grouped by leaf
+    std::vector<Aabb> mBounds; // Per entry of mItems
+};
+
+} // namespace Lucid::Core
@@ -0,0 +1,106 @@
+#include "DepthPyramid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Lucid::Core
+{
+
+DepthPyramid::DepthPyramid(std::uint32_t width, std::uint32_t height)
+    : mWidth(std::max(width, 1u))
+    , mHeight(std::max(height, 1u))
+{
+    std::uint32_t levelWidth = mWidth;
+    std::uint32_t levelHeight = mHeight;
+    std::size_t offset = 0;
+
+    do
+    {
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+
+        Level level;
+        level.width = levelWidth;
+        level.height = levelHeight;
+        level.offset = offset;
+        mLevels.push_back(level);
+
+        offset += std::size_t(levelWidth) * levelHeight;
+    } while (levelWidth > 1 || levelHeight > 1);
+
+    mDepths.assign(offset, 1.0f);
+}
+
+const std::vector<DepthPyramid::Level>&
+DepthPyramid::GetLevels() const
+{
+    return mLevels;
+}
+
+std::span<float>
+DepthPyramid::GetDepths()
+{
+    return mDepths;
+}
+
+bool
+DepthPyramid::IsOccluded(const glm::vec4& sphere, const glm::mat4& viewProjection) const
+{
+    glm::vec3 center(sphere);
+    glm::vec3 minimum(std::numeric_limits<float>::max());
+    glm::vec3 maximum(std::numeric_limits<float>::lowest());
+
+    // Screen rectangle and nearest depth of the bounding box corners
+    for (std::uint32_t corner = 0; corner < 8; corner++)
+    {
+        glm::vec3 offset((corner & 1u) ? sphere.w : -sphere.w,
+                         (corner & 2u) ? sphere.w : -sphere.w,
+                         (corner & 4u) ? sphere.w : -sphere.w);
+
+        glm::vec4 clip = viewProjection * glm::vec4(center + offset, 1.0f);
+        if (clip.w <= 0.0f || clip.z < 0.0f)
+        {
+            return false;
+        }
+
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        minimum = glm::min(minimum, ndc);
+        maximum = glm::max(maximum, ndc);
+    }
+
+    // Pixels of the rectangle, the viewport maps -1 to the first row and column
+    auto toPixels = [](float ndc, std::uint32_t size)
+    { return std::clamp((ndc * 0.5f + 0.5f) * static_cast<float>(size), 0.0f, static_cast<float>(size - 1)); };
+
+    float fromX = toPixels(minimum.x, mWidth);
+    float fromY = toPixels(minimum.y, mHeight);
+    float toX = toPixels(maximum.x, mWidth);
+    float toY = toPixels(maximum.y, mHeight);
+
+    // The first level whose texels are at least as large as the rectangle, it then spans at most 2x2 texels
+    float extent = std::max({ toX - fromX, toY - fromY, 1.0f });
+    auto index = static_cast<std::size_t>(std::max(std::ceil(std::log2(extent)) - 1.0f, 0.0f));
+    index = std::min(index, mLevels.size() - 1);
+
+    const Level& level = mLevels[index];
+    float texelSize = std::exp2(static_cast<float>(index + 1));
+
+    auto firstX = static_cast<std::uint32_t>(fromX / texelSize);
+    auto firstY = static_cast<std::uint32_t>(fromY / texelSize);
+    auto lastX = std::min(static_cast<std::uint32_t>(toX / texelSize), level.width - 1);
+    auto lastY = std::min(static_cast<std::uint32_t>(toY / texelSize), level.height - 1);
+
+    float farthest = 0.0f;
+    for (std::uint32_t y = firstY; y <= lastY; y++)
+    {
+        for (std::uint32_t x = firstX; x <= lastX; x++)
+        {
+            farthest = std::max(farthest, mDepths[level.offset + std::size_t(y) * level.width + x]);
+        }
+    }
+
+    return minimum.z > farthest;
+}
+
+} // namespace Lucid::Core
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+namespace Lucid::Core
+{
+
+/*
+        Farthest depth over a halving chain of the screen, level 0 at half resolution.
+        Texel t of a level covers texels 2t and 2t + 1 of the level below, sizes round up so edges stay covered.
+        Depths are zero to one with far at one, as cleared by the render pass.
+*/
+class DepthPyramid
+{
+public:
+    struct Level
+    {
+        std::uint32_t width = 0;
+        std::uint32_t height = 0;
+        std::size_t offset = 0; // Into GetDepths(), row major
+    };
+
+    DepthPyramid(std::uint32_t width, std::uint32_t height);
+
+    [[nodiscard]] const std::vector<Level>& GetLevels() const;
+
+    // Every level one after another, initially far
+    [[nodiscard]] std::span<float> GetDepths();
+
+    /*
+            True when the screen bounds of the sphere lie behind the farthest depth under them.
+            Spheres crossing the near plane never count as occluded.
+    */
+    [[nodiscard]] bool IsOccluded(const glm::vec4& sphere, const glm::mat4& viewProjection) const;
+
+private:
+    std::uint32_t mWidth = 0;
+    std::uint32_t mHeight = 0;
+    std::vector<Level> mLevels;
+    std::vector<float> mDepths;
+};
+
+} // namespace Lucid::Core
@@ -1,5 +1,7 @@
 #include "Engine.h"
 
+#include <chrono>
+
 #include <Core/InputController.h>
 #include <Utils/Files.h>
 #include <Utils/Logger.hpp>
@@ -12,6 +14,8 @@ namespace Lucid::Core
 
 Engine::Engine(const IWindow& window, API api)
 {
+    auto start = std::chrono::steady_clock::now();
+
     mScene = std::make_shared<Lucid::Core::Scene>();
 
     auto camera = std::make_shared<Lucid::Core::Camera>(
@@ -24,6 +28,9 @@ Engine::Engine(const IWindow& window, API api)
         mRender = std::make_unique<Lucid::Vulkan::VulkanRender>(window, *mScene.get());
         break;
     }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LoggerInfo << "Engine initialized in " << elapsed.count() << " ms";
 }
 
 void
@@ -87,6 +94,12 @@ Engine::ProcessInput(float time)
 void
 Engine::ProcessDirtyNodes()
 {
+    // Dirty nodes may have moved, culling reads their bounds from the scene hierarchy
+    if (!mDirtyNodes.empty())
+    {
+        mScene->RefitBounds();
+    }
+
     for (const std::size_t id : mDirtyNodes)
     {
         const Core::SceneNodePtr& node = mScene->GetNodeById(id);
@@ -0,0 +1,45 @@
+#include "Frustum.h"
+
+namespace Lucid::Core
+{
+
+Frustum::Frustum(const glm::mat4& matrix)
+{
+    auto row = [&matrix](glm::length_t i) { return glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]); };
+
+    mPlanes = {
+        row(3) + row(0), // Left
+        row(3) - row(0), // Right
+        row(3) + row(1), // Bottom
+        row(3) - row(1), // Top
+        row(2), // Near
+        row(3) - row(2), // Far
+    };
+
+    for (glm::vec4& plane : mPlanes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+bool
+Frustum::IsOutside(const glm::vec4& sphere) const
+{
+    for (const glm::vec4& plane : mPlanes)
+    {
+        if (glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w < -sphere.w)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const std::array<glm::vec4, 6>&
+Frustum::GetPlanes() const
+{
+    return mPlanes;
+}
+
+} // namespace Lucid::Core
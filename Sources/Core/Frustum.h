@@ -0,0 +1,27 @@
+#pragma once
+
+#include <array>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+namespace Lucid::Core
+{
+
+// Clip space planes of a projection with zero to one depth, in the space the matrix transforms from
+class Frustum
+{
+public:
+    Frustum(const glm::mat4& matrix);
+
+    // Conservative, spheres crossing a corner outside of all planes still count as visible
+    [[nodiscard]] bool IsOutside(const glm::vec4& sphere) const;
+
+    [[nodiscard]] const std::array<glm::vec4, 6>& GetPlanes() const;
+
+private:
+    std::array<glm::vec4, 6> mPlanes; // Normalized, facing inwards
+};
+
+} // namespace Lucid::Core
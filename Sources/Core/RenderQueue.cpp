@@ -0,0 +1,76 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+namespace Lucid::Core
+{
+
+std::uint64_t
+RenderQueue::MakeKey(std::uint32_t pipeline, std::uint32_t material, float depth, std::uint32_t geometry)
+{
+    // Positive floats order like their bit patterns, dropping low mantissa bits keeps the order with less precision
+    auto depthBits = std::bit_cast<std::uint32_t>(std::max(depth, 0.0f)) >> 8;
+
+    return (std::uint64_t(pipeline & 0xFFu) << 56) | (std::uint64_t(material & 0xFFFFu) << 40)
+        | (std::uint64_t(depthBits & 0xFFFFFFu) << 16) | std::uint64_t(geometry & 0xFFFFu);
+}
+
+void
+RenderQueue::Clear()
+{
+    mItems.clear();
+}
+
+void
+RenderQueue::Push(std::uint64_t key, std::uint32_t index)
+{
+    Item item;
+    item.key = key;
+    item.index = index;
+    mItems.push_back(item);
+}
+
+void
+RenderQueue::Sort()
+{
+    mScratch.resize(mItems.size());
+
+    for (std::uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        std::array<std::size_t, 256> counts {};
+        for (const Item& item : mItems)
+        {
+            counts[(item.key >> shift) & 0xFFu]++;
+        }
+
+        if (std::find(counts.begin(), counts.end(), mItems.size()) != counts.end())
+        {
+            continue;
+        }
+
+        std::size_t offset = 0;
+        for (std::size_t& count : counts)
+        {
+            std::size_t bucket = count;
+            count = offset;
+            offset += bucket;
+        }
+
+        for (const Item& item : mItems)
+        {
+            mScratch[counts[(item.key >> shift) & 0xFFu]++] = item;
+        }
+
+        mItems.swap(mScratch);
+    }
+}
+
+const std::vector<RenderQueue::Item>&
+RenderQueue::GetItems() const
+{
+    return mItems;
+}
+
+} // namespace Lucid::Core
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Lucid::Core
+{
+
+/*
+        Per frame list of draws ordered by a 64 bit key, most significant fields first:
+        pipeline (8 bits), material (16 bits), quantized view depth (24 bits) and geometry (16 bits).
+        Sorting groups draws by state and orders them front to back within a material for early depth rejection.
+*/
+class RenderQueue
+{
+public:
+    struct Item
+    {
+        std::uint64_t key = 0;
+        std::uint32_t index = 0; // Caller defined, usually into the list of drawables
+    };
+
+    // Fields wider than their slot are truncated, negative depths count as zero
+    [[nodiscard]] static std::uint64_t
+    MakeKey(std::uint32_t pipeline, std::uint32_t material, float depth, std::uint32_t geometry);
+
+    void Clear();
+    void Push(std::uint64_t key, std::uint32_t index);
+
+    // Stable LSD radix sort by key, byte passes shared by every key are skipped
+    void Sort();
+
+    [[nodiscard]] const std::vector<Item>& GetItems() const;
+
+private:
+    std::vector<Item> mItems;
+    std::vector<Item> mScratch;
+};
+
+} // namespace Lucid::Core
@@ -1,5 +1,9 @@
 #include "Scene.h"
 
+#include <unordered_map>
+
+#include <Utils/ThreadPool.h>
+
 namespace Lucid::Core
 {
 
@@ -10,6 +14,8 @@ Scene::SetRootNode(const SceneNodePtr& node)
 
     // Add all nodes to index
     Traverse([this](const Core::SceneNodePtr& it) { mNodeIndex[it->GetId()] = it; }, GetRootNode());
+
+    BuildBvh();
 }
 
 void
@@ -18,14 +24,18 @@ Scene::AddCamera(const std::shared_ptr<Camera>& entity)
     mCamera = entity;
 }
 
-void
-Scene::Traverse(const std::function<void(const SceneNodePtr&)>& fn, const SceneNodePtr& node) const
+Scene::ChildRange
+Scene::GetChildRange(const SceneNodePtr& node)
 {
-    for (const SceneNodePtr& child : node->GetChildren())
-    {
-        fn(child);
-        Traverse(fn, child);
-    }
+    const std::vector<SceneNodePtr>& children = node->GetChildren();
+    return { children.data(), children.data() + children.size() };
+}
+
+std::vector<Scene::ChildRange>&
+Scene::GetTraversalStack()
+{
+    thread_local std::vector<ChildRange> stack;
+    return stack;
 }
 
 const SceneNodePtr&
@@ -46,4 +56,79 @@ Scene::GetCamera() const
     return mCamera;
 }
 
+const Bvh&
+Scene::GetBvh() const
+{
+    return mBvh;
+}
+
+SceneNodePtr
+Scene::GetBoundedNode(std::uint32_t item) const
+{
+    return mBoundedNodes.at(item).lock();
+}
+
+void
+Scene::RefitBounds()
+{
+    UpdateWorldBounds();
+    mBvh.Refit(mWorldBounds);
+}
+
+void
+Scene::BuildBvh()
+{
+    mBoundedNodes.clear();
+    mLocalBounds.clear();
+
+    // Meshes shared by several nodes are measured once
+    std::unordered_map<const Mesh*, Aabb> meshBounds;
+
+    auto add = [&](const SceneNodePtr& node)
+    {
+        if (!node->GetOptionalMesh().has_value())
+        {
+            return;
+        }
+
+        const Mesh& mesh = *node->GetOptionalMesh().value();
+        auto [it, inserted] = meshBounds.try_emplace(&mesh);
+
+        if (inserted)
+        {
+            for (const Vertex& vertex : mesh.vertices)
+            {
+                it->second.Grow(vertex.position);
+            }
+        }
+
+        mBoundedNodes.push_back(node);
+        mLocalBounds.push_back(it->second);
+    };
+
+    add(mRootNode);
+    Traverse(add, mRootNode);
+
+    UpdateWorldBounds();
+    mBvh.Build(mWorldBounds);
+}
+
+void
+Scene::UpdateWorldBounds()
+{
+    mWorldBounds.resize(mBoundedNodes.size());
+
+    ThreadPool::Instance().ParallelFor(
+        mBoundedNodes.size(),
+        [this](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                SceneNodePtr node = mBoundedNodes[i].lock();
+                mWorldBounds[i] = node != nullptr ? mLocalBounds[i].Transformed(node->GetTransform()) : Aabb();
+            }
+        },
+        Bvh::ParallelThreshold);
+}
+
 } // namespace Lucid::Core
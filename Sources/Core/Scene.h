@@ -1,14 +1,18 @@
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <memory>
+#include <type_traits>
+#include <utility>
 #include <vector>
-#include <functional>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <Core/Bvh.h>
 #include <Core/Camera.h>
 #include <Core/SceneNode.h>
+#include <Utils/ThreadPool.h>
 #include <glm/glm.hpp>
 
 namespace Lucid::Core
@@ -17,20 +21,196 @@ namespace Lucid::Core
 class Scene
 {
 public:
+    // Returned by traversal visitors, visitors returning nothing always continue
+    enum class Visit
+    {
+        Continue, // Into the children of the node
+        Skip, // Over the children of the node
+        Stop // Out of the traversal
+    };
+
     Scene() = default;
 
     void SetRootNode(const SceneNodePtr& node);
     void AddCamera(const std::shared_ptr<Camera>& node);
-    void Traverse(const std::function<void(const SceneNodePtr&)>& fn, const SceneNodePtr& node) const;
+
+    /*
+            Visits the descendants of node depth first, parents before their children.
+            Iterative over a per thread stack that is reused between calls, so deep hierarchies don't overflow
+            and traversals don't allocate. Visitors may traverse again but must not change the children of nodes
+            being traversed. Returns false when a visitor stopped the traversal.
+    */
+    template <typename Visitor> bool Traverse(Visitor&& visitor, const SceneNodePtr& node) const;
+
+    /*
+            Same visits spread over the thread pool, parents still come before their children but the order
+            of siblings is unspecified. Levels are visited on the calling thread until there are enough
+            independent subtrees for every thread, the visitor has to be safe to call concurrently.
+    */
+    template <typename Visitor> bool ParallelTraverse(Visitor&& visitor, const SceneNodePtr& node) const;
 
     const SceneNodePtr& GetRootNode() const;
     SceneNodePtr GetNodeById(std::size_t id) const;
     const std::shared_ptr<Camera>& GetCamera() const;
 
+    /*
+            Hierarchy over the world space bounds of every node with a mesh, built when the root node is set.
+            Its items are resolved with GetBoundedNode, RefitBounds follows transforms changed since.
+    */
+    const Bvh& GetBvh() const;
+    SceneNodePtr GetBoundedNode(std::uint32_t item) const;
+    void RefitBounds();
+
 private:
+    // Children of a node left to visit
+    using ChildRange = std::pair<const SceneNodePtr*, const SceneNodePtr*>;
+
+    template <typename Visitor> static Visit Invoke(Visitor& visitor, const SceneNodePtr& node);
+    static ChildRange GetChildRange(const SceneNodePtr& node);
+    static std::vector<ChildRange>& GetTraversalStack();
+
+    void BuildBvh();
+    void UpdateWorldBounds();
+
     SceneNodePtr mRootNode;
     std::map<std::size_t, SceneNodeWeakPtr> mNodeIndex;
     std::shared_ptr<Camera> mCamera;
+
+    Bvh mBvh;
+    std::vector<SceneNodeWeakPtr> mBoundedNodes;
+    std::vector<Aabb> mLocalBounds; // Per bounded node, of its mesh
+    std::vector<Aabb> mWorldBounds; // Per bounded node
 };
 
+template <typename Visitor>
+Scene::Visit
+Scene::Invoke(Visitor& visitor, const SceneNodePtr& node)
+{
+    if constexpr (std::is_void_v<std::invoke_result_t<Visitor&, const SceneNodePtr&>>)
+    {
+        visitor(node);
+        return Visit::Continue;
+    }
+    else
+    {
+        return visitor(node);
+    }
+}
+
+template <typename Visitor>
+bool
+Scene::Traverse(Visitor&& visitor, const SceneNodePtr& node) const
+{
+    // Nested traversals push above the frames of this one and the guard drops them on exceptions as well
+    std::vector<ChildRange>& stack = GetTraversalStack();
+    std::size_t base = stack.size();
+
+    struct Guard
+    {
+        std::vector<ChildRange>& stack;
+        std::size_t size;
+        ~Guard() { stack.resize(size); }
+    } guard { stack, base };
+
+    stack.push_back(GetChildRange(node));
+
+    while (stack.size() > base)
+    {
+        // Frames are only touched before the visitor runs, nested traversals may reallocate the stack
+        ChildRange& range = stack.back();
+        if (range.first == range.second)
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        const SceneNodePtr& child = *range.first++;
+
+        switch (Invoke(visitor, child))
+        {
+        case Visit::Continue:
+            stack.push_back(GetChildRange(child));
+            break;
+        case Visit::Skip:
+            break;
+        case Visit::Stop:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename Visitor>
+bool
+Scene::ParallelTraverse(Visitor&& visitor, const SceneNodePtr& node) const
+{
+    std::atomic<bool> stopped = false;
+
+    auto visit = [&visitor, &stopped](const SceneNodePtr& it)
+    {
+        if (stopped.load(std::memory_order_relaxed))
+        {
+            return Visit::Stop;
+        }
+
+        Visit result = Invoke(visitor, it);
+        if (result == Visit::Stop)
+        {
+            stopped = true;
+        }
+
+        return result;
+    };
+
+    // Several subtrees per thread even out their sizes
+    ThreadPool& pool = ThreadPool::Instance();
+    std::size_t target = pool.GetThreadCount() * 4;
+
+    std::vector<const SceneNodePtr*> frontier;
+    for (const SceneNodePtr& child : node->GetChildren())
+    {
+        frontier.push_back(&child);
+    }
+
+    while (!frontier.empty() && frontier.size() < target)
+    {
+        std::vector<const SceneNodePtr*> next;
+
+        for (const SceneNodePtr* it : frontier)
+        {
+            switch (visit(*it))
+            {
+            case Visit::Continue:
+                for (const SceneNodePtr& child : (*it)->GetChildren())
+                {
+                    next.push_back(&child);
+                }
+                break;
+            case Visit::Skip:
+                break;
+            case Visit::Stop:
+                return false;
+            }
+        }
+
+        frontier = std::move(next);
+    }
+
+    pool.ParallelFor(
+        frontier.size(),
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                if (visit(*frontier[i]) == Visit::Continue)
+                {
+                    Traverse(visit, *frontier[i]);
+                }
+            }
+        });
+
+    return !stopped;
+}
+
 } // namespace Lucid::Core
@@ -84,4 +84,10 @@ SceneNode::SetMesh(const MeshPtr& mesh)
     mMesh = mesh;
 }
 
+void
+SceneNode::ClearMesh()
+{
+    mMesh.reset();
+}
+
 } // namespace Lucid::Core
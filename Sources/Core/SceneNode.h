@@ -37,6 +37,7 @@ public:
     void AddChildren(SceneNodePtr& node);
     void SetTransform(const glm::mat4& transform);
     void SetMesh(const MeshPtr& mesh);
+    void ClearMesh();
 
 private:
     // Must have fields
@@ -0,0 +1,114 @@
+#include "Types.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Lucid::Core
+{
+
+bool
+Texture::IsCompressed() const
+{
+    return format != TextureFormat::Rgba8Srgb;
+}
+
+bool
+Texture::HasMipChain() const
+{
+    return levelOffsets.size() == mipLevels;
+}
+
+bool
+Texture::IsDecoded() const
+{
+    return decoder == nullptr;
+}
+
+Vector2d<std::uint32_t>
+Texture::LevelSize(std::uint32_t level) const
+{
+    return { std::max(size.x >> level, 1u), std::max(size.y >> level, 1u) };
+}
+
+std::size_t
+Texture::LevelByteSize(std::uint32_t level) const
+{
+    Vector2d<std::uint32_t> levelSize = LevelSize(level);
+
+    // Block compressed formats are stored as 4x4 texel blocks, partial blocks are padded
+    std::size_t blocksX = (levelSize.x + 3) / 4;
+    std::size_t blocksY = (levelSize.y + 3) / 4;
+
+    switch (format)
+    {
+    case TextureFormat::Rgba8Srgb:
+        return static_cast<std::size_t>(levelSize.x) * levelSize.y * 4;
+    case TextureFormat::Bc1Srgb:
+        return blocksX * blocksY * 8;
+    case TextureFormat::Bc7Srgb:
+        return blocksX * blocksY * 16;
+    }
+
+    return 0;
+}
+
+std::size_t
+Texture::StoredByteSize() const
+{
+    if (!HasMipChain())
+    {
+        return LevelByteSize(0) * layers;
+    }
+
+    return levelOffsets.back() + LevelByteSize(mipLevels - 1) * layers;
+}
+
+std::size_t
+Texture::ComputeLevelOffsets()
+{
+    std::size_t totalSize = 0;
+    levelOffsets.clear();
+
+    for (std::uint32_t level = 0; level < mipLevels; level++)
+    {
+        levelOffsets.push_back(totalSize);
+        totalSize += LevelByteSize(level) * layers;
+    }
+
+    return totalSize;
+}
+
+void
+Texture::Decode()
+{
+    if (IsDecoded())
+    {
+        return;
+    }
+
+    pixels.resize(StoredByteSize());
+    decoder(pixels.data());
+    decoder = nullptr;
+}
+
+void
+Texture::DecodeInto(unsigned char* destination) const
+{
+    if (IsDecoded())
+    {
+        std::memcpy(destination, pixels.data(), pixels.size());
+        return;
+    }
+
+    decoder(destination);
+}
+
+bool
+Meshlet::IsBackFacing(const glm::vec3& camera) const
+{
+    // Conservative for every point of the bounding sphere, holds under any affine model transform
+    glm::vec3 direction = glm::vec3(boundingSphere) - camera;
+    return glm::dot(direction, coneAxis) >= coneCutoff * glm::length(direction) + boundingSphere.w;
+}
+
+} // namespace Lucid::Core
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <memory>
@@ -21,20 +22,82 @@ template <typename T> struct Vector2d
     }
 };
 
+enum class TextureFormat
+{
+    Rgba8Srgb,
+    Bc1Srgb,
+    Bc7Srgb
+};
+
 struct Texture
 {
     Vector2d<std::uint32_t> size;
     std::vector<unsigned char> pixels;
     std::uint32_t mipLevels = 1;
+    TextureFormat format = TextureFormat::Rgba8Srgb;
+
+    // Array layers, 6 for cubemaps. Every stored level holds all of its layers back to back
+    std::uint32_t layers = 1;
+
+    // Offsets of every stored mip level inside pixels, empty when only the base level is stored
+    std::vector<std::size_t> levelOffsets;
+
+    // Set by loaders that defer decoding until the destination is known, e.g. mapped staging memory.
+    // Writes every stored level in the same layout pixels would have.
+    std::function<void(unsigned char* destination)> decoder;
+
+    [[nodiscard]] bool IsCompressed() const;
+    [[nodiscard]] bool HasMipChain() const;
+    [[nodiscard]] bool IsDecoded() const;
+    [[nodiscard]] Vector2d<std::uint32_t> LevelSize(std::uint32_t level) const;
+    [[nodiscard]] std::size_t LevelByteSize(std::uint32_t level) const; // Single layer
+    [[nodiscard]] std::size_t StoredByteSize() const;
+
+    // Lays out all mipLevels back to back in levelOffsets and returns the total size
+    std::size_t ComputeLevelOffsets();
+
+    // Fallback for CPU side consumers, runs the decoder into pixels
+    void Decode();
+    void DecodeInto(unsigned char* destination) const;
 };
 
 using TexturePtr = std::shared_ptr<Texture>;
 
+// Simplified triangle list over the vertices of its mesh
+struct MeshLod
+{
+    std::vector<std::uint32_t> indices;
+    float error = 0.0f; // Geometric deviation from the full mesh relative to its bounding radius
+};
+
+// Contiguous run of triangles in the index buffer of its mesh, culled as a whole
+struct Meshlet
+{
+    static const std::uint32_t MaxVertices = 64;
+    static const std::uint32_t MaxTriangles = 124;
+
+    std::uint32_t firstIndex = 0;
+    std::uint32_t indexCount = 0;
+    glm::vec4 boundingSphere { 0.0f }; // Center and radius in mesh space
+    glm::vec3 coneAxis { 0.0f }; // Average facing of the triangles
+    float coneCutoff = 1.0f; // Sine of the normal cone half angle, 1 never rejects the meshlet as back facing
+
+    // Every triangle faces away from a camera at this mesh space position
+    [[nodiscard]] bool IsBackFacing(const glm::vec3& camera) const;
+};
+
 struct Mesh
 {
     std::shared_ptr<Texture> texture;
+    bool doubleSided = false; // Material drawn from both sides, single sided meshes cull their back faces
     std::vector<Vertex> vertices;
     std::vector<std::uint32_t> indices;
+
+    // Coarser levels, ordered from fine to coarse. The full mesh in indices is level 0
+    std::vector<MeshLod> lods;
+
+    // Cover indices in order, empty when the mesh was not split
+    std::vector<Meshlet> meshlets;
 };
 
 using MeshPtr = std::shared_ptr<Mesh>;
@@ -4,6 +4,8 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include <cstdint>
+
 namespace Lucid::Core
 {
 
@@ -15,6 +17,34 @@ struct Vertex
     glm::vec2 uv;
 };
 
+/*
+        GPU side vertex, 20 bytes instead of 44.
+        Position is snorm16 relative to the mesh bounds, the dequantization is folded into the model matrix.
+        Normal is octahedral snorm16, uv is half float and color is unorm8.
+*/
+struct PackedVertex
+{
+    std::uint32_t positionXY;
+    std::uint32_t positionZ;
+    std::uint32_t normal;
+    std::uint32_t uv;
+    std::uint32_t color;
+};
+
+// Position of a Core::PackedVertex alone, for passes that only need depth
+struct PackedPosition
+{
+    std::uint32_t positionXY;
+    std::uint32_t positionZ;
+};
+
+enum class VertexFormat
+{
+    Float, // Core::Vertex as is
+    Packed, // Core::PackedVertex
+    Position, // Core::PackedPosition, bit identical to the positions of Packed
+};
+
 struct PushConstants
 {
     glm::vec4 ambientColor;
@@ -15,6 +15,17 @@ struct Defaults
     inline static const std::array<float, 4> AmbientColor = { 1.0f, 1.0f, 1.0f, 2.9f };
     inline static const std::uint32_t MaxFramesInFlight = 3;
     inline static const bool DrawSkybox = false;
+    inline static const bool DepthPrepass = false; // Lays down depth first so the shading pass runs once per pixel
+    inline static const bool OcclusionCulling = false; // Two phase test against a depth pyramid, one extra sync
+    inline static const std::string CacheDirectory = "Cache";
+    inline static const bool CookTextures = true;
+    inline static const bool CompressTextures = true;
+    inline static const bool BatchStaticMeshes = false; // Merges small meshes per texture and cell on import
+    inline static const bool OptimizeMeshes = true;
+    inline static const bool BuildMeshlets = true;
+    inline static const bool GenerateLods = true;
+    inline static const float LodPixelError = 1.0f; // Largest accepted simplification error on screen
+    inline static const float LodHysteresis = 0.25f; // Relative band around LodPixelError without level changes
 
 #ifndef NDEBUG
     inline static const bool EnableValidationLayers = true;
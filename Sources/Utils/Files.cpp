@@ -1,50 +1,137 @@
 #include "Files.h"
 
-#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <unordered_set>
 
 #include <stb_image.h>
 
+#include <Utils/Defaults.hpp>
 #include <Utils/Loaders/GltfLoader.h>
+#include <Utils/Loaders/Ktx2Loader.h>
+#include <Utils/Loaders/MeshOptimizer.h>
+#include <Utils/Loaders/MeshSimplifier.h>
+#include <Utils/Loaders/MeshletBuilder.h>
 #include <Utils/Loaders/ObjLoader.h>
+#include <Utils/Loaders/StaticBatcher.h>
 #include <Utils/Logger.hpp>
+#include <Utils/Textures/TextureCooker.h>
+#include <Utils/ThreadPool.h>
 
 namespace Lucid
 {
 
-std::vector<char>
+namespace
+{
+
+// Textures may load on several threads while the device is set up
+std::atomic<bool> TextureCompressionSupported = true;
+
+} // namespace
+
+MappedFilePtr
 Files::LoadFile(const std::filesystem::path& path)
 {
-    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    return std::make_shared<const MappedFile>(path);
+}
 
-    if (!file.is_open())
+Core::TexturePtr
+Files::LoadTexture(const std::filesystem::path& path)
+{
+    if (!std::filesystem::exists(path))
     {
-        throw std::runtime_error("Can't open file: " + path.string());
+        throw std::runtime_error("Can't load texture");
     }
 
-    std::size_t fileSize = static_cast<std::size_t>(file.tellg());
-    std::vector<char> pixels(fileSize);
+    if (!Defaults::CookTextures)
+    {
+        return DecodeTexture(path);
+    }
 
-    file.seekg(0);
-    file.read(pixels.data(), static_cast<std::streamsize>(fileSize));
-    file.close();
+    return LoadCooked({ path }, [&path]() { return DecodeTexture(path); });
+}
 
-    return pixels;
+Core::TexturePtr
+Files::LoadCubemap(const std::array<std::filesystem::path, 6>& faces)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::filesystem::path> sources(faces.begin(), faces.end());
+    Core::TexturePtr result = Defaults::CookTextures
+        ? LoadCooked(sources, [&faces]() { return DecodeCubemap(faces); })
+        : DecodeCubemap(faces);
+
+    if (result->layers != faces.size())
+    {
+        throw std::runtime_error("Can't load cubemap, cooked texture has " + std::to_string(result->layers) + " faces");
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LoggerInfo << "Cubemap " << faces.front().parent_path().string() << " prepared in " << elapsed.count() << " ms";
+
+    return result;
 }
 
 Core::TexturePtr
-Files::LoadTexture(const std::filesystem::path& path)
+Files::LoadCooked(
+    const std::vector<std::filesystem::path>& sources,
+    const std::function<Core::TexturePtr()>& decode)
+{
+    using Compression = Textures::TextureCooker::Compression;
+    bool compress = Defaults::CompressTextures && TextureCompressionSupported;
+    Compression compression = compress ? Compression::Auto : Compression::None;
+    std::filesystem::path cachePath = Textures::TextureCooker::GetCachePath(sources, compression);
+
+    if (std::filesystem::exists(cachePath))
+    {
+        try
+        {
+            return Loaders::Ktx2Loader::Load(cachePath);
+        }
+        catch (const std::exception& ex)
+        {
+            LoggerWarning << "Ignoring cooked texture " << cachePath.string() << ": " << ex.what();
+        }
+    }
+
+    LoggerInfo << "Cooking texture " << sources.front().string();
+
+    Core::TexturePtr cooked = Textures::TextureCooker::Cook(*decode(), compression);
+
+    // A read only or full disk only costs cooking again next time
+    try
+    {
+        Loaders::Ktx2Loader::Save(cachePath, *cooked);
+    }
+    catch (const std::exception& ex)
+    {
+        LoggerWarning << "Can't cache cooked texture " << cachePath.string() << ": " << ex.what();
+    }
+
+    return cooked;
+}
+
+void
+Files::SetTextureCompressionSupported(bool supported)
+{
+    TextureCompressionSupported = supported;
+}
+
+Core::TexturePtr
+Files::DecodeTexture(const std::filesystem::path& path)
 {
     if (!std::filesystem::exists(path))
     {
         throw std::runtime_error("Can't load texture");
     }
 
+    // Only the header is read here, pixels are decoded once the destination memory is known
     int width, height, channels;
-    stbi_uc* pixels = stbi_load(path.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
-
-    if (pixels == nullptr)
+    if (stbi_info(path.string().c_str(), &width, &height, &channels) == 0)
     {
-        throw std::runtime_error("Can't load texture, pixels == nullptr");
+        throw std::runtime_error("Can't load texture, unsupported image: " + path.string());
     }
 
     if (width == 0 || height == 0)
@@ -52,17 +139,70 @@ Files::LoadTexture(const std::filesystem::path& path)
         throw std::runtime_error("Can't load texture, width or height == 0");
     }
 
-    std::size_t size = static_cast<std::size_t>(width * height * 4);
-    std::vector<unsigned char> result(size);
-    std::memcpy(result.data(), pixels, size);
+    auto texture = std::make_shared<Core::Texture>();
+    texture->size = { static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height) };
+    texture->mipLevels = static_cast<std::uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+
+    texture->decoder = [path, size = texture->size](unsigned char* destination)
+    {
+        int decodedWidth, decodedHeight, decodedChannels;
+        std::unique_ptr<stbi_uc, void (*)(void*)> pixels(
+            stbi_load(path.string().c_str(), &decodedWidth, &decodedHeight, &decodedChannels, STBI_rgb_alpha),
+            &stbi_image_free);
+
+        if (pixels == nullptr)
+        {
+            throw std::runtime_error("Can't load texture, pixels == nullptr");
+        }
+
+        if (static_cast<std::uint32_t>(decodedWidth) != size.x || static_cast<std::uint32_t>(decodedHeight) != size.y)
+        {
+            throw std::runtime_error("Can't load texture, image changed while loading: " + path.string());
+        }
+
+        // stb always allocates its own output, this is the only copy on the way to the destination
+        std::memcpy(destination, pixels.get(), static_cast<std::size_t>(size.x) * size.y * 4);
+    };
+
+    return texture;
+}
+
+Core::TexturePtr
+Files::DecodeCubemap(const std::array<std::filesystem::path, 6>& faces)
+{
+    std::array<Core::TexturePtr, 6> decoded;
+    std::transform(faces.begin(), faces.end(), decoded.begin(), &Files::DecodeTexture);
+
+    for (const auto& face : decoded)
+    {
+        if (face->size.x != decoded.at(0)->size.x || face->size.y != decoded.at(0)->size.y)
+        {
+            throw std::runtime_error("Can't load cubemap, faces have different sizes");
+        }
+    }
+
+    auto cubemap = std::make_shared<Core::Texture>();
+    cubemap->size = decoded.at(0)->size;
+    cubemap->mipLevels = decoded.at(0)->mipLevels;
+    cubemap->layers = static_cast<std::uint32_t>(decoded.size());
 
-    std::uint32_t mipLevels = static_cast<std::uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+    // Faces are decoded concurrently, each one straight into its slot of the base level
+    cubemap->decoder = [decoded](unsigned char* destination)
+    {
+        std::size_t faceSize = decoded.at(0)->LevelByteSize(0);
 
-    Core::Texture texture { { static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height) },
-                            result,
-                            mipLevels };
+        ThreadPool::Instance().ParallelFor(
+            decoded.size(),
+            [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; i++)
+                {
+                    decoded.at(i)->DecodeInto(destination + faceSize * i);
+                }
+            });
+    };
 
-    return std::make_shared<Core::Texture>(texture);
+    return cubemap;
 }
 
 Core::SceneNodePtr
@@ -70,16 +210,187 @@ Files::LoadModel(const std::filesystem::path& path)
 {
     LoggerInfo << "Loading model " << path.string().c_str();
 
+    Core::SceneNodePtr root;
+
     if (path.extension() == ".obj")
     {
-        return Loaders::ObjLoader::Load(path);
+        root = Loaders::ObjLoader::Load(path);
     }
     else if (path.extension() == ".gltf" || path.extension() == ".glb")
     {
-        return Loaders::GltfLoader::Load(path);
+        root = Loaders::GltfLoader::Load(path);
+    }
+    else
+    {
+        throw std::runtime_error("Can't determine model format");
+    }
+
+    // Before the mesh passes, so that batches get optimized, split and simplified as a whole
+    if (Defaults::BatchStaticMeshes)
+    {
+        BatchStaticMeshes(root);
+    }
+
+    std::vector<Core::MeshPtr> meshes = CollectMeshes(root);
+
+    if (Defaults::OptimizeMeshes)
+    {
+        OptimizeMeshes(meshes);
+    }
+
+    // Meshlets grow along the optimized triangle order, the vertex fetch order is restored afterwards
+    if (Defaults::BuildMeshlets)
+    {
+        BuildMeshlets(meshes);
+    }
+
+    // After the optimization, levels share the vertex fetch order of the full mesh
+    if (Defaults::GenerateLods)
+    {
+        GenerateLods(meshes);
+    }
+
+    return root;
+}
+
+std::vector<Core::MeshPtr>
+Files::CollectMeshes(const Core::SceneNodePtr& root)
+{
+    std::vector<Core::MeshPtr> meshes;
+    std::unordered_set<Core::MeshPtr> visited;
+    std::vector<Core::SceneNodePtr> stack = { root };
+
+    while (!stack.empty())
+    {
+        Core::SceneNodePtr node = stack.back();
+        stack.pop_back();
+
+        const std::optional<Core::MeshPtr>& mesh = node->GetOptionalMesh();
+        if (mesh.has_value() && visited.insert(mesh.value()).second)
+        {
+            meshes.push_back(mesh.value());
+        }
+
+        stack.insert(stack.end(), node->GetChildren().begin(), node->GetChildren().end());
+    }
+
+    return meshes;
+}
+
+void
+Files::BatchStaticMeshes(const Core::SceneNodePtr& root)
+{
+    auto start = std::chrono::steady_clock::now();
+    Loaders::StaticBatcher::Statistics statistics = Loaders::StaticBatcher::Batch(root);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LoggerInfo << "Batched " << statistics.nodes << " static nodes into " << statistics.batches << " meshes in "
+               << elapsed.count() << " ms";
+}
+
+void
+Files::OptimizeMeshes(const std::vector<Core::MeshPtr>& meshes)
+{
+    using Loaders::MeshOptimizer;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<MeshOptimizer::Statistics> before(meshes.size()), after(meshes.size());
+
+    ThreadPool::Instance().ParallelFor(
+        meshes.size(),
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                Core::Mesh& mesh = *meshes.at(i);
+                before.at(i) = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+                MeshOptimizer::Optimize(mesh);
+                after.at(i) = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+            }
+        });
+
+    MeshOptimizer::Statistics total, optimized;
+    for (std::size_t i = 0; i < meshes.size(); i++)
+    {
+        total += before.at(i);
+        optimized += after.at(i);
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LoggerInfo << "Optimized " << meshes.size() << " meshes in " << elapsed.count() << " ms, ACMR " << total.Acmr()
+               << " -> " << optimized.Acmr() << ", ATVR " << total.Atvr() << " -> " << optimized.Atvr();
+}
+
+void
+Files::BuildMeshlets(const std::vector<Core::MeshPtr>& meshes)
+{
+    using Loaders::MeshOptimizer;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<MeshOptimizer::Statistics> statistics(meshes.size());
+
+    ThreadPool::Instance().ParallelFor(
+        meshes.size(),
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                Core::Mesh& mesh = *meshes.at(i);
+                Loaders::MeshletBuilder::Build(mesh);
+
+                // Meshlets reorder the triangles, only vertex ids change so their ranges and bounds stay valid
+                if (Defaults::OptimizeMeshes)
+                {
+                    MeshOptimizer::OptimizeVertexFetch(mesh);
+                }
+
+                statistics.at(i) = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+            }
+        });
+
+    std::size_t triangles = 0, meshlets = 0;
+    MeshOptimizer::Statistics total;
+
+    for (std::size_t i = 0; i < meshes.size(); i++)
+    {
+        triangles += meshes.at(i)->indices.size() / 3;
+        meshlets += meshes.at(i)->meshlets.size();
+        total += statistics.at(i);
+    }
+
+    // The index order that is actually uploaded
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LoggerInfo << "Built " << meshlets << " meshlets in " << elapsed.count() << " ms, "
+               << (meshlets > 0 ? static_cast<double>(triangles) / static_cast<double>(meshlets) : 0.0)
+               << " triangles per meshlet, ACMR " << total.Acmr() << ", ATVR " << total.Atvr();
+}
+
+void
+Files::GenerateLods(const std::vector<Core::MeshPtr>& meshes)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    ThreadPool::Instance().ParallelFor(
+        meshes.size(),
+        [&meshes](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                Loaders::MeshSimplifier::GenerateLods(*meshes.at(i));
+            }
+        });
+
+    std::size_t triangles = 0, coarsest = 0, levels = 0;
+    for (const Core::MeshPtr& mesh : meshes)
+    {
+        triangles += mesh->indices.size() / 3;
+        coarsest += (mesh->lods.empty() ? mesh->indices.size() : mesh->lods.back().indices.size()) / 3;
+        levels += mesh->lods.size();
     }
 
-    throw std::runtime_error("Can't determine model format");
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LoggerInfo << "Generated " << levels << " LODs in " << elapsed.count() << " ms, " << triangles
+               << " triangles at full detail, " << coarsest << " at the coarsest levels";
 }
 
 } // namespace Lucid
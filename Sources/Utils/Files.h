@@ -1,9 +1,12 @@
 #pragma once
 
+#include <array>
 #include <filesystem>
+#include <functional>
 #include <vector>
 
 #include <Core/SceneNode.h>
+#include <Utils/MappedFile.h>
 
 namespace Lucid
 {
@@ -11,9 +14,32 @@ namespace Lucid
 class Files
 {
 public:
-    static std::vector<char> LoadFile(const std::filesystem::path& path);
+    static MappedFilePtr LoadFile(const std::filesystem::path& path);
     static Core::TexturePtr LoadTexture(const std::filesystem::path& path);
+    static Core::TexturePtr DecodeTexture(const std::filesystem::path& path);
+    static Core::TexturePtr LoadCubemap(const std::array<std::filesystem::path, 6>& faces);
+    static Core::TexturePtr DecodeCubemap(const std::array<std::filesystem::path, 6>& faces);
     static Core::SceneNodePtr LoadModel(const std::filesystem::path& path);
+
+    // Set once the device is known, textures are then cooked uncompressed under their own cache key
+    static void SetTextureCompressionSupported(bool supported);
+
+private:
+    // Every distinct mesh under root, nodes may share them
+    static std::vector<Core::MeshPtr> CollectMeshes(const Core::SceneNodePtr& root);
+
+    // Merges small static meshes under root into per cell batches
+    static void BatchStaticMeshes(const Core::SceneNodePtr& root);
+
+    // Reorders meshes for the post transform cache, overdraw and vertex fetch
+    static void OptimizeMeshes(const std::vector<Core::MeshPtr>& meshes);
+
+    static void BuildMeshlets(const std::vector<Core::MeshPtr>& meshes);
+    static void GenerateLods(const std::vector<Core::MeshPtr>& meshes);
+
+    // Returns the cooked KTX2 for sources from the cache, cooking the result of decode on a miss
+    static Core::TexturePtr
+    LoadCooked(const std::vector<std::filesystem::path>& sources, const std::function<Core::TexturePtr()>& decode);
 };
 
 } // namespace Lucid
@@ -0,0 +1,501 @@
+#include "AccessorReader.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define LUCID_ACCESSOR_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define LUCID_ACCESSOR_NEON
+#endif
+
+namespace Lucid::Loaders
+{
+
+namespace
+{
+
+using ComponentType = AccessorReader::ComponentType;
+
+// Interleaving writes whole float lanes across member boundaries, the layout must be exactly eleven packed floats
+static_assert(offsetof(Core::Vertex, normal) == 3 * sizeof(float), "Unexpected vertex layout");
+static_assert(offsetof(Core::Vertex, color) == 6 * sizeof(float), "Unexpected vertex layout");
+static_assert(offsetof(Core::Vertex, uv) == 9 * sizeof(float), "Unexpected vertex layout");
+static_assert(sizeof(Core::Vertex) == 11 * sizeof(float), "Unexpected vertex layout");
+
+#if defined(LUCID_ACCESSOR_SSE2)
+using Float4 = __m128;
+
+Float4
+Load4(const std::uint8_t* source)
+{
+    return _mm_loadu_ps(static_cast<const float*>(static_cast<const void*>(source)));
+}
+
+void
+Store4(float* destination, Float4 value)
+{
+    _mm_storeu_ps(destination, value);
+}
+
+Float4
+Splat(float value)
+{
+    return _mm_set1_ps(value);
+}
+#elif defined(LUCID_ACCESSOR_NEON)
+using Float4 = float32x4_t;
+
+Float4
+Load4(const std::uint8_t* source)
+{
+    return vld1q_f32(static_cast<const float*>(static_cast<const void*>(source)));
+}
+
+void
+Store4(float* destination, Float4 value)
+{
+    vst1q_f32(destination, value);
+}
+
+Float4
+Splat(float value)
+{
+    return vdupq_n_f32(value);
+}
+#endif
+
+template <typename T>
+float
+ToFloat(const std::uint8_t* source, bool normalized)
+{
+    T value;
+    std::memcpy(&value, source, sizeof(T));
+
+    if constexpr (std::is_same_v<T, float>)
+    {
+        return value;
+    }
+    else
+    {
+        float result = static_cast<float>(value);
+        if (!normalized)
+        {
+            return result;
+        }
+
+        // glTF maps the signed minimum to -1 as well, hence the clamp
+        return std::max(result / static_cast<float>(std::numeric_limits<T>::max()), -1.0f);
+    }
+}
+
+template <typename Function>
+void
+VisitComponentType(ComponentType type, const Function& function)
+{
+    switch (type)
+    {
+    case ComponentType::Byte:
+        function(std::int8_t {});
+        return;
+    case ComponentType::UnsignedByte:
+        function(std::uint8_t {});
+        return;
+    case ComponentType::Short:
+        function(std::int16_t {});
+        return;
+    case ComponentType::UnsignedShort:
+        function(std::uint16_t {});
+        return;
+    case ComponentType::UnsignedInt:
+        function(std::uint32_t {});
+        return;
+    case ComponentType::Float:
+        function(float {});
+        return;
+    }
+
+    throw std::runtime_error(
+        "Can't read accessor, unknown component type " + std::to_string(static_cast<std::uint32_t>(type)));
+}
+
+std::uint32_t
+ReadUnsigned(const std::uint8_t* source, ComponentType type)
+{
+    switch (type)
+    {
+    case ComponentType::UnsignedByte:
+        return *source;
+    case ComponentType::UnsignedShort:
+    {
+        std::uint16_t value;
+        std::memcpy(&value, source, sizeof(value));
+        return value;
+    }
+    case ComponentType::UnsignedInt:
+    {
+        std::uint32_t value;
+        std::memcpy(&value, source, sizeof(value));
+        return value;
+    }
+    default:
+        throw std::runtime_error("Can't read accessor, indices must be unsigned integers");
+    }
+}
+
+} // namespace
+
+std::size_t
+AccessorReader::ComponentSize(ComponentType type)
+{
+    switch (type)
+    {
+    case ComponentType::Byte:
+    case ComponentType::UnsignedByte:
+        return 1;
+    case ComponentType::Short:
+    case ComponentType::UnsignedShort:
+        return 2;
+    case ComponentType::UnsignedInt:
+    case ComponentType::Float:
+        return 4;
+    }
+
+    throw std::runtime_error(
+        "Can't read accessor, unknown component type " + std::to_string(static_cast<std::uint32_t>(type)));
+}
+
+void
+AccessorReader::Interleave(
+    std::span<Core::Vertex> vertices,
+    const Accessor& positions,
+    const Accessor* normals,
+    const Accessor* uvs)
+{
+    auto isPackedFloat = [&vertices](const Accessor* accessor, std::size_t components)
+    {
+        return accessor == nullptr
+            || (accessor->type == ComponentType::Float && accessor->data != nullptr
+                && accessor->components == components && accessor->count >= vertices.size()
+                && !accessor->sparse.has_value());
+    };
+
+    // Plain float streams are by far the most common layout and are copied in a single pass
+    if (isPackedFloat(&positions, 3) && isPackedFloat(normals, 3) && isPackedFloat(uvs, 2))
+    {
+        AccessorReader::InterleaveFloats(vertices, positions, normals, uvs);
+        return;
+    }
+
+    for (Core::Vertex& vertex : vertices)
+    {
+        vertex.normal = glm::vec3(0.0f);
+        vertex.color = glm::vec3(1.0f);
+        vertex.uv = glm::vec2(0.0f);
+    }
+
+    AccessorReader::Read(positions, vertices, &Core::Vertex::position);
+
+    if (normals != nullptr)
+    {
+        AccessorReader::Read(*normals, vertices, &Core::Vertex::normal);
+    }
+
+    if (uvs != nullptr)
+    {
+        AccessorReader::Read(*uvs, vertices, &Core::Vertex::uv);
+    }
+}
+
+void
+AccessorReader::Read(const Accessor& accessor, std::span<Core::Vertex> vertices, glm::vec3 Core::Vertex::*member)
+{
+    AccessorReader::ReadVectors<glm::vec3>(
+        accessor, vertices.size(), [vertices, member](std::size_t i) -> glm::vec3& { return vertices[i].*member; });
+}
+
+void
+AccessorReader::Read(const Accessor& accessor, std::span<Core::Vertex> vertices, glm::vec2 Core::Vertex::*member)
+{
+    AccessorReader::ReadVectors<glm::vec2>(
+        accessor, vertices.size(), [vertices, member](std::size_t i) -> glm::vec2& { return vertices[i].*member; });
+}
+
+void
+AccessorReader::Read(const Accessor& accessor, std::span<glm::vec3> values)
+{
+    AccessorReader::ReadVectors<glm::vec3>(
+        accessor, values.size(), [values](std::size_t i) -> glm::vec3& { return values[i]; });
+}
+
+void
+AccessorReader::Read(const Accessor& accessor, std::span<glm::vec4> values)
+{
+    AccessorReader::ReadVectors<glm::vec4>(
+        accessor, values.size(), [values](std::size_t i) -> glm::vec4& { return values[i]; });
+}
+
+void
+AccessorReader::ReadIndices(const Accessor& accessor, std::span<std::uint32_t> indices)
+{
+    std::size_t count = std::min(accessor.count, indices.size());
+    std::size_t componentSize = AccessorReader::ComponentSize(accessor.type);
+
+    if (accessor.components != 1)
+    {
+        throw std::runtime_error("Can't read indices, accessor must be scalar");
+    }
+
+    if (accessor.data == nullptr)
+    {
+        std::fill_n(indices.begin(), count, 0u);
+    }
+    else if (accessor.stride == componentSize && accessor.type == ComponentType::UnsignedByte)
+    {
+        AccessorReader::WidenBytes(accessor.data, indices.first(count));
+    }
+    else if (accessor.stride == componentSize && accessor.type == ComponentType::UnsignedShort)
+    {
+        AccessorReader::WidenShorts(accessor.data, indices.first(count));
+    }
+    else if (accessor.stride == componentSize && accessor.type == ComponentType::UnsignedInt)
+    {
+        std::memcpy(indices.data(), accessor.data, count * sizeof(std::uint32_t));
+    }
+    else
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            indices[i] = ReadUnsigned(accessor.data + i * accessor.stride, accessor.type);
+        }
+    }
+
+    if (accessor.sparse.has_value())
+    {
+        const Sparse& sparse = accessor.sparse.value();
+
+        for (std::size_t i = 0; i < sparse.count; i++)
+        {
+            std::size_t index = AccessorReader::SparseIndex(sparse, i);
+            if (index >= accessor.count)
+            {
+                throw std::runtime_error("Can't read accessor, sparse index is out of range");
+            }
+
+            if (index < count)
+            {
+                indices[index] = ReadUnsigned(sparse.values + i * componentSize, accessor.type);
+            }
+        }
+    }
+}
+
+template <typename VectorType, typename Output>
+void
+AccessorReader::ReadVectors(const Accessor& accessor, std::size_t count, const Output& output)
+{
+    count = std::min(accessor.count, count);
+    std::size_t components = std::min(accessor.components, static_cast<std::size_t>(VectorType::length()));
+    std::size_t elementSize = accessor.ElementSize();
+
+    VisitComponentType(
+        accessor.type,
+        [&](auto component)
+        {
+            using ComponentT = decltype(component);
+
+            auto convert = [&accessor, components](const std::uint8_t* element, VectorType& value)
+            {
+                for (std::size_t c = 0; c < components; c++)
+                {
+                    value[static_cast<glm::length_t>(c)]
+                        = ToFloat<ComponentT>(element + c * sizeof(ComponentT), accessor.normalized);
+                }
+            };
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                if (accessor.data == nullptr)
+                {
+                    output(i) = VectorType(0.0f);
+                }
+                else
+                {
+                    convert(accessor.data + i * accessor.stride, output(i));
+                }
+            }
+
+            if (!accessor.sparse.has_value())
+            {
+                return;
+            }
+
+            const Sparse& sparse = accessor.sparse.value();
+
+            for (std::size_t i = 0; i < sparse.count; i++)
+            {
+                std::size_t index = AccessorReader::SparseIndex(sparse, i);
+                if (index >= accessor.count)
+                {
+                    throw std::runtime_error("Can't read accessor, sparse index is out of range");
+                }
+
+                if (index < count)
+                {
+                    convert(sparse.values + i * elementSize, output(index));
+                }
+            }
+        });
+}
+
+void
+AccessorReader::InterleaveFloats(
+    std::span<Core::Vertex> vertices,
+    const Accessor& positions,
+    const Accessor* normals,
+    const Accessor* uvs)
+{
+    std::size_t count = vertices.size();
+    std::size_t i = 0;
+
+#if defined(LUCID_ACCESSOR_SSE2) || defined(LUCID_ACCESSOR_NEON)
+    // Vector loads read one float past a vec3, that float belongs to the next element for all but the last one
+    std::size_t vectorCount = count > 0 ? count - 1 : 0;
+    const Float4 zero = Splat(0.0f);
+    const Float4 white = Splat(1.0f);
+
+    // Each store spills one lane into the next member, which the following store then overwrites
+    for (; i < vectorCount; i++)
+    {
+        auto* output = static_cast<float*>(static_cast<void*>(vertices.data() + i));
+
+        Store4(output, Load4(positions.data + i * positions.stride));
+        Store4(output + 3, normals != nullptr ? Load4(normals->data + i * normals->stride) : zero);
+        Store4(output + 6, white);
+
+        if (uvs != nullptr)
+        {
+            std::memcpy(output + 9, uvs->data + i * uvs->stride, 2 * sizeof(float));
+        }
+        else
+        {
+            output[9] = 0.0f;
+            output[10] = 0.0f;
+        }
+    }
+#endif
+
+    auto load = [](const Accessor* accessor, std::size_t index, auto& output)
+    {
+        float components[3] = {};
+
+        if (accessor != nullptr)
+        {
+            std::memcpy(components, accessor->data + index * accessor->stride, accessor->components * sizeof(float));
+        }
+
+        for (glm::length_t c = 0; c < output.length(); c++)
+        {
+            output[c] = components[c];
+        }
+    };
+
+    for (; i < count; i++)
+    {
+        Core::Vertex& vertex = vertices[i];
+
+        load(&positions, i, vertex.position);
+        load(normals, i, vertex.normal);
+        load(uvs, i, vertex.uv);
+        vertex.color = glm::vec3(1.0f);
+    }
+}
+
+void
+AccessorReader::WidenBytes(const std::uint8_t* source, std::span<std::uint32_t> indices)
+{
+    std::size_t i = 0;
+
+#if defined(LUCID_ACCESSOR_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 16 <= indices.size(); i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(static_cast<const __m128i*>(static_cast<const void*>(source + i)));
+        __m128i low = _mm_unpacklo_epi8(bytes, zero);
+        __m128i high = _mm_unpackhi_epi8(bytes, zero);
+
+        auto* output = static_cast<__m128i*>(static_cast<void*>(indices.data() + i));
+        _mm_storeu_si128(output, _mm_unpacklo_epi16(low, zero));
+        _mm_storeu_si128(output + 1, _mm_unpackhi_epi16(low, zero));
+        _mm_storeu_si128(output + 2, _mm_unpacklo_epi16(high, zero));
+        _mm_storeu_si128(output + 3, _mm_unpackhi_epi16(high, zero));
+    }
+#elif defined(LUCID_ACCESSOR_NEON)
+    for (; i + 16 <= indices.size(); i += 16)
+    {
+        uint8x16_t bytes = vld1q_u8(source + i);
+        uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+        uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+
+        vst1q_u32(indices.data() + i, vmovl_u16(vget_low_u16(low)));
+        vst1q_u32(indices.data() + i + 4, vmovl_u16(vget_high_u16(low)));
+        vst1q_u32(indices.data() + i + 8, vmovl_u16(vget_low_u16(high)));
+        vst1q_u32(indices.data() + i + 12, vmovl_u16(vget_high_u16(high)));
+    }
+#endif
+
+    for (; i < indices.size(); i++)
+    {
+        indices[i] = source[i];
+    }
+}
+
+void
+AccessorReader::WidenShorts(const std::uint8_t* source, std::span<std::uint32_t> indices)
+{
+    std::size_t i = 0;
+
+#if defined(LUCID_ACCESSOR_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 8 <= indices.size(); i += 8)
+    {
+        __m128i shorts = _mm_loadu_si128(static_cast<const __m128i*>(static_cast<const void*>(source + i * 2)));
+
+        auto* output = static_cast<__m128i*>(static_cast<void*>(indices.data() + i));
+        _mm_storeu_si128(output, _mm_unpacklo_epi16(shorts, zero));
+        _mm_storeu_si128(output + 1, _mm_unpackhi_epi16(shorts, zero));
+    }
+#elif defined(LUCID_ACCESSOR_NEON)
+    for (; i + 8 <= indices.size(); i += 8)
+    {
+        uint16x8_t shorts = vreinterpretq_u16_u8(vld1q_u8(source + i * 2));
+
+        vst1q_u32(indices.data() + i, vmovl_u16(vget_low_u16(shorts)));
+        vst1q_u32(indices.data() + i + 4, vmovl_u16(vget_high_u16(shorts)));
+    }
+#endif
+
+    for (; i < indices.size(); i++)
+    {
+        std::uint16_t value;
+        std::memcpy(&value, source + i * 2, sizeof(value));
+        indices[i] = value;
+    }
+}
+
+std::size_t
+AccessorReader::SparseIndex(const Sparse& sparse, std::size_t i)
+{
+    return ReadUnsigned(sparse.indices + i * AccessorReader::ComponentSize(sparse.indexType), sparse.indexType);
+}
+
+} // namespace Lucid::Loaders
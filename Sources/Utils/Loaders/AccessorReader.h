@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include <Core/Vertex.h>
+
+namespace Lucid::Loaders
+{
+
+/*
+        Typed decoding of glTF accessors into engine vertex and index streams.
+        Honours byteStride, normalized integer components and sparse substitution,
+        tightly packed float and unsigned integer streams take SIMD fast paths.
+*/
+class AccessorReader
+{
+public:
+    // Values match the glTF componentType enumeration
+    enum class ComponentType : std::uint32_t
+    {
+        Byte = 5120,
+        UnsignedByte = 5121,
+        Short = 5122,
+        UnsignedShort = 5123,
+        UnsignedInt = 5125,
+        Float = 5126,
+    };
+
+    // Sparse values are tightly packed, indices are strictly increasing element numbers
+    struct Sparse
+    {
+        std::size_t count = 0;
+        const std::uint8_t* indices = nullptr;
+        ComponentType indexType = ComponentType::UnsignedInt;
+        const std::uint8_t* values = nullptr;
+    };
+
+    struct Accessor
+    {
+        const std::uint8_t* data = nullptr; // Null when the accessor has no buffer view, elements read as zero
+        std::size_t count = 0;
+        std::size_t stride = 0; // Byte distance between elements, byteStride or the packed element size
+        std::size_t components = 0;
+        ComponentType type = ComponentType::Float;
+        bool normalized = false;
+        std::optional<Sparse> sparse;
+
+        [[nodiscard]] std::size_t ElementSize() const { return ComponentSize(type) * components; }
+    };
+
+    [[nodiscard]] static std::size_t ComponentSize(ComponentType type);
+
+    // Fills vertices with position, normal and uv in one pass, missing streams are zero and color is white
+    static void Interleave(
+        std::span<Core::Vertex> vertices,
+        const Accessor& positions,
+        const Accessor* normals = nullptr,
+        const Accessor* uvs = nullptr);
+
+    // Converts one attribute into the given vertex member, leaving the other members untouched
+    static void Read(const Accessor& accessor, std::span<Core::Vertex> vertices, glm::vec3 Core::Vertex::*member);
+    static void Read(const Accessor& accessor, std::span<Core::Vertex> vertices, glm::vec2 Core::Vertex::*member);
+
+    // Plain vector streams, such as the per instance transforms of EXT_mesh_gpu_instancing
+    static void Read(const Accessor& accessor, std::span<glm::vec3> values);
+    static void Read(const Accessor& accessor, std::span<glm::vec4> values);
+
+    // Widens unsigned byte, short or int indices to 32 bits
+    static void ReadIndices(const Accessor& accessor, std::span<std::uint32_t> indices);
+
+private:
+    // Converts count elements, output(i) returns the vector element i is written to
+    template <typename VectorType, typename Output>
+    static void ReadVectors(const Accessor& accessor, std::size_t count, const Output& output);
+
+    static void InterleaveFloats(
+        std::span<Core::Vertex> vertices,
+        const Accessor& positions,
+        const Accessor* normals,
+        const Accessor* uvs);
+
+    static void WidenBytes(const std::uint8_t* source, std::span<std::uint32_t> indices);
+    static void WidenShorts(const std::uint8_t* source, std::span<std::uint32_t> indices);
+
+    static std::size_t SparseIndex(const Sparse& sparse, std::size_t i);
+};
+
+} // namespace Lucid::Loaders
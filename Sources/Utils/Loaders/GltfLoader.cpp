@@ -5,26 +5,103 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <tiny_gltf.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <string_view>
+
 #include <Utils/Logger.hpp>
+#include <Utils/Textures/MipGenerator.h>
+#include <Utils/ThreadPool.h>
 #include <glm/gtc/quaternion.hpp>
 
 namespace Lucid::Loaders
 {
 
+namespace
+{
+
+// Quantized attributes are decoded by AccessorReader like any other component type,
+// instanced nodes expand into one child per instance
+const std::array<std::string_view, 2> SupportedExtensions = { "KHR_mesh_quantization", "EXT_mesh_gpu_instancing" };
+
+} // namespace
+
 Core::SceneNodePtr
 GltfLoader::Load(const std::filesystem::path& path)
 {
-    tinygltf::Model gltf;
+    // Parse the JSON, decode images and meshes in parallel, then assemble the scene graph
+    auto start = std::chrono::steady_clock::now();
+
+    Document document;
+    Parse(document, path);
+    auto parsed = std::chrono::steady_clock::now();
+
+    Decode(document);
+    auto decoded = std::chrono::steady_clock::now();
+
+    const tinygltf::Model& gltf = document.gltf;
+
+    if (gltf.scenes.size() != 1)
+    {
+        throw std::runtime_error("Gltf loader supports only one scene per file");
+    }
+
+    const tinygltf::Scene& scene = gltf.scenes.at(0);
+    Core::SceneNodePtr result = Core::SceneNode::Create("Root", nullptr);
+
+    for (const auto nodeId : scene.nodes)
+    {
+        const tinygltf::Node& rootNode = gltf.nodes.at(static_cast<std::size_t>(nodeId));
+        Core::SceneNodePtr traversed = GltfLoader::TraverseFn(document, rootNode, result);
+        result->AddChildren(traversed);
+    }
+
+    auto milliseconds = [](auto duration)
+    { return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count(); };
+
+    LoggerInfo << "Loaded " << path.filename().string() << " in "
+               << milliseconds(std::chrono::steady_clock::now() - start) << " ms (parse "
+               << milliseconds(parsed - start) << " ms, decode " << milliseconds(decoded - parsed) << " ms, "
+               << gltf.images.size() << " images, " << gltf.meshes.size() << " meshes)";
+
+    return result;
+}
+
+void
+GltfLoader::Parse(Document& document, const std::filesystem::path& path)
+{
     tinygltf::TinyGLTF loader;
     std::string error;
     std::string warn;
 
-    if (path.extension() == ".gltf" && !loader.LoadASCIIFromFile(&gltf, &error, &warn, path.string()))
+    // Parse from the mapping instead of letting tinygltf read the whole file into a vector first
+    document.file = std::make_shared<const MappedFile>(path);
+    const MappedFile& file = *document.file;
+    std::string baseDirectory = path.parent_path().string();
+
+    if (file.Size() > std::numeric_limits<unsigned int>::max())
+    {
+        throw std::runtime_error("Cant load gltf, file is larger than 4 GB: " + path.string());
+    }
+
+    bool binary = path.extension() == ".glb";
+    auto size = static_cast<unsigned int>(file.Size());
+
+    // Images are only collected here, decoding them inside tinygltf would be serial
+    loader.SetImageLoader(&GltfLoader::StoreImage, &document);
+
+    if (!binary
+        && !loader.LoadASCIIFromString(&document.gltf, &error, &warn, file.View().data(), size, baseDirectory))
     {
         throw std::runtime_error("Cant load gltf, error: " + error);
     }
 
-    if (path.extension() == ".glb" && !loader.LoadBinaryFromFile(&gltf, &error, &warn, path.string()))
+    if (binary && !loader.LoadBinaryFromMemory(&document.gltf, &error, &warn, file.Data(), size, baseDirectory))
     {
         throw std::runtime_error("Cant load gltf, error: " + error);
     }
@@ -39,233 +116,528 @@ GltfLoader::Load(const std::filesystem::path& path)
         throw std::runtime_error("Warn in gltf loading: " + warn);
     }
 
-    if (gltf.scenes.size() != 1)
+    for (const std::string& extension : document.gltf.extensionsRequired)
     {
-        throw std::runtime_error("Gltf loader supports only one scene per file");
+        if (std::find(SupportedExtensions.begin(), SupportedExtensions.end(), extension) == SupportedExtensions.end())
+        {
+            LoggerWarning << "Required gltf extension " << extension << " is not supported, " << path.string()
+                          << " may render incorrectly";
+        }
     }
 
-    tinygltf::Scene scene = gltf.scenes.at(0);
-    Core::SceneNodePtr result = Core::SceneNode::Create("Root", nullptr);
+    std::span<const std::uint8_t> binaryChunk = binary ? FindBinaryChunk(file) : std::span<const std::uint8_t> {};
 
-    for (const auto nodeId : scene.nodes)
+    for (std::size_t i = 0; i < document.gltf.buffers.size(); i++)
     {
-        const tinygltf::Node rootNode = gltf.nodes.at(static_cast<std::size_t>(nodeId));
-        Core::SceneNodePtr traversed = GltfLoader::TraverseFn(gltf, rootNode, nullptr);
-        result->AddChildren(traversed);
-    }
+        tinygltf::Buffer& buffer = document.gltf.buffers.at(i);
 
-    return result;
+        // Only the first buffer of a GLB may refer to the binary chunk, everything else stays in tinygltf's memory
+        if (i == 0 && buffer.uri.empty() && binaryChunk.size() >= buffer.data.size())
+        {
+            document.buffers.push_back(binaryChunk.first(buffer.data.size()));
+            std::vector<unsigned char>().swap(buffer.data);
+            continue;
+        }
+
+        document.buffers.emplace_back(buffer.data.data(), buffer.data.size());
+    }
 }
 
-std::optional<GltfLoader::BufferData>
-GltfLoader::GetBufferData(const tinygltf::Model& gltf, std::int32_t meshId, const std::string& attribute)
+std::span<const std::uint8_t>
+GltfLoader::FindBinaryChunk(const MappedFile& file)
 {
-    const tinygltf::Mesh& mesh = gltf.meshes.at(static_cast<std::size_t>(meshId));
+    // GLB layout: 12 byte header, JSON chunk, optional BIN chunk, each chunk prefixed with its length and type
+    const std::uint32_t ChunkTypeBin = 0x004E4942;
+    std::span<const std::uint8_t> bytes = file.Bytes();
 
-    std::size_t accessorId = 0;
+    auto readU32 = [&bytes](std::size_t offset)
+    {
+        std::uint32_t value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(value));
+        return value;
+    };
 
-    if (attribute == "INDEX")
+    if (bytes.size() < 20)
     {
-        accessorId = static_cast<std::size_t>(mesh.primitives[0].indices);
+        return {};
     }
-    else
+
+    std::size_t offset = 12 + 8 + readU32(12);
+
+    if (offset + 8 > bytes.size() || readU32(offset + 4) != ChunkTypeBin)
+    {
+        return {};
+    }
+
+    std::size_t length = readU32(offset);
+
+    if (offset + 8 + length > bytes.size())
     {
-        try
+        throw std::runtime_error("Cant load gltf, binary chunk is truncated");
+    }
+
+    return bytes.subspan(offset + 8, length);
+}
+
+void
+GltfLoader::Decode(Document& document)
+{
+    const tinygltf::Model& gltf = document.gltf;
+    std::size_t imageCount = gltf.images.size();
+
+    document.images.resize(imageCount);
+    document.meshes.resize(gltf.meshes.size());
+
+    // Images come first, they are usually the most expensive tasks
+    ThreadPool::Instance().ParallelFor(
+        imageCount + gltf.meshes.size(),
+        [&document, imageCount](std::size_t begin, std::size_t end)
         {
-            accessorId = static_cast<std::size_t>(mesh.primitives[0].attributes.at(attribute));
-        }
-        catch (const std::exception& ex)
+            for (std::size_t i = begin; i < end; i++)
+            {
+                if (i < imageCount)
+                {
+                    document.images.at(i) = GltfLoader::ImageFn(document, i);
+                }
+                else
+                {
+                    std::size_t meshId = i - imageCount;
+                    document.meshes.at(meshId) = GltfLoader::MeshFn(document, static_cast<std::int32_t>(meshId));
+                }
+            }
+        });
+
+    std::vector<std::vector<unsigned char>>().swap(document.encodedImages);
+
+    // Materials are resolved once all images are decoded, primitives then share the material's texture
+    document.materials.reserve(gltf.materials.size());
+    for (const tinygltf::Material& material : gltf.materials)
+    {
+        document.materials.push_back(GltfLoader::MaterialFn(document, material));
+    }
+
+    for (std::size_t i = 0; i < gltf.meshes.size(); i++)
+    {
+        const tinygltf::Mesh& mesh = gltf.meshes.at(i);
+
+        for (std::size_t j = 0; j < mesh.primitives.size(); j++)
         {
-            LoggerError << "No attribute " << attribute << ": " << ex.what();
-            return std::nullopt;
+            const Core::MeshPtr& primitive = document.meshes.at(i).at(j);
+            std::int32_t materialId = mesh.primitives.at(j).material;
+
+            if (primitive && materialId >= 0 && static_cast<std::size_t>(materialId) < document.materials.size())
+            {
+                primitive->texture = document.materials.at(static_cast<std::size_t>(materialId));
+                primitive->doubleSided = gltf.materials.at(static_cast<std::size_t>(materialId)).doubleSided;
+            }
         }
     }
+}
+
+bool
+GltfLoader::StoreImage(
+    tinygltf::Image* image,
+    int imageId,
+    std::string*,
+    std::string*,
+    int,
+    int,
+    const unsigned char* bytes,
+    int size,
+    void* userData)
+{
+    // Buffer view images are decoded straight from the buffer, only external and data uri images are kept
+    if (image->bufferView >= 0)
+    {
+        return true;
+    }
 
-    // Accessor
-    const tinygltf::Accessor& accessor = gltf.accessors[accessorId];
-    std::uint32_t componentType = static_cast<std::uint32_t>(accessor.componentType);
-    std::uint32_t type = static_cast<std::uint32_t>(accessor.type);
-    std::size_t componentSize = static_cast<std::size_t>(tinygltf::GetComponentSizeInBytes(componentType));
-    std::size_t componentCount = static_cast<std::size_t>(tinygltf::GetNumComponentsInType(type));
-    std::size_t itemStride = componentSize * componentCount;
-    std::size_t itemCount = accessor.count;
+    auto& encodedImages = static_cast<Document*>(userData)->encodedImages;
+    auto index = static_cast<std::size_t>(imageId);
 
-    if (attribute == "POSITION" && accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+    if (encodedImages.size() <= index)
     {
-        throw std::runtime_error(
-            "Loader supports only float positions, provided " + std::to_string(accessor.componentType));
+        encodedImages.resize(index + 1);
+    }
+
+    encodedImages.at(index).assign(bytes, bytes + size);
+    return true;
+}
+
+std::optional<AccessorReader::Accessor>
+GltfLoader::GetAccessor(const Document& document, const tinygltf::Primitive& primitive, const std::string& attribute)
+{
+    std::int32_t accessorIndex = -1;
+
+    if (attribute == "INDEX")
+    {
+        accessorIndex = primitive.indices;
+    }
+    else if (auto found = primitive.attributes.find(attribute); found != primitive.attributes.end())
+    {
+        accessorIndex = found->second;
+    }
+
+    if (accessorIndex < 0)
+    {
+        return std::nullopt;
     }
 
-    if (attribute == "NORMAL" && accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+    std::size_t expectedComponents = attribute == "INDEX" ? 1 : (attribute == "TEXCOORD_0" ? 2 : 3);
+    return GltfLoader::GetAccessor(document, static_cast<std::size_t>(accessorIndex), expectedComponents, attribute);
+}
+
+AccessorReader::Accessor
+GltfLoader::GetAccessor(
+    const Document& document,
+    std::size_t accessorId,
+    std::size_t expectedComponents,
+    const std::string& attribute)
+{
+    using ComponentType = AccessorReader::ComponentType;
+
+    const tinygltf::Model& gltf = document.gltf;
+    const tinygltf::Accessor& accessor = gltf.accessors.at(accessorId);
+
+    AccessorReader::Accessor result;
+    result.count = accessor.count;
+    result.type = static_cast<ComponentType>(accessor.componentType);
+    result.normalized = accessor.normalized;
+    result.components
+        = static_cast<std::size_t>(tinygltf::GetNumComponentsInType(static_cast<std::uint32_t>(accessor.type)));
+
+    // Vertex colors may carry alpha, which is dropped while reading
+    bool colorWithAlpha = attribute == "COLOR_0" && result.components == 4;
+    if (result.components != expectedComponents && !colorWithAlpha)
     {
         throw std::runtime_error(
-            "Loader supports only float normals, provided " + std::to_string(accessor.componentType));
+            "Cant load gltf, accessor " + std::to_string(accessorId) + " has unexpected type for " + attribute);
     }
 
-    if (attribute == "INDEX"
-        && ((accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
-            && (accessor.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)))
+    if (attribute == "INDEX" && result.type != ComponentType::UnsignedByte
+        && result.type != ComponentType::UnsignedShort && result.type != ComponentType::UnsignedInt)
     {
         throw std::runtime_error(
-            "Loader supports only unsigned short indices, provided " + std::to_string(accessor.componentType));
+            "Loader supports only unsigned integer indices, provided " + std::to_string(accessor.componentType));
     }
 
-    if (attribute == "TEXCOORD_0" && accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+    // Attributes of any component type are converted to float while reading, normalized or not,
+    // which covers the integer positions, normals and uvs of KHR_mesh_quantization
+    std::size_t elementSize = result.ElementSize();
+    result.stride = elementSize;
+
+    // Reading past a mapping faults instead of returning garbage, reject broken accessors up front
+    auto region = [&document, accessorId](std::int32_t bufferViewId, std::size_t offset, std::size_t size)
+    {
+        const tinygltf::BufferView& bufferView = document.gltf.bufferViews.at(static_cast<std::size_t>(bufferViewId));
+        std::span<const std::uint8_t> buffer = document.buffers.at(static_cast<std::size_t>(bufferView.buffer));
+        offset += bufferView.byteOffset;
+
+        if (offset > buffer.size() || size > buffer.size() - offset)
+        {
+            throw std::runtime_error(
+                "Cant load gltf, accessor " + std::to_string(accessorId) + " is out of buffer bounds");
+        }
+
+        return buffer.data() + offset;
+    };
+
+    // Accessors without a buffer view read as zeros, optionally patched by sparse values
+    if (accessor.bufferView >= 0)
     {
-        throw std::runtime_error("Loader supports only float UV's, provided " + std::to_string(accessor.componentType));
+        const tinygltf::BufferView& bufferView = gltf.bufferViews.at(static_cast<std::size_t>(accessor.bufferView));
+        if (bufferView.byteStride != 0)
+        {
+            result.stride = bufferView.byteStride;
+        }
+
+        std::size_t size = result.count > 0 ? result.stride * (result.count - 1) + elementSize : 0;
+        result.data = region(accessor.bufferView, accessor.byteOffset, size);
     }
 
-    // Buffer view
-    std::size_t bufferViewId = static_cast<std::size_t>(accessor.bufferView);
-    const tinygltf::BufferView& bufferView = gltf.bufferViews[bufferViewId];
+    if (accessor.sparse.isSparse && accessor.sparse.count > 0)
+    {
+        AccessorReader::Sparse sparse;
+        sparse.count = static_cast<std::size_t>(accessor.sparse.count);
+        sparse.indexType = static_cast<ComponentType>(accessor.sparse.indices.componentType);
 
-    // Buffer
-    std::size_t bufferId = static_cast<std::size_t>(bufferView.buffer);
-    const tinygltf::Buffer& buffer = gltf.buffers[bufferId];
+        const auto& indices = accessor.sparse.indices;
+        const auto& values = accessor.sparse.values;
+        sparse.indices = region(
+            indices.bufferView, indices.byteOffset, sparse.count * AccessorReader::ComponentSize(sparse.indexType));
+        sparse.values = region(values.bufferView, values.byteOffset, sparse.count * elementSize);
 
-    return { { buffer.data.data() + accessor.byteOffset + bufferView.byteOffset,
-               itemStride,
-               itemCount,
-               accessor.componentType } };
+        result.sparse = sparse;
+    }
+
+    return result;
 }
 
 Core::SceneNodePtr
-GltfLoader::TraverseFn(const tinygltf::Model& gltf, const tinygltf::Node& node, Core::SceneNodePtr parent)
+GltfLoader::TraverseFn(const Document& document, const tinygltf::Node& node, const Core::SceneNodePtr& parent)
 {
     Core::SceneNodePtr result = Core::SceneNode::Create(node.name, parent);
-    result->SetMesh(GltfLoader::MeshFn(gltf, node.mesh));
     result->SetTransform(GltfLoader::TransformFn(node));
 
+    // A single primitive lives on the node itself, several become children sharing the node transform
+    std::vector<Core::MeshPtr> meshes;
+
+    if (node.mesh >= 0)
+    {
+        const auto& decoded = document.meshes.at(static_cast<std::size_t>(node.mesh));
+        std::copy_if(
+            decoded.begin(),
+            decoded.end(),
+            std::back_inserter(meshes),
+            [](const Core::MeshPtr& mesh) { return mesh != nullptr; });
+    }
+
+    auto attach = [&meshes](const Core::SceneNodePtr& target)
+    {
+        if (meshes.size() == 1)
+        {
+            target->SetMesh(meshes.front());
+            return;
+        }
+
+        for (std::size_t i = 0; i < meshes.size(); i++)
+        {
+            std::string name = target->GetName() + " [" + std::to_string(i) + "]";
+            Core::SceneNodePtr primitive = Core::SceneNode::Create(name, target);
+            primitive->SetMesh(meshes.at(i));
+            target->AddChildren(primitive);
+        }
+    };
+
+    // Every instance shares the meshes, so the renderer draws them with a single instanced draw per primitive
+    std::vector<glm::mat4> instances = meshes.empty() ? std::vector<glm::mat4> {} : InstancesFn(document, node);
+
+    if (instances.empty())
+    {
+        attach(result);
+    }
+
+    for (std::size_t i = 0; i < instances.size(); i++)
+    {
+        Core::SceneNodePtr instance = Core::SceneNode::Create(node.name + " #" + std::to_string(i), result);
+        instance->SetTransform(instances.at(i));
+        attach(instance);
+        result->AddChildren(instance);
+    }
+
     for (const auto childId : node.children)
     {
-        const tinygltf::Node childNode = gltf.nodes.at(static_cast<std::size_t>(childId));
-        Core::SceneNodePtr traversed = GltfLoader::TraverseFn(gltf, childNode, result);
+        const tinygltf::Node& childNode = document.gltf.nodes.at(static_cast<std::size_t>(childId));
+        Core::SceneNodePtr traversed = GltfLoader::TraverseFn(document, childNode, result);
         result->AddChildren(traversed);
     }
 
     return result;
 }
 
+std::vector<Core::MeshPtr>
+GltfLoader::MeshFn(const Document& document, std::int32_t meshId)
+{
+    if (meshId < 0)
+    {
+        return {};
+    }
+
+    const tinygltf::Mesh& mesh = document.gltf.meshes.at(static_cast<std::size_t>(meshId));
+    std::vector<Core::MeshPtr> result;
+    result.reserve(mesh.primitives.size());
+
+    // Skipped primitives stay as null entries so indices keep matching mesh.primitives
+    for (const auto& primitive : mesh.primitives)
+    {
+        result.push_back(GltfLoader::PrimitiveFn(document, primitive));
+    }
+
+    return result;
+}
+
 Core::MeshPtr
-GltfLoader::MeshFn(const tinygltf::Model& gltf, std::int32_t meshId)
+GltfLoader::PrimitiveFn(const Document& document, const tinygltf::Primitive& primitive)
 {
-    if (meshId == -1)
+    if (primitive.mode != -1 && primitive.mode != TINYGLTF_MODE_TRIANGLES)
+    {
+        LoggerWarning << "Skipping primitive with unsupported mode " << primitive.mode;
+        return nullptr;
+    }
+
+    auto positions = GltfLoader::GetAccessor(document, primitive, "POSITION");
+    if (!positions.has_value())
     {
         return nullptr;
     }
 
-    auto indexBuffer = GltfLoader::GetBufferData(gltf, meshId, "INDEX");
-    auto vertexBuffer = GltfLoader::GetBufferData(gltf, meshId, "POSITION");
-    auto normalBuffer = GltfLoader::GetBufferData(gltf, meshId, "NORMAL");
-    auto uvBuffer = GltfLoader::GetBufferData(gltf, meshId, "TEXCOORD_0");
+    auto indices = GltfLoader::GetAccessor(document, primitive, "INDEX");
+    auto normals = GltfLoader::GetAccessor(document, primitive, "NORMAL");
+    auto uvs = GltfLoader::GetAccessor(document, primitive, "TEXCOORD_0");
+    auto colors = GltfLoader::GetAccessor(document, primitive, "COLOR_0");
 
-    Core::Mesh result;
+    // Built in place, the mesh is never copied on its way to the scene
+    auto result = std::make_shared<Core::Mesh>();
+    result->vertices.resize(positions->count);
 
-    if (!vertexBuffer.has_value())
+    AccessorReader::Interleave(
+        result->vertices,
+        positions.value(),
+        normals.has_value() ? &normals.value() : nullptr,
+        uvs.has_value() ? &uvs.value() : nullptr);
+
+    if (colors.has_value())
     {
-        return std::make_shared<Core::Mesh>(result);
+        AccessorReader::Read(colors.value(), result->vertices, &Core::Vertex::color);
     }
 
-    // Vertices
-    for (std::size_t i = 0; i < vertexBuffer.value().count; i++)
+    if (indices.has_value())
+    {
+        result->indices.resize(indices->count);
+        AccessorReader::ReadIndices(indices.value(), result->indices);
+    }
+    else
     {
-        Core::Vertex vertex;
+        // Non indexed primitives draw their vertices in order
+        result->indices.resize(result->vertices.size());
+        std::iota(result->indices.begin(), result->indices.end(), 0u);
+    }
 
-        // Position
-        if (vertexBuffer.has_value())
-        {
-            const float* position
-                = reinterpret_cast<const float*>(vertexBuffer.value().data + (i * vertexBuffer.value().stride));
-            vertex.position = { position[0], position[1], position[2] };
-        }
+    return result;
+}
 
-        // Normal
-        if (normalBuffer.has_value())
-        {
-            const float* normal
-                = reinterpret_cast<const float*>(normalBuffer.value().data + (i * normalBuffer.value().stride));
-            vertex.normal = { normal[0], normal[1], normal[2] };
-        }
+Core::TexturePtr
+GltfLoader::ImageFn(const Document& document, std::size_t imageId)
+{
+    const tinygltf::Image& image = document.gltf.images.at(imageId);
+    std::span<const std::uint8_t> bytes;
+
+    if (image.bufferView >= 0)
+    {
+        const tinygltf::BufferView& bufferView
+            = document.gltf.bufferViews.at(static_cast<std::size_t>(image.bufferView));
+        std::span<const std::uint8_t> buffer = document.buffers.at(static_cast<std::size_t>(bufferView.buffer));
 
-        // UV
-        if (uvBuffer.has_value())
+        if (bufferView.byteOffset + bufferView.byteLength > buffer.size())
         {
-            const float* uv = reinterpret_cast<const float*>(uvBuffer.value().data + (i * uvBuffer.value().stride));
-            vertex.uv = { uv[0], uv[1] };
+            throw std::runtime_error("Cant load gltf, image " + std::to_string(imageId) + " is out of buffer bounds");
         }
 
-        result.vertices.push_back(vertex);
+        bytes = buffer.subspan(bufferView.byteOffset, bufferView.byteLength);
+    }
+    else if (imageId < document.encodedImages.size())
+    {
+        bytes = document.encodedImages.at(imageId);
     }
 
-    if (!indexBuffer.has_value())
+    if (bytes.empty() || bytes.size() > static_cast<std::size_t>(std::numeric_limits<int>::max()))
     {
-        return std::make_shared<Core::Mesh>(result);
+        LoggerWarning << "Skipping image " << imageId << " without data";
+        return nullptr;
     }
 
-    // Indices
-    for (std::size_t i = 0; i < indexBuffer.value().count; i++)
+    int width, height, channels;
+    std::unique_ptr<stbi_uc, void (*)(void*)> pixels(
+        stbi_load_from_memory(
+            bytes.data(), static_cast<int>(bytes.size()), &width, &height, &channels, STBI_rgb_alpha),
+        &stbi_image_free);
+
+    if (pixels == nullptr)
     {
-        // Index
-        if (indexBuffer.value().type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
-        {
-            const std::uint16_t index
-                = *reinterpret_cast<const uint16_t*>(indexBuffer.value().data + (i * indexBuffer.value().stride));
-            result.indices.push_back(index);
-        }
-        else if (indexBuffer.value().type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)
-        {
-            const std::uint32_t index
-                = *reinterpret_cast<const uint32_t*>(indexBuffer.value().data + (i * indexBuffer.value().stride));
-            result.indices.push_back(index);
-        }
+        LoggerWarning << "Can't decode image " << imageId << ": " << stbi_failure_reason();
+        return nullptr;
     }
 
-    result.texture = GltfLoader::TextureFn(gltf, meshId);
+    auto result = std::make_shared<Core::Texture>();
+    result->size = { static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height) };
+    result->mipLevels = Textures::MipGenerator::GetMipLevels(result->size);
+    result->pixels.assign(pixels.get(), pixels.get() + static_cast<std::size_t>(width) * result->size.y * 4);
 
-    return std::make_shared<Core::Mesh>(result);
+    return result;
 }
 
 Core::TexturePtr
-GltfLoader::TextureFn(const tinygltf::Model& gltf, std::int32_t meshId)
+GltfLoader::MaterialFn(const Document& document, const tinygltf::Material& material)
 {
-    if (static_cast<std::size_t>(meshId) >= gltf.meshes.size() || meshId < 0)
+    const tinygltf::Model& gltf = document.gltf;
+
+    std::int32_t textureId = material.pbrMetallicRoughness.baseColorTexture.index;
+    if (textureId < 0 || static_cast<std::size_t>(textureId) >= gltf.textures.size())
     {
         return nullptr;
     }
 
-    const tinygltf::Mesh& mesh = gltf.meshes.at(static_cast<std::size_t>(meshId));
-
-    if (mesh.primitives.empty())
+    // Materials reference textures, which in turn reference images
+    std::int32_t imageId = gltf.textures.at(static_cast<std::size_t>(textureId)).source;
+    if (imageId < 0 || static_cast<std::size_t>(imageId) >= document.images.size())
     {
         return nullptr;
     }
 
-    std::int32_t materialId = mesh.primitives.at(0).material;
-    if (materialId < 0)
+    return document.images.at(static_cast<std::size_t>(imageId));
+}
+
+std::vector<glm::mat4>
+GltfLoader::InstancesFn(const Document& document, const tinygltf::Node& node)
+{
+    auto extension = node.extensions.find("EXT_mesh_gpu_instancing");
+    if (extension == node.extensions.end() || !extension->second.Has("attributes"))
     {
-        return nullptr;
+        return {};
     }
 
-    if (static_cast<std::size_t>(materialId) >= gltf.materials.size())
+    const tinygltf::Value& attributes = extension->second.Get("attributes");
+
+    std::size_t count = 0;
+    auto read = [&](const std::string& attribute, auto& values, std::size_t components)
     {
-        return nullptr;
-    }
+        if (!attributes.Has(attribute))
+        {
+            return;
+        }
 
-    const tinygltf::Material& material = gltf.materials.at(static_cast<std::size_t>(materialId));
+        auto accessorId = static_cast<std::size_t>(attributes.Get(attribute).GetNumberAsInt());
+        AccessorReader::Accessor accessor = GltfLoader::GetAccessor(document, accessorId, components, attribute);
 
-    std::int32_t textureId = material.pbrMetallicRoughness.baseColorTexture.index;
-    if (textureId == -1)
+        if (count != 0 && accessor.count != count)
+        {
+            throw std::runtime_error("Cant load gltf, instance attributes of " + node.name + " differ in count");
+        }
+
+        count = accessor.count;
+        values.resize(count);
+        AccessorReader::Read(accessor, values);
+    };
+
+    std::vector<glm::vec3> translations;
+    std::vector<glm::vec4> rotations;
+    std::vector<glm::vec3> scales;
+    read("TRANSLATION", translations, 3);
+    read("ROTATION", rotations, 4);
+    read("SCALE", scales, 3);
+
+    std::vector<glm::mat4> result(count, glm::mat4(1.0f));
+
+    for (std::size_t i = 0; i < count; i++)
     {
-        return nullptr;
-    }
+        if (!translations.empty())
+        {
+            result[i] = glm::translate(result[i], translations[i]);
+        }
 
-    const tinygltf::Image image = gltf.images.at(static_cast<std::size_t>(textureId));
+        if (!rotations.empty())
+        {
+            const glm::vec4& rotation = rotations[i]; // Stored as x, y, z, w
+            result[i] *= glm::mat4_cast(glm::quat(rotation.w, rotation.x, rotation.y, rotation.z));
+        }
 
-    Core::Texture result;
-    result.size = { static_cast<std::uint32_t>(image.width), static_cast<std::uint32_t>(image.height) };
-    result.pixels = image.image;
+        if (!scales.empty())
+        {
+            result[i] = glm::scale(result[i], scales[i]);
+        }
+    }
 
-    return std::make_shared<Core::Texture>(result);
+    return result;
 }
 
 glm::mat4
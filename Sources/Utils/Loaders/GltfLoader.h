@@ -1,11 +1,14 @@
 #pragma once
 
 #include <filesystem>
+#include <span>
 
 #include <tiny_gltf.h>
 
 #include <Core/SceneNode.h>
 #include <Core/Types.h>
+#include <Utils/Loaders/AccessorReader.h>
+#include <Utils/MappedFile.h>
 
 namespace Lucid::Loaders
 {
@@ -16,21 +19,60 @@ public:
     static Core::SceneNodePtr Load(const std::filesystem::path& path);
 
 private:
-    struct BufferData
+    /*
+            Parsed model together with the memory its buffers live in.
+            The GLB binary chunk is read straight from the mapped file, tinygltf's copy of it is released after parsing.
+            Per load caches keyed by glTF index: every image, material and mesh is resolved once,
+            so nodes and primitives referencing the same index share one Core::Texture or Core::Mesh.
+    */
+    struct Document
     {
-        const std::uint8_t* data;
-        std::size_t stride;
-        std::size_t count;
-        std::int32_t type;
+        tinygltf::Model gltf;
+        MappedFilePtr file;
+        std::vector<std::span<const std::uint8_t>> buffers;
+
+        // Encoded bytes of images that don't live in a buffer view, collected while parsing
+        std::vector<std::vector<unsigned char>> encodedImages;
+
+        std::vector<Core::TexturePtr> images; // Per image
+        std::vector<Core::TexturePtr> materials; // Per material, base color texture
+        std::vector<std::vector<Core::MeshPtr>> meshes; // Per mesh, one entry per primitive
     };
-    static std::optional<BufferData>
-    GetBufferData(const tinygltf::Model& gltf, std::int32_t meshId, const std::string& attribute);
+
+    static void Parse(Document& document, const std::filesystem::path& path);
+    static std::span<const std::uint8_t> FindBinaryChunk(const MappedFile& file);
+    static void Decode(Document& document);
+
+    // tinygltf image callback, keeps the encoded bytes so that decoding can run in parallel later
+    static bool StoreImage(
+        tinygltf::Image* image,
+        int imageId,
+        std::string* error,
+        std::string* warning,
+        int requestedWidth,
+        int requestedHeight,
+        const unsigned char* bytes,
+        int size,
+        void* userData);
+
+    static std::optional<AccessorReader::Accessor>
+    GetAccessor(const Document& document, const tinygltf::Primitive& primitive, const std::string& attribute);
+    static AccessorReader::Accessor GetAccessor(
+        const Document& document,
+        std::size_t accessorId,
+        std::size_t expectedComponents,
+        const std::string& attribute);
 
     static Core::SceneNodePtr
-    TraverseFn(const tinygltf::Model& gltf, const tinygltf::Node& node, Core::SceneNodePtr parent);
-    static Core::MeshPtr MeshFn(const tinygltf::Model& gltf, std::int32_t meshId);
-    static Core::TexturePtr TextureFn(const tinygltf::Model& gltf, std::int32_t meshId);
+    TraverseFn(const Document& document, const tinygltf::Node& node, const Core::SceneNodePtr& parent);
+    static std::vector<Core::MeshPtr> MeshFn(const Document& document, std::int32_t meshId);
+    static Core::MeshPtr PrimitiveFn(const Document& document, const tinygltf::Primitive& primitive);
+    static Core::TexturePtr ImageFn(const Document& document, std::size_t imageId);
+    static Core::TexturePtr MaterialFn(const Document& document, const tinygltf::Material& material);
     static glm::mat4 TransformFn(const tinygltf::Node& node);
+
+    // EXT_mesh_gpu_instancing transforms relative to the node, empty when the node isn't instanced
+    static std::vector<glm::mat4> InstancesFn(const Document& document, const tinygltf::Node& node);
 };
 
 } // namespace Lucid::Loaders
@@ -0,0 +1,350 @@
+#include "Ktx2Loader.h"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace Lucid::Loaders
+{
+
+namespace
+{
+
+const std::array<std::uint8_t, 12> Identifier
+    = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+// Vulkan format values, the container stores them verbatim
+const std::uint32_t FormatR8G8B8A8Srgb = 43;
+const std::uint32_t FormatBc1RgbSrgbBlock = 132;
+const std::uint32_t FormatBc7SrgbBlock = 146;
+
+// Khronos data format descriptor values
+const std::uint32_t ColorModelRgbsda = 1;
+const std::uint32_t ColorModelBc1a = 128;
+const std::uint32_t ColorModelBc7 = 134;
+const std::uint32_t PrimariesBt709 = 1;
+const std::uint32_t TransferSrgb = 2;
+const std::uint32_t ChannelAlphaLinear = 0x1F;
+
+struct Header
+{
+    std::array<std::uint8_t, 12> identifier;
+    std::uint32_t vkFormat;
+    std::uint32_t typeSize;
+    std::uint32_t pixelWidth;
+    std::uint32_t pixelHeight;
+    std::uint32_t pixelDepth;
+    std::uint32_t layerCount;
+    std::uint32_t faceCount;
+    std::uint32_t levelCount;
+    std::uint32_t supercompressionScheme;
+    std::uint32_t dfdByteOffset;
+    std::uint32_t dfdByteLength;
+    std::uint32_t kvdByteOffset;
+    std::uint32_t kvdByteLength;
+    std::uint64_t sgdByteOffset;
+    std::uint64_t sgdByteLength;
+};
+
+struct LevelIndex
+{
+    std::uint64_t byteOffset;
+    std::uint64_t byteLength;
+    std::uint64_t uncompressedByteLength;
+};
+
+static_assert(sizeof(Header) == 80, "KTX2 header must be 80 bytes");
+static_assert(sizeof(LevelIndex) == 24, "KTX2 level index entry must be 24 bytes");
+
+std::uint64_t
+AlignUp(std::uint64_t value, std::uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+std::uint64_t
+LevelAlignment(Core::TextureFormat format)
+{
+    // lcm(texel block size, 4)
+    switch (format)
+    {
+    case Core::TextureFormat::Rgba8Srgb:
+        return 4;
+    case Core::TextureFormat::Bc1Srgb:
+        return 8;
+    case Core::TextureFormat::Bc7Srgb:
+        return 16;
+    }
+
+    return 4;
+}
+
+} // namespace
+
+Core::TexturePtr
+Ktx2Loader::Load(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Can't open ktx2 file: " + path.string());
+    }
+
+    Header header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!file || header.identifier != Identifier)
+    {
+        throw std::runtime_error("Can't load ktx2, invalid identifier: " + path.string());
+    }
+
+    if (header.supercompressionScheme != 0)
+    {
+        throw std::runtime_error("Can't load ktx2, supercompression isn't supported: " + path.string());
+    }
+
+    if (header.pixelDepth > 1 || header.layerCount > 1 || (header.faceCount != 1 && header.faceCount != 6))
+    {
+        throw std::runtime_error("Can't load ktx2, only 2D textures and cubemaps are supported: " + path.string());
+    }
+
+    if (header.pixelWidth == 0 || header.pixelHeight == 0)
+    {
+        throw std::runtime_error("Can't load ktx2, width or height == 0");
+    }
+
+    auto texture = std::make_shared<Core::Texture>();
+    texture->size = { header.pixelWidth, header.pixelHeight };
+    texture->format = FromVulkanFormat(header.vkFormat);
+    texture->layers = header.faceCount;
+
+    std::uint32_t storedLevels = std::max(header.levelCount, 1u);
+    std::vector<LevelIndex> levels(storedLevels);
+    file.read(reinterpret_cast<char*>(levels.data()), static_cast<std::streamsize>(levels.size() * sizeof(LevelIndex)));
+
+    if (!file)
+    {
+        throw std::runtime_error("Can't load ktx2, file is truncated: " + path.string());
+    }
+
+    std::uint64_t fileSize = std::filesystem::file_size(path);
+
+    for (std::uint32_t i = 0; i < storedLevels; i++)
+    {
+        if (levels.at(i).byteLength != texture->LevelByteSize(i) * texture->layers)
+        {
+            throw std::runtime_error("Can't load ktx2, unexpected level size: " + path.string());
+        }
+
+        if (levels.at(i).byteOffset + levels.at(i).byteLength > fileSize)
+        {
+            throw std::runtime_error("Can't load ktx2, file is truncated: " + path.string());
+        }
+    }
+
+    if (header.levelCount == 0)
+    {
+        // Zero levels means the consumer should generate the mip chain itself
+        texture->mipLevels
+            = static_cast<std::uint32_t>(std::floor(std::log2(std::max(header.pixelWidth, header.pixelHeight)))) + 1;
+    }
+    else
+    {
+        texture->mipLevels = header.levelCount;
+        texture->ComputeLevelOffsets();
+    }
+
+    // Level data is read straight into the destination, usually mapped staging memory
+    texture->decoder = [path, levels, offsets = texture->levelOffsets](unsigned char* destination)
+    {
+        std::ifstream levelFile(path, std::ios::binary);
+
+        for (std::size_t i = 0; i < levels.size(); i++)
+        {
+            levelFile.seekg(static_cast<std::streamoff>(levels.at(i).byteOffset));
+            levelFile.read(
+                reinterpret_cast<char*>(destination + (offsets.empty() ? 0 : offsets.at(i))),
+                static_cast<std::streamsize>(levels.at(i).byteLength));
+        }
+
+        if (!levelFile)
+        {
+            throw std::runtime_error("Can't load ktx2, file is truncated: " + path.string());
+        }
+    };
+
+    return texture;
+}
+
+void
+Ktx2Loader::Save(const std::filesystem::path& path, const Core::Texture& texture)
+{
+    if (!texture.IsDecoded())
+    {
+        throw std::runtime_error("Can't save ktx2, texture isn't decoded: " + path.string());
+    }
+
+    if (texture.layers != 1 && texture.layers != 6)
+    {
+        throw std::runtime_error("Can't save ktx2, only 2D textures and cubemaps are supported: " + path.string());
+    }
+
+    std::uint32_t levelCount = texture.HasMipChain() ? texture.mipLevels : 1;
+    std::vector<std::uint32_t> dfd = CreateDataFormatDescriptor(texture.format);
+
+    Header header {};
+    header.identifier = Identifier;
+    header.vkFormat = ToVulkanFormat(texture.format);
+    header.typeSize = 1;
+    header.pixelWidth = texture.size.x;
+    header.pixelHeight = texture.size.y;
+    header.faceCount = texture.layers;
+    header.levelCount = levelCount;
+    header.dfdByteOffset = static_cast<std::uint32_t>(sizeof(Header) + levelCount * sizeof(LevelIndex));
+    header.dfdByteLength = static_cast<std::uint32_t>(dfd.size() * sizeof(std::uint32_t));
+
+    // Level data is stored from the smallest level to the largest one
+    std::vector<LevelIndex> levels(levelCount);
+    std::uint64_t cursor = header.dfdByteOffset + header.dfdByteLength;
+
+    for (std::uint32_t i = levelCount; i-- > 0;)
+    {
+        std::uint64_t size = texture.LevelByteSize(i) * texture.layers;
+        cursor = AlignUp(cursor, LevelAlignment(texture.format));
+        levels.at(i) = { cursor, size, size };
+        cursor += size;
+    }
+
+    if (std::filesystem::path parent = path.parent_path(); !parent.empty())
+    {
+        std::filesystem::create_directories(parent);
+    }
+
+    // Written next to the final name and renamed, a crash never leaves a partial file behind
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Can't create ktx2 file: " + temporary.string());
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(
+            reinterpret_cast<const char*>(levels.data()),
+            static_cast<std::streamsize>(levels.size() * sizeof(LevelIndex)));
+        file.write(reinterpret_cast<const char*>(dfd.data()), static_cast<std::streamsize>(header.dfdByteLength));
+
+        std::uint64_t written = header.dfdByteOffset + header.dfdByteLength;
+        const std::array<char, 16> padding {};
+
+        for (std::uint32_t i = levelCount; i-- > 0;)
+        {
+            const LevelIndex& level = levels.at(i);
+            file.write(padding.data(), static_cast<std::streamsize>(level.byteOffset - written));
+
+            std::size_t offset = texture.levelOffsets.empty() ? 0 : texture.levelOffsets.at(i);
+            file.write(
+                reinterpret_cast<const char*>(texture.pixels.data() + offset),
+                static_cast<std::streamsize>(level.byteLength));
+
+            written = level.byteOffset + level.byteLength;
+        }
+
+        if (!file)
+        {
+            throw std::runtime_error("Can't write ktx2 file: " + temporary.string());
+        }
+    }
+
+    std::filesystem::rename(temporary, path);
+}
+
+std::uint32_t
+Ktx2Loader::ToVulkanFormat(Core::TextureFormat format)
+{
+    switch (format)
+    {
+    case Core::TextureFormat::Rgba8Srgb:
+        return FormatR8G8B8A8Srgb;
+    case Core::TextureFormat::Bc1Srgb:
+        return FormatBc1RgbSrgbBlock;
+    case Core::TextureFormat::Bc7Srgb:
+        return FormatBc7SrgbBlock;
+    }
+
+    throw std::runtime_error("Unknown texture format");
+}
+
+Core::TextureFormat
+Ktx2Loader::FromVulkanFormat(std::uint32_t format)
+{
+    switch (format)
+    {
+    case FormatR8G8B8A8Srgb:
+        return Core::TextureFormat::Rgba8Srgb;
+    case FormatBc1RgbSrgbBlock:
+        return Core::TextureFormat::Bc1Srgb;
+    case FormatBc7SrgbBlock:
+        return Core::TextureFormat::Bc7Srgb;
+    default:
+        throw std::runtime_error("Can't load ktx2, unsupported format " + std::to_string(format));
+    }
+}
+
+std::vector<std::uint32_t>
+Ktx2Loader::CreateDataFormatDescriptor(Core::TextureFormat format)
+{
+    // Basic descriptor block: sample = { bitOffset | bitLength << 16 | channel << 24, position, lower, upper }
+    std::uint32_t colorModel = ColorModelRgbsda;
+    std::uint32_t blockDimensions = 0;
+    std::uint32_t bytesPlane = 4;
+    std::vector<std::array<std::uint32_t, 4>> samples;
+
+    switch (format)
+    {
+    case Core::TextureFormat::Rgba8Srgb:
+        samples = { { 0 | (7u << 16) | (0u << 24), 0, 0, 255 },
+                    { 8 | (7u << 16) | (1u << 24), 0, 0, 255 },
+                    { 16 | (7u << 16) | (2u << 24), 0, 0, 255 },
+                    { 24 | (7u << 16) | (ChannelAlphaLinear << 24), 0, 0, 255 } };
+        break;
+    case Core::TextureFormat::Bc1Srgb:
+        colorModel = ColorModelBc1a;
+        blockDimensions = 3 | (3u << 8);
+        bytesPlane = 8;
+        samples = { { 0 | (63u << 16), 0, 0, 0xFFFFFFFF } };
+        break;
+    case Core::TextureFormat::Bc7Srgb:
+        colorModel = ColorModelBc7;
+        blockDimensions = 3 | (3u << 8);
+        bytesPlane = 16;
+        samples = { { 0 | (127u << 16), 0, 0, 0xFFFFFFFF } };
+        break;
+    }
+
+    std::uint32_t blockSize = static_cast<std::uint32_t>(24 + samples.size() * 16);
+    std::vector<std::uint32_t> result = {
+        4 + blockSize,
+        0,
+        2 | (blockSize << 16),
+        colorModel | (PrimariesBt709 << 8) | (TransferSrgb << 16),
+        blockDimensions,
+        bytesPlane,
+        0,
+    };
+
+    for (const auto& sample : samples)
+    {
+        result.insert(result.end(), sample.begin(), sample.end());
+    }
+
+    return result;
+}
+
+} // namespace Lucid::Loaders
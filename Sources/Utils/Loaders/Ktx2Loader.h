@@ -0,0 +1,26 @@
+#pragma once
+
+#include <filesystem>
+
+#include <Core/Types.h>
+
+namespace Lucid::Loaders
+{
+
+/*
+        Minimal KTX2 container support for cooked textures.
+        Handles 2D textures and cubemaps with uncompressed RGBA8 or BC1/BC7 payloads, without supercompression.
+*/
+class Ktx2Loader
+{
+public:
+    static Core::TexturePtr Load(const std::filesystem::path& path);
+    static void Save(const std::filesystem::path& path, const Core::Texture& texture);
+
+private:
+    static std::uint32_t ToVulkanFormat(Core::TextureFormat format);
+    static Core::TextureFormat FromVulkanFormat(std::uint32_t format);
+    static std::vector<std::uint32_t> CreateDataFormatDescriptor(Core::TextureFormat format);
+};
+
+} // namespace Lucid::Loaders
@@ -0,0 +1,415 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace Lucid::Loaders
+{
+
+namespace
+{
+
+const std::uint32_t Unused = std::numeric_limits<std::uint32_t>::max();
+
+// FIFO cache modelled with timestamps, a vertex is cached while fewer than size misses happened since its own
+class CacheSimulator
+{
+public:
+    CacheSimulator(std::size_t vertexCount, std::size_t size)
+        : mTimestamps(vertexCount, 0)
+        , mTime(size + 1)
+        , mSize(size)
+    {
+    }
+
+    bool Access(std::uint32_t vertex)
+    {
+        if (mTime - mTimestamps[vertex] > mSize)
+        {
+            mTimestamps[vertex] = mTime++;
+            return false;
+        }
+
+        return true;
+    }
+
+    void Flush() { mTime += mSize + 1; }
+
+private:
+    std::vector<std::size_t> mTimestamps;
+    std::size_t mTime;
+    std::size_t mSize;
+};
+
+void
+ValidateIndices(std::span<const std::uint32_t> indices, std::size_t vertexCount)
+{
+    if (indices.size() % 3 != 0)
+    {
+        throw std::runtime_error("Can't optimize mesh, index count is not a multiple of three");
+    }
+
+    if (std::any_of(indices.begin(), indices.end(), [vertexCount](std::uint32_t i) { return i >= vertexCount; }))
+    {
+        throw std::runtime_error("Can't optimize mesh, index is out of range");
+    }
+}
+
+} // namespace
+
+double
+MeshOptimizer::Statistics::Acmr() const
+{
+    return triangles > 0 ? static_cast<double>(misses) / static_cast<double>(triangles) : 0.0;
+}
+
+double
+MeshOptimizer::Statistics::Atvr() const
+{
+    return vertices > 0 ? static_cast<double>(misses) / static_cast<double>(vertices) : 0.0;
+}
+
+MeshOptimizer::Statistics&
+MeshOptimizer::Statistics::operator+=(const Statistics& other)
+{
+    triangles += other.triangles;
+    vertices += other.vertices;
+    misses += other.misses;
+    return *this;
+}
+
+void
+MeshOptimizer::Optimize(Core::Mesh& mesh)
+{
+    ValidateIndices(mesh.indices, mesh.vertices.size());
+
+    std::vector<std::size_t> clusters = MeshOptimizer::OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+    MeshOptimizer::OptimizeOverdraw(mesh.indices, mesh.vertices, clusters);
+    MeshOptimizer::OptimizeVertexFetch(mesh);
+}
+
+MeshOptimizer::Statistics
+MeshOptimizer::AnalyzeVertexCache(
+    std::span<const std::uint32_t> indices,
+    std::size_t vertexCount,
+    std::size_t cacheSize)
+{
+    Statistics result;
+    result.triangles = indices.size() / 3;
+
+    CacheSimulator cache(vertexCount, cacheSize);
+    std::vector<bool> referenced(vertexCount, false);
+
+    for (std::uint32_t index : indices)
+    {
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            result.vertices++;
+        }
+
+        if (!cache.Access(index))
+        {
+            result.misses++;
+        }
+    }
+
+    return result;
+}
+
+std::vector<std::size_t>
+MeshOptimizer::OptimizeVertexCache(std::vector<std::uint32_t>& indices, std::size_t vertexCount, std::size_t cacheSize)
+{
+    std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        return {};
+    }
+
+    // Vertex to triangle adjacency in compressed rows
+    std::vector<std::uint32_t> liveTriangles(vertexCount, 0);
+    for (std::uint32_t index : indices)
+    {
+        liveTriangles[index]++;
+    }
+
+    std::vector<std::size_t> offsets(vertexCount + 1, 0);
+    std::inclusive_scan(liveTriangles.begin(), liveTriangles.end(), offsets.begin() + 1, std::plus<std::size_t>());
+
+    std::vector<std::uint32_t> adjacency(indices.size());
+    std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < indices.size(); i++)
+    {
+        adjacency[fill[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+    }
+
+    std::vector<std::size_t> timestamps(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<std::uint32_t> deadEnd;
+    std::vector<std::uint32_t> candidates;
+    std::vector<std::uint32_t> result;
+    std::vector<std::size_t> clusters = { 0 };
+    result.reserve(indices.size());
+
+    std::size_t time = cacheSize + 1;
+    std::size_t cursor = 0;
+    std::uint32_t fanning = indices.front();
+
+    while (fanning != Unused)
+    {
+        candidates.clear();
+
+        // Emit every remaining triangle around the fanning vertex
+        for (std::size_t a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+        {
+            std::uint32_t triangle = adjacency[a];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+
+            for (std::size_t corner = 0; corner < 3; corner++)
+            {
+                std::uint32_t vertex = indices[triangle * 3 + corner];
+                result.push_back(vertex);
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+
+                if (time - timestamps[vertex] > cacheSize)
+                {
+                    timestamps[vertex] = time++;
+                }
+            }
+
+            emitted[triangle] = true;
+        }
+
+        // Prefer the candidate that stays in cache longest while its remaining fan is emitted
+        std::uint32_t next = Unused;
+        std::size_t bestPriority = 0;
+
+        for (std::uint32_t vertex : candidates)
+        {
+            if (liveTriangles[vertex] == 0)
+            {
+                continue;
+            }
+
+            std::size_t age = time - timestamps[vertex];
+            std::size_t priority = age + 2 * liveTriangles[vertex] <= cacheSize ? age : 0;
+
+            if (next == Unused || priority > bestPriority)
+            {
+                next = vertex;
+                bestPriority = priority;
+            }
+        }
+
+        if (next != Unused)
+        {
+            fanning = next;
+            continue;
+        }
+
+        // Dead end, the next fan starts from a recently used vertex or the first unfinished one in input order
+        while (!deadEnd.empty() && liveTriangles[deadEnd.back()] == 0)
+        {
+            deadEnd.pop_back();
+        }
+
+        if (!deadEnd.empty())
+        {
+            fanning = deadEnd.back();
+            deadEnd.pop_back();
+        }
+        else
+        {
+            while (cursor < vertexCount && liveTriangles[cursor] == 0)
+            {
+                cursor++;
+            }
+
+            fanning = cursor < vertexCount ? static_cast<std::uint32_t>(cursor) : Unused;
+        }
+
+        if (fanning != Unused && time - timestamps[fanning] > cacheSize)
+        {
+            clusters.push_back(result.size() / 3);
+        }
+    }
+
+    indices = std::move(result);
+    return clusters;
+}
+
+void
+MeshOptimizer::OptimizeOverdraw(
+    std::vector<std::uint32_t>& indices,
+    const std::vector<Core::Vertex>& vertices,
+    const std::vector<std::size_t>& clusters,
+    float threshold)
+{
+    std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || clusters.empty())
+    {
+        return;
+    }
+
+    std::vector<std::size_t> boundaries = MeshOptimizer::SplitClusters(indices, vertices.size(), clusters, threshold);
+    boundaries.push_back(triangleCount);
+
+    struct Cluster
+    {
+        std::size_t begin;
+        std::size_t end;
+        float key;
+    };
+
+    std::vector<Cluster> sorted;
+    sorted.reserve(boundaries.size() - 1);
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+
+    std::vector<glm::vec3> centroids;
+    std::vector<glm::vec3> normals;
+
+    for (std::size_t c = 0; c + 1 < boundaries.size(); c++)
+    {
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+
+        for (std::size_t t = boundaries[c]; t < boundaries[c + 1]; t++)
+        {
+            const glm::vec3& a = vertices[indices[t * 3 + 0]].position;
+            const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& d = vertices[indices[t * 3 + 2]].position;
+
+            glm::vec3 cross = glm::cross(b - a, d - a);
+            float triangleArea = glm::length(cross);
+
+            centroid += (a + b + d) * (triangleArea / 3.0f);
+            normal += cross;
+            area += triangleArea;
+        }
+
+        meshCentroid += centroid;
+        meshArea += area;
+
+        centroids.push_back(area > 0.0f ? centroid / area : centroid);
+        normals.push_back(glm::length(normal) > 0.0f ? glm::normalize(normal) : normal);
+    }
+
+    meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+    // Clusters facing away from the center occlude the rest of the mesh more often, they are drawn first
+    for (std::size_t c = 0; c + 1 < boundaries.size(); c++)
+    {
+        float key = glm::dot(centroids[c] - meshCentroid, normals[c]);
+        sorted.push_back({ boundaries[c], boundaries[c + 1], key });
+    }
+
+    std::stable_sort(
+        sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.key > b.key; });
+
+    std::vector<std::uint32_t> result;
+    result.reserve(indices.size());
+
+    for (const Cluster& cluster : sorted)
+    {
+        result.insert(
+            result.end(),
+            indices.data() + cluster.begin * 3,
+            indices.data() + cluster.end * 3);
+    }
+
+    indices = std::move(result);
+}
+
+void
+MeshOptimizer::OptimizeVertexFetch(Core::Mesh& mesh)
+{
+    std::vector<std::uint32_t> remap(mesh.vertices.size(), Unused);
+    std::vector<Core::Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    for (std::uint32_t& index : mesh.indices)
+    {
+        if (remap[index] == Unused)
+        {
+            remap[index] = static_cast<std::uint32_t>(vertices.size());
+            vertices.push_back(mesh.vertices[index]);
+        }
+
+        index = remap[index];
+    }
+
+    mesh.vertices = std::move(vertices);
+}
+
+std::vector<std::size_t>
+MeshOptimizer::SplitClusters(
+    std::span<const std::uint32_t> indices,
+    std::size_t vertexCount,
+    const std::vector<std::size_t>& clusters,
+    float threshold)
+{
+    std::size_t triangleCount = indices.size() / 3;
+    std::vector<std::size_t> result;
+    CacheSimulator cache(vertexCount, CacheSize);
+
+    auto misses = [&indices, &cache](std::size_t triangle)
+    {
+        std::size_t count = 0;
+        for (std::size_t corner = 0; corner < 3; corner++)
+        {
+            count += cache.Access(indices[triangle * 3 + corner]) ? 0u : 1u;
+        }
+        return count;
+    };
+
+    for (std::size_t c = 0; c < clusters.size(); c++)
+    {
+        std::size_t begin = clusters[c];
+        std::size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+        // Reference efficiency of the whole cluster
+        cache.Flush();
+        std::size_t clusterMisses = 0;
+        for (std::size_t t = begin; t < end; t++)
+        {
+            clusterMisses += misses(t);
+        }
+
+        double limit = static_cast<double>(clusterMisses) / static_cast<double>(end - begin)
+                       * static_cast<double>(threshold);
+
+        // Soft boundaries wherever the prefix already reached that efficiency, each piece starts cold
+        cache.Flush();
+        result.push_back(begin);
+
+        std::size_t start = begin;
+        std::size_t pieceMisses = 0;
+
+        for (std::size_t t = begin; t < end; t++)
+        {
+            pieceMisses += misses(t);
+
+            if (t + 1 < end && static_cast<double>(pieceMisses) / static_cast<double>(t + 1 - start) <= limit)
+            {
+                result.push_back(t + 1);
+                start = t + 1;
+                pieceMisses = 0;
+                cache.Flush();
+            }
+        }
+    }
+
+    return result;
+}
+
+} // namespace Lucid::Loaders
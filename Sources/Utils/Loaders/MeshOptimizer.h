@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <Core/Types.h>
+
+namespace Lucid::Loaders
+{
+
+/*
+        Reorders imported meshes for the GPU: Tipsify vertex cache order, overdraw aware cluster order
+        and finally vertex fetch order. Triangles keep their winding, only their order changes.
+*/
+class MeshOptimizer
+{
+public:
+    static const std::size_t CacheSize = 16;
+
+    // Simulated FIFO post transform cache counters
+    struct Statistics
+    {
+        std::size_t triangles = 0;
+        std::size_t vertices = 0; // Distinct vertices referenced by the indices
+        std::size_t misses = 0; // Vertex shader invocations
+
+        [[nodiscard]] double Acmr() const;
+        [[nodiscard]] double Atvr() const;
+
+        Statistics& operator+=(const Statistics& other);
+    };
+
+    // Runs all passes in place
+    static void Optimize(Core::Mesh& mesh);
+
+    static Statistics AnalyzeVertexCache(
+        std::span<const std::uint32_t> indices,
+        std::size_t vertexCount,
+        std::size_t cacheSize = CacheSize);
+
+    // Tipsify reorder, returns the first triangle of every cluster it ended up with a cold cache
+    static std::vector<std::size_t> OptimizeVertexCache(
+        std::vector<std::uint32_t>& indices,
+        std::size_t vertexCount,
+        std::size_t cacheSize = CacheSize);
+
+    // Splits clusters where the local cache efficiency allows it and sorts them outside in
+    static void OptimizeOverdraw(
+        std::vector<std::uint32_t>& indices,
+        const std::vector<Core::Vertex>& vertices,
+        const std::vector<std::size_t>& clusters,
+        float threshold = 1.05f);
+
+    // Stores vertices in first use order and drops the unreferenced ones
+    static void OptimizeVertexFetch(Core::Mesh& mesh);
+
+private:
+    static std::vector<std::size_t> SplitClusters(
+        std::span<const std::uint32_t> indices,
+        std::size_t vertexCount,
+        const std::vector<std::size_t>& clusters,
+        float threshold);
+};
+
+} // namespace Lucid::Loaders
@@ -0,0 +1,845 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+
+#include <Utils/Loaders/MeshOptimizer.h>
+#include <Utils/ThreadPool.h>
+
+namespace Lucid::Loaders
+{
+
+namespace
+{
+
+using Point = std::array<double, 3>;
+
+// Normals, uvs and colors, pre multiplied by their weights
+const std::size_t AttributeCount = 8;
+using Attributes = std::array<double, AttributeCount>;
+
+const double NormalWeight = 0.5;
+const double UvWeight = 1.0;
+const double ColorWeight = 0.5;
+
+// Keeps open borders in place, planes through border edges count this much more than surface area
+const double BorderWeight = 10.0;
+
+// A level that keeps more than this share of its source triangles is not worth storing
+const double MinReduction = 0.85;
+const std::size_t MinTriangles = 128;
+
+// Edges evaluated per thread pool task
+const std::size_t CandidateGrain = 16384;
+
+enum class VertexKind : std::uint8_t
+{
+    Manifold, // Collapses anywhere
+    Border, // Collapses along the open border
+    Seam, // Two wedges with different attributes, collapses along the seam
+    Locked,
+};
+
+Point
+Subtract(const Point& a, const Point& b)
+{
+    return { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+}
+
+Point
+Cross(const Point& a, const Point& b)
+{
+    return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+}
+
+Point
+Scaled(const glm::vec3& v, double scale)
+{
+    return { static_cast<double>(v.x) * scale, static_cast<double>(v.y) * scale, static_cast<double>(v.z) * scale };
+}
+
+double
+Dot(const Point& a, const Point& b)
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// Area weighted sum of squared distances to planes, evaluated as p^T A p + 2 b^T p + c
+struct Quadric
+{
+    std::array<double, 6> a {}; // a00 a11 a22 a10 a20 a21
+    Point b {};
+    double c = 0.0;
+    double w = 0.0;
+
+    static Quadric FromPlane(const Point& normal, double distance, double weight)
+    {
+        Quadric q;
+        q.a = { normal[0] * normal[0], normal[1] * normal[1], normal[2] * normal[2],
+                normal[1] * normal[0], normal[2] * normal[0], normal[2] * normal[1] };
+        std::transform(q.a.begin(), q.a.end(), q.a.begin(), [weight](double v) { return v * weight; });
+        q.b = { normal[0] * distance * weight, normal[1] * distance * weight, normal[2] * distance * weight };
+        q.c = distance * distance * weight;
+        q.w = weight;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& other)
+    {
+        for (std::size_t i = 0; i < a.size(); i++)
+        {
+            a[i] += other.a[i];
+        }
+        for (std::size_t i = 0; i < b.size(); i++)
+        {
+            b[i] += other.b[i];
+        }
+        c += other.c;
+        w += other.w;
+        return *this;
+    }
+
+    [[nodiscard]] double Evaluate(const Point& p) const
+    {
+        double quadratic = a[0] * p[0] * p[0] + a[1] * p[1] * p[1] + a[2] * p[2] * p[2]
+            + 2.0 * (a[3] * p[0] * p[1] + a[4] * p[0] * p[2] + a[5] * p[1] * p[2]);
+        return quadratic + 2.0 * Dot(b, p) + c;
+    }
+};
+
+// Squared deviation of wedge attributes from the linear attribute fields of the surrounding triangles
+struct AttributeQuadric
+{
+    Quadric geometry; // Sum of w (g.p + d)^2 over all attributes
+    std::array<Point, AttributeCount> gradients {};
+    Attributes offsets {};
+
+    static AttributeQuadric
+    FromTriangle(const std::array<Point, 3>& points, const std::array<const Attributes*, 3>& values, double weight)
+    {
+        AttributeQuadric q;
+        q.geometry.w = weight;
+
+        Point e1 = Subtract(points[1], points[0]);
+        Point e2 = Subtract(points[2], points[0]);
+        double d11 = Dot(e1, e1), d12 = Dot(e1, e2), d22 = Dot(e2, e2);
+        double determinant = d11 * d22 - d12 * d12;
+
+        if (determinant <= std::numeric_limits<double>::epsilon())
+        {
+            return q;
+        }
+
+        for (std::size_t k = 0; k < AttributeCount; k++)
+        {
+            // Gradient in the triangle plane reproducing the attribute at all three corners
+            double delta1 = (*values[1])[k] - (*values[0])[k];
+            double delta2 = (*values[2])[k] - (*values[0])[k];
+            double alpha = (d22 * delta1 - d12 * delta2) / determinant;
+            double beta = (d11 * delta2 - d12 * delta1) / determinant;
+
+            Point g = { alpha * e1[0] + beta * e2[0], alpha * e1[1] + beta * e2[1], alpha * e1[2] + beta * e2[2] };
+            double d = (*values[0])[k] - Dot(g, points[0]);
+
+            q.geometry.a[0] += weight * g[0] * g[0];
+            q.geometry.a[1] += weight * g[1] * g[1];
+            q.geometry.a[2] += weight * g[2] * g[2];
+            q.geometry.a[3] += weight * g[1] * g[0];
+            q.geometry.a[4] += weight * g[2] * g[0];
+            q.geometry.a[5] += weight * g[2] * g[1];
+            q.geometry.b = { q.geometry.b[0] + weight * g[0] * d,
+                             q.geometry.b[1] + weight * g[1] * d,
+                             q.geometry.b[2] + weight * g[2] * d };
+            q.geometry.c += weight * d * d;
+
+            q.gradients[k] = { weight * g[0], weight * g[1], weight * g[2] };
+            q.offsets[k] = weight * d;
+        }
+
+        return q;
+    }
+
+    AttributeQuadric& operator+=(const AttributeQuadric& other)
+    {
+        geometry += other.geometry;
+        for (std::size_t k = 0; k < AttributeCount; k++)
+        {
+            for (std::size_t i = 0; i < 3; i++)
+            {
+                gradients[k][i] += other.gradients[k][i];
+            }
+            offsets[k] += other.offsets[k];
+        }
+        return *this;
+    }
+
+    [[nodiscard]] double Evaluate(const Point& p, const Attributes& values) const
+    {
+        double result = geometry.Evaluate(p);
+        for (std::size_t k = 0; k < AttributeCount; k++)
+        {
+            result += geometry.w * values[k] * values[k] - 2.0 * values[k] * (Dot(gradients[k], p) + offsets[k]);
+        }
+        return result;
+    }
+};
+
+// Compressed rows, e.g. outgoing edges per vertex or triangles per position
+struct Adjacency
+{
+    std::vector<std::size_t> offsets;
+    std::vector<std::uint32_t> data;
+
+    [[nodiscard]] std::span<const std::uint32_t> Row(std::uint32_t i) const
+    {
+        return { data.data() + offsets[i], data.data() + offsets[i + 1] };
+    }
+};
+
+Adjacency
+BuildAdjacency(
+    std::size_t rows,
+    std::span<const std::uint32_t> keys,
+    const std::function<std::uint32_t(std::size_t)>& value)
+{
+    Adjacency result;
+    result.offsets.assign(rows + 1, 0);
+    for (std::uint32_t key : keys)
+    {
+        result.offsets[key + 1]++;
+    }
+
+    std::partial_sum(result.offsets.begin(), result.offsets.end(), result.offsets.begin());
+    result.data.resize(keys.size());
+
+    std::vector<std::size_t> fill(result.offsets.begin(), result.offsets.end() - 1);
+    for (std::size_t i = 0; i < keys.size(); i++)
+    {
+        result.data[fill[keys[i]]++] = value(i);
+    }
+
+    return result;
+}
+
+class Simplifier
+{
+public:
+    Simplifier(const std::vector<Core::Vertex>& vertices, std::span<const std::uint32_t> indices);
+
+    double Run(std::size_t targetIndexCount);
+    std::vector<std::uint32_t>& Indices() { return mIndices; }
+
+private:
+    struct Collapse
+    {
+        std::uint32_t from;
+        std::uint32_t to;
+        std::uint32_t siblingFrom; // Other wedge of a seam vertex, equal to from otherwise
+        std::uint32_t siblingTo;
+        double error;
+    };
+
+    void Weld();
+    void Rebuild();
+    void Classify();
+    void ComputeQuadrics();
+
+    bool HasEdge(std::uint32_t a, std::uint32_t b) const;
+    bool HasPositionEdge(std::uint32_t a, std::uint32_t b) const;
+    bool FindCollapse(std::uint32_t from, std::uint32_t to, Collapse& collapse) const;
+    bool Flips(const Collapse& collapse) const;
+    std::size_t RemovedTriangles(const Collapse& collapse) const;
+
+    std::vector<Point> mPoints;
+    std::vector<Attributes> mAttributes;
+    std::vector<std::uint32_t> mIndices;
+
+    std::vector<std::uint32_t> mRemap; // Vertex to the first vertex with the same position
+    std::vector<std::uint32_t> mWedges; // Ring of vertices sharing a position
+    std::vector<VertexKind> mKinds; // Per position
+    std::vector<Quadric> mPositionQuadrics; // Per position
+    std::vector<AttributeQuadric> mAttributeQuadrics; // Per vertex
+
+    Adjacency mOutgoing; // Directed triangle edges per vertex
+    Adjacency mTriangles; // Triangles per position
+};
+
+Simplifier::Simplifier(const std::vector<Core::Vertex>& vertices, std::span<const std::uint32_t> indices)
+    : mPoints(vertices.size())
+    , mAttributes(vertices.size())
+{
+    // Errors are measured in units of the bounding radius
+    glm::vec3 min = vertices.empty() ? glm::vec3(0.0f) : vertices.front().position;
+    glm::vec3 max = min;
+    for (const Core::Vertex& vertex : vertices)
+    {
+        min = glm::min(min, vertex.position);
+        max = glm::max(max, vertex.position);
+    }
+
+    glm::vec3 center = (min + max) * 0.5f;
+    float radius = glm::length(max - center);
+    double scale = radius > 0.0f ? 1.0 / static_cast<double>(radius) : 1.0;
+
+    for (std::size_t i = 0; i < vertices.size(); i++)
+    {
+        const Core::Vertex& vertex = vertices[i];
+        mPoints[i] = Scaled(vertex.position - center, scale);
+
+        Point normal = Scaled(vertex.normal, NormalWeight);
+        Point color = Scaled(vertex.color, ColorWeight);
+        mAttributes[i] = { normal[0],
+                           normal[1],
+                           normal[2],
+                           static_cast<double>(vertex.uv.x) * UvWeight,
+                           static_cast<double>(vertex.uv.y) * UvWeight,
+                           color[0],
+                           color[1],
+                           color[2] };
+    }
+
+    Weld();
+
+    // Triangles that are already degenerate in position would only confuse the classification
+    mIndices.reserve(indices.size());
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::uint32_t p0 = mRemap[indices[i]], p1 = mRemap[indices[i + 1]], p2 = mRemap[indices[i + 2]];
+        if (p0 != p1 && p1 != p2 && p0 != p2)
+        {
+            mIndices.insert(mIndices.end(), indices.begin() + static_cast<std::ptrdiff_t>(i),
+                            indices.begin() + static_cast<std::ptrdiff_t>(i + 3));
+        }
+    }
+
+    Rebuild();
+    Classify();
+    ComputeQuadrics();
+}
+
+double
+Simplifier::Run(std::size_t targetIndexCount)
+{
+    double maxError = 0.0;
+    std::vector<Collapse> candidates, collapses;
+    std::vector<std::uint8_t> valid;
+    std::vector<std::uint32_t> collapseRemap(mPoints.size());
+    std::vector<bool> locked(mPoints.size());
+
+    while (mIndices.size() > targetIndexCount)
+    {
+        // Every undirected edge once: interior edges from the smaller index, open edges exist only once anyway
+        candidates.resize(mIndices.size());
+        valid.assign(mIndices.size(), 0);
+
+        ThreadPool::Instance().ParallelFor(
+            mIndices.size(),
+            [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; i++)
+                {
+                    std::uint32_t a = mIndices[i];
+                    std::uint32_t b = mIndices[i % 3 == 2 ? i - 2 : i + 1];
+
+                    if (a > b && HasEdge(b, a))
+                    {
+                        continue;
+                    }
+
+                    // Only the cheaper direction competes
+                    Collapse forward {}, backward {};
+                    bool canForward = FindCollapse(a, b, forward);
+                    bool canBackward = FindCollapse(b, a, backward);
+
+                    if (canForward || canBackward)
+                    {
+                        bool useForward = canForward && (!canBackward || forward.error <= backward.error);
+                        candidates[i] = useForward ? forward : backward;
+                        valid[i] = 1;
+                    }
+                }
+            },
+            CandidateGrain);
+
+        collapses.clear();
+        for (std::size_t i = 0; i < candidates.size(); i++)
+        {
+            if (valid[i] != 0)
+            {
+                collapses.push_back(candidates[i]);
+            }
+        }
+
+        if (collapses.empty())
+        {
+            break;
+        }
+
+        std::sort(
+            collapses.begin(),
+            collapses.end(),
+            [](const Collapse& l, const Collapse& r) { return l.error < r.error; });
+
+        // A manifold collapse removes two triangles, past the goal only much worse collapses would be left
+        std::size_t goal = (mIndices.size() - targetIndexCount) / 3;
+        double limit = collapses[std::min(goal / 2, collapses.size() - 1)].error * 1.5;
+
+        std::iota(collapseRemap.begin(), collapseRemap.end(), 0u);
+        std::fill(locked.begin(), locked.end(), false);
+
+        std::size_t removed = 0;
+        std::size_t performed = 0;
+
+        for (const Collapse& collapse : collapses)
+        {
+            if (removed >= goal || (collapse.error > limit && performed > 0))
+            {
+                break;
+            }
+
+            std::uint32_t from = mRemap[collapse.from];
+            std::uint32_t to = mRemap[collapse.to];
+
+            if (locked[from] || locked[to] || Flips(collapse))
+            {
+                continue;
+            }
+
+            // Everything around the removed vertex changes, its neighbours wait for the next pass
+            for (std::uint32_t triangle : mTriangles.Row(from))
+            {
+                for (std::size_t corner = 0; corner < 3; corner++)
+                {
+                    locked[mRemap[mIndices[triangle * 3 + corner]]] = true;
+                }
+            }
+
+            removed += RemovedTriangles(collapse);
+            performed++;
+
+            collapseRemap[collapse.from] = collapse.to;
+            collapseRemap[collapse.siblingFrom] = collapse.siblingTo;
+            mPositionQuadrics[to] += mPositionQuadrics[from];
+            mAttributeQuadrics[collapse.to] += mAttributeQuadrics[collapse.from];
+            if (collapse.siblingFrom != collapse.from)
+            {
+                mAttributeQuadrics[collapse.siblingTo] += mAttributeQuadrics[collapse.siblingFrom];
+            }
+
+            maxError = std::max(maxError, collapse.error);
+        }
+
+        if (performed == 0)
+        {
+            break;
+        }
+
+        std::size_t write = 0;
+        for (std::size_t i = 0; i < mIndices.size(); i += 3)
+        {
+            std::uint32_t i0 = collapseRemap[mIndices[i]];
+            std::uint32_t i1 = collapseRemap[mIndices[i + 1]];
+            std::uint32_t i2 = collapseRemap[mIndices[i + 2]];
+
+            if (mRemap[i0] != mRemap[i1] && mRemap[i1] != mRemap[i2] && mRemap[i0] != mRemap[i2])
+            {
+                mIndices[write++] = i0;
+                mIndices[write++] = i1;
+                mIndices[write++] = i2;
+            }
+        }
+
+        mIndices.resize(write);
+        Rebuild();
+    }
+
+    return std::sqrt(maxError);
+}
+
+void
+Simplifier::Weld()
+{
+    std::size_t count = mPoints.size();
+    mRemap.resize(count);
+    mWedges.resize(count);
+
+    // Equal positions end up next to each other, the lowest index of every run represents it
+    std::vector<std::uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(
+        order.begin(), order.end(), [this](std::uint32_t a, std::uint32_t b) { return mPoints[a] < mPoints[b]; });
+
+    for (std::size_t begin = 0, end = 0; begin < count; begin = end)
+    {
+        while (end < count && mPoints[order[end]] == mPoints[order[begin]])
+        {
+            mRemap[order[end]] = order[begin];
+            mWedges[order[end]] = end + 1 < count ? order[end + 1] : order[begin];
+            end++;
+        }
+
+        // Close the ring
+        mWedges[order[end - 1]] = order[begin];
+    }
+}
+
+void
+Simplifier::Rebuild()
+{
+    std::vector<std::uint32_t> sources(mIndices.size());
+    std::vector<std::uint32_t> positions(mIndices.size());
+    for (std::size_t i = 0; i < mIndices.size(); i++)
+    {
+        sources[i] = mIndices[i];
+        positions[i] = mRemap[mIndices[i]];
+    }
+
+    mOutgoing = BuildAdjacency(
+        mPoints.size(),
+        sources,
+        [this](std::size_t i) { return mIndices[i % 3 == 2 ? i - 2 : i + 1]; });
+
+    mTriangles = BuildAdjacency(
+        mPoints.size(),
+        positions,
+        [](std::size_t i) { return static_cast<std::uint32_t>(i / 3); });
+}
+
+void
+Simplifier::Classify()
+{
+    std::size_t count = mPoints.size();
+    std::vector<std::uint32_t> openOut(count, 0), openIn(count, 0);
+    std::vector<std::uint32_t> positionOpenOut(count, 0), positionOpenIn(count, 0);
+    std::vector<bool> complex(count, false);
+
+    for (std::uint32_t a = 0; a < count; a++)
+    {
+        std::span<const std::uint32_t> row = mOutgoing.Row(a);
+
+        for (std::size_t i = 0; i < row.size(); i++)
+        {
+            std::uint32_t b = row[i];
+
+            // The same directed edge twice means more than two triangles share it
+            if (std::find(row.begin() + static_cast<std::ptrdiff_t>(i + 1), row.end(), b) != row.end())
+            {
+                complex[mRemap[a]] = true;
+                complex[mRemap[b]] = true;
+            }
+
+            if (!HasEdge(b, a))
+            {
+                openOut[a]++;
+                openIn[b]++;
+            }
+
+            if (!HasPositionEdge(mRemap[b], mRemap[a]))
+            {
+                positionOpenOut[mRemap[a]]++;
+                positionOpenIn[mRemap[b]]++;
+            }
+        }
+    }
+
+    mKinds.assign(count, VertexKind::Locked);
+
+    for (std::uint32_t p = 0; p < count; p++)
+    {
+        if (mRemap[p] != p || complex[p])
+        {
+            continue;
+        }
+
+        std::size_t ring = 1;
+        bool seam = openOut[p] == 1 && openIn[p] == 1;
+        for (std::uint32_t w = mWedges[p]; w != p; w = mWedges[w])
+        {
+            ring++;
+            seam = seam && openOut[w] == 1 && openIn[w] == 1;
+        }
+
+        if (positionOpenOut[p] > 0 || positionOpenIn[p] > 0)
+        {
+            bool border = ring == 1 && positionOpenOut[p] == 1 && positionOpenIn[p] == 1;
+            mKinds[p] = border ? VertexKind::Border : VertexKind::Locked;
+        }
+        else if (ring == 1)
+        {
+            mKinds[p] = VertexKind::Manifold;
+        }
+        else if (ring == 2 && seam)
+        {
+            mKinds[p] = VertexKind::Seam;
+        }
+    }
+}
+
+void
+Simplifier::ComputeQuadrics()
+{
+    mPositionQuadrics.assign(mPoints.size(), Quadric());
+    mAttributeQuadrics.assign(mPoints.size(), AttributeQuadric());
+
+    for (std::size_t i = 0; i < mIndices.size(); i += 3)
+    {
+        std::array<std::uint32_t, 3> corners = { mIndices[i], mIndices[i + 1], mIndices[i + 2] };
+        std::array<Point, 3> points = { mPoints[corners[0]], mPoints[corners[1]], mPoints[corners[2]] };
+
+        Point normal = Cross(Subtract(points[1], points[0]), Subtract(points[2], points[0]));
+        double length = std::sqrt(Dot(normal, normal));
+        if (length <= 0.0)
+        {
+            continue;
+        }
+
+        normal = { normal[0] / length, normal[1] / length, normal[2] / length };
+        double area = length * 0.5;
+
+        Quadric plane = Quadric::FromPlane(normal, -Dot(normal, points[0]), area);
+        AttributeQuadric attributes = AttributeQuadric::FromTriangle(
+            points, { &mAttributes[corners[0]], &mAttributes[corners[1]], &mAttributes[corners[2]] }, area);
+
+        for (std::size_t corner = 0; corner < 3; corner++)
+        {
+            mPositionQuadrics[mRemap[corners[corner]]] += plane;
+            mAttributeQuadrics[corners[corner]] += attributes;
+
+            // A plane perpendicular to the triangle through every open edge keeps the border from shrinking
+            std::uint32_t a = mRemap[corners[corner]];
+            std::uint32_t b = mRemap[corners[(corner + 1) % 3]];
+            if (HasPositionEdge(b, a))
+            {
+                continue;
+            }
+
+            Point edge = Subtract(mPoints[b], mPoints[a]);
+            Point side = Cross(edge, normal);
+            double sideLength = std::sqrt(Dot(side, side));
+            if (sideLength <= 0.0)
+            {
+                continue;
+            }
+
+            side = { side[0] / sideLength, side[1] / sideLength, side[2] / sideLength };
+            Quadric border = Quadric::FromPlane(side, -Dot(side, mPoints[a]), Dot(edge, edge) * BorderWeight);
+            mPositionQuadrics[a] += border;
+            mPositionQuadrics[b] += border;
+        }
+    }
+}
+
+bool
+Simplifier::HasEdge(std::uint32_t a, std::uint32_t b) const
+{
+    std::span<const std::uint32_t> row = mOutgoing.Row(a);
+    return std::find(row.begin(), row.end(), b) != row.end();
+}
+
+bool
+Simplifier::HasPositionEdge(std::uint32_t a, std::uint32_t b) const
+{
+    std::uint32_t w = a;
+    do
+    {
+        for (std::uint32_t next : mOutgoing.Row(w))
+        {
+            if (mRemap[next] == b)
+            {
+                return true;
+            }
+        }
+        w = mWedges[w];
+    } while (w != a);
+
+    return false;
+}
+
+bool
+Simplifier::FindCollapse(std::uint32_t from, std::uint32_t to, Collapse& collapse) const
+{
+    std::uint32_t pa = mRemap[from];
+    std::uint32_t pb = mRemap[to];
+
+    collapse.from = from;
+    collapse.to = to;
+    collapse.siblingFrom = from;
+    collapse.siblingTo = to;
+
+    switch (mKinds[pa])
+    {
+    case VertexKind::Manifold:
+        break;
+
+    case VertexKind::Border:
+        if (mKinds[pb] != VertexKind::Border || (HasPositionEdge(pa, pb) && HasPositionEdge(pb, pa)))
+        {
+            return false;
+        }
+        break;
+
+    case VertexKind::Seam:
+    {
+        if (mKinds[pb] != VertexKind::Seam || (HasEdge(from, to) && HasEdge(to, from)))
+        {
+            return false;
+        }
+
+        // The other wedge follows onto the wedge of the target on its side of the seam
+        collapse.siblingFrom = mWedges[from];
+        collapse.siblingTo = collapse.siblingFrom;
+
+        std::uint32_t w = pb;
+        do
+        {
+            if (w != to && (HasEdge(collapse.siblingFrom, w) || HasEdge(w, collapse.siblingFrom)))
+            {
+                collapse.siblingTo = w;
+            }
+            w = mWedges[w];
+        } while (w != pb);
+
+        if (collapse.siblingTo == collapse.siblingFrom)
+        {
+            return false;
+        }
+        break;
+    }
+
+    case VertexKind::Locked:
+        return false;
+    }
+
+    const Quadric& position = mPositionQuadrics[pa];
+    double error = position.w > 0.0 ? std::max(position.Evaluate(mPoints[pb]) / position.w, 0.0) : 0.0;
+
+    const AttributeQuadric& attributes = mAttributeQuadrics[from];
+    if (attributes.geometry.w > 0.0)
+    {
+        error += std::max(attributes.Evaluate(mPoints[pb], mAttributes[to]) / attributes.geometry.w, 0.0);
+    }
+
+    if (collapse.siblingFrom != from)
+    {
+        const AttributeQuadric& sibling = mAttributeQuadrics[collapse.siblingFrom];
+        if (sibling.geometry.w > 0.0)
+        {
+            double siblingError = sibling.Evaluate(mPoints[pb], mAttributes[collapse.siblingTo]);
+            error += std::max(siblingError / sibling.geometry.w, 0.0);
+        }
+    }
+
+    collapse.error = error;
+    return true;
+}
+
+bool
+Simplifier::Flips(const Collapse& collapse) const
+{
+    std::uint32_t pa = mRemap[collapse.from];
+    std::uint32_t pb = mRemap[collapse.to];
+
+    for (std::uint32_t triangle : mTriangles.Row(pa))
+    {
+        std::array<std::uint32_t, 3> corners;
+        for (std::size_t corner = 0; corner < 3; corner++)
+        {
+            corners[corner] = mRemap[mIndices[triangle * 3 + corner]];
+        }
+
+        // Triangles on the collapsed edge disappear
+        if (std::find(corners.begin(), corners.end(), pb) != corners.end())
+        {
+            continue;
+        }
+
+        auto normal = [this](const std::array<std::uint32_t, 3>& c)
+        { return Cross(Subtract(mPoints[c[1]], mPoints[c[0]]), Subtract(mPoints[c[2]], mPoints[c[0]])); };
+
+        Point before = normal(corners);
+        std::replace(corners.begin(), corners.end(), pa, pb);
+        Point after = normal(corners);
+
+        // Also rejects rotations past ~75 degrees, they leave slivers behind
+        if (Dot(before, after) < 0.25 * std::sqrt(Dot(before, before) * Dot(after, after)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::size_t
+Simplifier::RemovedTriangles(const Collapse& collapse) const
+{
+    std::uint32_t pb = mRemap[collapse.to];
+    std::span<const std::uint32_t> triangles = mTriangles.Row(mRemap[collapse.from]);
+
+    return static_cast<std::size_t>(std::count_if(
+        triangles.begin(),
+        triangles.end(),
+        [this, pb](std::uint32_t triangle)
+        {
+            return mRemap[mIndices[triangle * 3]] == pb || mRemap[mIndices[triangle * 3 + 1]] == pb
+                || mRemap[mIndices[triangle * 3 + 2]] == pb;
+        }));
+}
+
+} // namespace
+
+void
+MeshSimplifier::GenerateLods(Core::Mesh& mesh)
+{
+    mesh.lods.clear();
+
+    std::span<const std::uint32_t> source = mesh.indices;
+    float error = 0.0f;
+
+    while (mesh.lods.size() < MaxLods && source.size() / 3 >= MinTriangles * 2)
+    {
+        float levelError = 0.0f;
+        std::vector<std::uint32_t> indices = Simplify(mesh.vertices, source, source.size() / 6 * 3, &levelError);
+
+        if (static_cast<double>(indices.size()) > static_cast<double>(source.size()) * MinReduction)
+        {
+            break;
+        }
+
+        MeshOptimizer::OptimizeVertexCache(indices, mesh.vertices.size());
+
+        // Every level is simplified from the previous one, so their errors add up
+        error += levelError;
+
+        Core::MeshLod lod;
+        lod.indices = std::move(indices);
+        lod.error = error;
+        mesh.lods.push_back(std::move(lod));
+
+        source = mesh.lods.back().indices;
+    }
+}
+
+std::vector<std::uint32_t>
+MeshSimplifier::Simplify(
+    const std::vector<Core::Vertex>& vertices,
+    std::span<const std::uint32_t> indices,
+    std::size_t targetIndexCount,
+    float* error)
+{
+    Simplifier simplifier(vertices, indices);
+    double result = simplifier.Run(targetIndexCount);
+
+    if (error != nullptr)
+    {
+        *error = static_cast<float>(result);
+    }
+
+    return std::move(simplifier.Indices());
+}
+
+} // namespace Lucid::Loaders
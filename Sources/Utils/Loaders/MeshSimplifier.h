@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <Core/Types.h>
+
+namespace Lucid::Loaders
+{
+
+/*
+        Quadric error edge collapse simplification. Vertices only collapse onto their neighbours,
+        so every level indexes the original vertex buffer. Normals, uvs and colors add attribute
+        quadrics, open borders and uv seams only collapse along themselves.
+*/
+class MeshSimplifier
+{
+public:
+    static const std::size_t MaxLods = 4;
+
+    // Appends up to MaxLods levels to mesh.lods, each with about half the triangles of the previous one
+    static void GenerateLods(Core::Mesh& mesh);
+
+    // Collapses edges until at most targetIndexCount indices are left or no valid collapse remains.
+    // The reported error is the deviation relative to the bounding radius of the vertices.
+    static std::vector<std::uint32_t> Simplify(
+        const std::vector<Core::Vertex>& vertices,
+        std::span<const std::uint32_t> indices,
+        std::size_t targetIndexCount,
+        float* error = nullptr);
+};
+
+} // namespace Lucid::Loaders
@@ -0,0 +1,229 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace Lucid::Loaders
+{
+
+namespace
+{
+
+const std::uint32_t Unused = std::numeric_limits<std::uint32_t>::max();
+
+// Cones wider than this (cosine of the half angle) reject nothing in practice
+const float MinConeDot = 0.1f;
+
+// Candidates facing this close to the best one are taken in index order, which keeps the vertex cache order
+const float FacingTolerance = 0.1f;
+
+glm::vec3
+TriangleNormal(const Core::Mesh& mesh, std::size_t triangle)
+{
+    const glm::vec3& a = mesh.vertices[mesh.indices[triangle * 3]].position;
+    const glm::vec3& b = mesh.vertices[mesh.indices[triangle * 3 + 1]].position;
+    const glm::vec3& c = mesh.vertices[mesh.indices[triangle * 3 + 2]].position;
+
+    glm::vec3 normal = glm::cross(b - a, c - a);
+    float length = glm::length(normal);
+    return length > 0.0f ? normal / length : glm::vec3(0.0f);
+}
+
+} // namespace
+
+void
+MeshletBuilder::Build(Core::Mesh& mesh)
+{
+    std::size_t triangleCount = mesh.indices.size() / 3;
+    std::size_t vertexCount = mesh.vertices.size();
+
+    mesh.meshlets.clear();
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // Vertex to triangle adjacency in compressed rows
+    std::vector<std::size_t> offsets(vertexCount + 1, 0);
+    for (std::uint32_t index : mesh.indices)
+    {
+        offsets[index + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::vector<std::uint32_t> adjacency(mesh.indices.size());
+    std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < mesh.indices.size(); i++)
+    {
+        adjacency[fill[mesh.indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+    }
+
+    std::vector<glm::vec3> normals(triangleCount);
+    for (std::size_t t = 0; t < triangleCount; t++)
+    {
+        normals[t] = TriangleNormal(mesh, t);
+    }
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<std::uint32_t> owner(vertexCount, Unused); // Meshlet that last took the vertex
+    std::vector<std::uint32_t> candidates;
+    std::vector<std::uint32_t> result;
+    result.reserve(mesh.indices.size());
+
+    std::size_t cursor = 0;
+
+    while (result.size() < mesh.indices.size())
+    {
+        auto id = static_cast<std::uint32_t>(mesh.meshlets.size());
+        std::uint32_t vertices = 0;
+        std::uint32_t triangles = 0;
+        glm::vec3 facing(0.0f);
+
+        candidates.clear();
+
+        auto newVertices = [&](std::uint32_t triangle)
+        {
+            std::uint32_t count = 0;
+            for (std::size_t corner = 0; corner < 3; corner++)
+            {
+                count += owner[mesh.indices[triangle * 3 + corner]] == id ? 0u : 1u;
+            }
+            return count;
+        };
+
+        auto add = [&](std::uint32_t triangle)
+        {
+            for (std::size_t corner = 0; corner < 3; corner++)
+            {
+                std::uint32_t vertex = mesh.indices[triangle * 3 + corner];
+                result.push_back(vertex);
+
+                if (owner[vertex] != id)
+                {
+                    owner[vertex] = id;
+                    vertices++;
+                    candidates.insert(
+                        candidates.end(),
+                        adjacency.begin() + static_cast<std::ptrdiff_t>(offsets[vertex]),
+                        adjacency.begin() + static_cast<std::ptrdiff_t>(offsets[vertex + 1]));
+                }
+            }
+
+            emitted[triangle] = true;
+            facing += normals[triangle];
+            triangles++;
+        };
+
+        // Seed with the first free triangle, the input order is already spatially coherent
+        while (emitted[cursor])
+        {
+            cursor++;
+        }
+
+        Core::Meshlet meshlet;
+        meshlet.firstIndex = static_cast<std::uint32_t>(result.size());
+        add(static_cast<std::uint32_t>(cursor));
+
+        while (triangles < Core::Meshlet::MaxTriangles)
+        {
+            // Fewest new vertices first, then the triangle closest to the current facing, then the earliest one
+            std::uint32_t best = Unused;
+            std::uint32_t bestNew = 0;
+            float bestDot = 0.0f;
+            float facingLength = std::max(glm::length(facing), std::numeric_limits<float>::min());
+
+            std::erase_if(candidates, [&emitted](std::uint32_t triangle) { return emitted[triangle]; });
+
+            for (std::uint32_t triangle : candidates)
+            {
+                std::uint32_t added = newVertices(triangle);
+                if (vertices + added > Core::Meshlet::MaxVertices)
+                {
+                    continue;
+                }
+
+                float dot = glm::dot(normals[triangle], facing) / facingLength;
+                bool closer = dot > bestDot + FacingTolerance || (dot > bestDot - FacingTolerance && triangle < best);
+
+                if (best == Unused || added < bestNew || (added == bestNew && closer))
+                {
+                    best = triangle;
+                    bestNew = added;
+                    bestDot = dot;
+                }
+            }
+
+            if (best == Unused)
+            {
+                break;
+            }
+
+            add(best);
+        }
+
+        meshlet.indexCount = static_cast<std::uint32_t>(result.size()) - meshlet.firstIndex;
+        mesh.meshlets.push_back(meshlet);
+    }
+
+    mesh.indices = std::move(result);
+
+    for (Core::Meshlet& meshlet : mesh.meshlets)
+    {
+        ComputeBounds(mesh, meshlet);
+    }
+}
+
+void
+MeshletBuilder::ComputeBounds(const Core::Mesh& mesh, Core::Meshlet& meshlet)
+{
+    std::uint32_t end = meshlet.firstIndex + meshlet.indexCount;
+
+    glm::vec3 min = mesh.vertices[mesh.indices[meshlet.firstIndex]].position;
+    glm::vec3 max = min;
+    glm::vec3 axis(0.0f);
+
+    for (std::uint32_t i = meshlet.firstIndex; i < end; i++)
+    {
+        min = glm::min(min, mesh.vertices[mesh.indices[i]].position);
+        max = glm::max(max, mesh.vertices[mesh.indices[i]].position);
+
+        if (i % 3 == 0)
+        {
+            axis += TriangleNormal(mesh, i / 3);
+        }
+    }
+
+    glm::vec3 center = (min + max) * 0.5f;
+    float radius = 0.0f;
+    for (std::uint32_t i = meshlet.firstIndex; i < end; i++)
+    {
+        radius = std::max(radius, glm::length(mesh.vertices[mesh.indices[i]].position - center));
+    }
+
+    meshlet.boundingSphere = glm::vec4(center, radius);
+
+    float axisLength = glm::length(axis);
+    if (axisLength <= 0.0f)
+    {
+        return;
+    }
+
+    meshlet.coneAxis = axis / axisLength;
+
+    // Widest angle between the axis and any non degenerate triangle
+    float minDot = 1.0f;
+    for (std::uint32_t i = meshlet.firstIndex; i < end; i += 3)
+    {
+        glm::vec3 normal = TriangleNormal(mesh, i / 3);
+        if (glm::length(normal) > 0.0f)
+        {
+            minDot = std::min(minDot, glm::dot(normal, meshlet.coneAxis));
+        }
+    }
+
+    meshlet.coneCutoff = minDot > MinConeDot ? std::sqrt(1.0f - minDot * minDot) : 1.0f;
+}
+
+} // namespace Lucid::Loaders
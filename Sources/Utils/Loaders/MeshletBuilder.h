@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Core/Types.h>
+
+namespace Lucid::Loaders
+{
+
+/*
+        Splits meshes into meshlets of at most Meshlet::MaxVertices vertices and Meshlet::MaxTriangles triangles.
+        Meshlets grow over shared vertices and prefer triangles facing like the rest of the meshlet,
+        which keeps their normal cones narrow enough for back facing rejection.
+        Seeds and ties follow the input order, so an optimized index order mostly survives the split.
+*/
+class MeshletBuilder
+{
+public:
+    // Reorders mesh.indices meshlet by meshlet and fills mesh.meshlets
+    static void Build(Core::Mesh& mesh);
+
+private:
+    static void ComputeBounds(const Core::Mesh& mesh, Core::Meshlet& meshlet);
+};
+
+} // namespace Lucid::Loaders
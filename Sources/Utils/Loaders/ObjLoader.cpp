@@ -1,6 +1,14 @@
 #include "ObjLoader.h"
 
-#include <tiny_obj_loader.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#include <Utils/Files.h>
+#include <Utils/Loaders/VertexWelder.h>
+#include <Utils/Logger.hpp>
+#include <Utils/ThreadPool.h>
 
 namespace Lucid::Loaders
 {
@@ -8,45 +16,192 @@ namespace Lucid::Loaders
 Core::SceneNodePtr
 ObjLoader::Load(const std::filesystem::path& path)
 {
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string error, warning;
+    auto start = std::chrono::steady_clock::now();
+
+    ObjParser::Result obj = ObjParser::Parse(path);
+    MaterialTextures textures = LoadMaterials(path.parent_path(), obj.materialLibraries);
+
+    // Groups don't share vertices, so they are welded independently
+    std::vector<Core::MeshPtr> meshes(obj.groups.size());
+    std::atomic<std::size_t> uniqueVertices = 0;
+
+    ThreadPool::Instance().ParallelFor(
+        obj.groups.size(),
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                std::size_t unique = 0;
+                meshes.at(i) = std::make_shared<Core::Mesh>(BuildMesh(obj, obj.groups.at(i), unique));
+                uniqueVertices += unique;
+            }
+        });
+
+    Core::SceneNodePtr root = Core::SceneNode::Create("Root", nullptr);
 
-    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, path.string().c_str()))
+    for (std::size_t i = 0; i < obj.groups.size(); i++)
     {
-        throw std::runtime_error("Cant load model, error: " + error);
+        const ObjParser::Group& group = obj.groups.at(i);
+
+        // Materials have no notion of culling, open geometry like foliage quads is meant to be seen from both sides
+        meshes.at(i)->doubleSided = true;
+
+        if (auto texture = textures.find(group.material); texture != textures.end())
+        {
+            meshes.at(i)->texture = texture->second;
+        }
+        else if (!group.material.empty())
+        {
+            LoggerWarning << "No diffuse texture for material " << group.material;
+        }
+
+        std::string name = group.name.empty() ? "Group " + std::to_string(i) : group.name;
+        if (!group.material.empty())
+        {
+            name += " [" + group.material + "]";
+        }
+
+        Core::SceneNodePtr node = Core::SceneNode::Create(name, root);
+        node->SetMesh(meshes.at(i));
+        root->AddChildren(node);
     }
 
-    Core::Mesh mesh;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LoggerInfo << "Loaded " << obj.groups.size() << " groups, welded " << obj.corners.size() << " vertices into "
+               << uniqueVertices << " in " << elapsed.count() << " ms";
+
+    return root;
+}
+
+ObjLoader::MaterialTextures
+ObjLoader::LoadMaterials(const std::filesystem::path& directory, const std::vector<std::string>& libraries)
+{
+    TextureCache cache;
+    MaterialTextures result;
+
+    for (const auto& library : libraries)
+    {
+        try
+        {
+            LoadMaterialLibrary(directory / library, cache, result);
+        }
+        catch (const std::exception& ex)
+        {
+            LoggerWarning << "Ignoring material library " << library << ": " << ex.what();
+        }
+    }
+
+    return result;
+}
+
+void
+ObjLoader::LoadMaterialLibrary(const std::filesystem::path& path, TextureCache& cache, MaterialTextures& result)
+{
+    std::ifstream file(path);
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Can't open material library: " + path.string());
+    }
 
-    for (const auto& shape : shapes)
+    std::string material;
+    std::string line;
+
+    while (std::getline(file, line))
     {
-        for (const auto& index : shape.mesh.indices)
+        std::istringstream stream(line);
+        std::string keyword;
+        stream >> keyword;
+
+        std::string value;
+        std::getline(stream >> std::ws, value);
+        value.erase(value.find_last_not_of(" \t\r") + 1);
+
+        if (keyword == "newmtl")
+        {
+            material = value;
+        }
+        else if (keyword == "map_Kd" && !material.empty())
         {
-            Core::Vertex vertex;
+            // Texture options come first, the file name is the last token then
+            if (value.starts_with('-'))
+            {
+                value = value.substr(value.find_last_of(" \t") + 1);
+            }
 
-            vertex.position = { attrib.vertices[static_cast<std::size_t>(3 * index.vertex_index + 0)],
-                                attrib.vertices[static_cast<std::size_t>(3 * index.vertex_index + 1)],
-                                attrib.vertices[static_cast<std::size_t>(3 * index.vertex_index + 2)] };
+            if (Core::TexturePtr texture = LoadDiffuseTexture(path.parent_path(), value, cache))
+            {
+                result[material] = texture;
+            }
+        }
+    }
+}
 
-            vertex.normal = { attrib.normals[static_cast<std::size_t>(3 * index.normal_index + 0)],
-                              attrib.normals[static_cast<std::size_t>(3 * index.normal_index + 1)],
-                              attrib.normals[static_cast<std::size_t>(3 * index.normal_index + 2)] };
+Core::TexturePtr
+ObjLoader::LoadDiffuseTexture(const std::filesystem::path& directory, const std::string& name, TextureCache& cache)
+{
+    // Relative paths resolve against the .mtl, never the working directory. Appending keeps an absolute path as
+    // written, exporters often write those from the authoring machine, so fall back to the file name next to the .mtl
+    std::filesystem::path texturePath = name;
+    for (const auto& candidate : { directory / texturePath, directory / texturePath.filename() })
+    {
+        if (std::filesystem::exists(candidate))
+        {
+            std::filesystem::path key = std::filesystem::weakly_canonical(candidate);
 
-            vertex.uv = { attrib.texcoords[static_cast<std::size_t>(2 * index.texcoord_index + 0)],
-                          1.0f - attrib.texcoords[static_cast<std::size_t>(2 * index.texcoord_index + 1)] };
+            if (auto cached = cache.find(key); cached != cache.end())
+            {
+                return cached->second;
+            }
 
-            vertex.color = { 1.0f, 1.0f, 1.0f };
+            Core::TexturePtr texture = Files::LoadTexture(key);
+            cache.emplace(key, texture);
+            return texture;
+        }
+    }
+
+    LoggerWarning << "Can't find texture " << name;
+    return nullptr;
+}
+
+Core::Mesh
+ObjLoader::BuildMesh(const ObjParser::Result& obj, const ObjParser::Group& group, std::size_t& uniqueVertices)
+{
+    // Closed meshes reference every vertex about six times, a quarter leaves headroom for seams
+    Core::Mesh mesh;
+    mesh.indices.reserve(group.cornerCount);
+    mesh.vertices.reserve(group.cornerCount / 4);
+    VertexWelder welder(mesh.vertices, group.cornerCount / 4);
+
+    for (std::size_t i = group.firstCorner; i < group.firstCorner + group.cornerCount; i++)
+    {
+        const ObjParser::Corner& corner = obj.corners[i];
+        Core::Vertex vertex {};
 
-            mesh.vertices.push_back(vertex);
-            mesh.indices.push_back(static_cast<std::uint32_t>(mesh.indices.size()));
+        auto position = static_cast<std::size_t>(corner.position);
+        vertex.position = { obj.positions[3 * position + 0],
+                            obj.positions[3 * position + 1],
+                            obj.positions[3 * position + 2] };
+
+        if (corner.normal >= 0)
+        {
+            auto normal = static_cast<std::size_t>(corner.normal);
+            vertex.normal = { obj.normals[3 * normal + 0], obj.normals[3 * normal + 1], obj.normals[3 * normal + 2] };
         }
+
+        if (corner.uv >= 0)
+        {
+            auto uv = static_cast<std::size_t>(corner.uv);
+            vertex.uv = { obj.uvs[2 * uv + 0], 1.0f - obj.uvs[2 * uv + 1] };
+        }
+
+        vertex.color = { 1.0f, 1.0f, 1.0f };
+
+        mesh.indices.push_back(welder.Add(vertex));
     }
 
-    Core::SceneNodePtr node = Core::SceneNode::Create("Root", nullptr);
-    node->SetMesh(std::make_shared<Core::Mesh>(mesh));
-    return node;
+    uniqueVertices = welder.GetUniqueCount();
+    return mesh;
 }
 
 } // namespace Lucid::Loaders
@@ -1,18 +1,38 @@
 #pragma once
 
 #include <filesystem>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <Core/SceneNode.h>
+#include <Utils/Loaders/ObjParser.h>
 
 namespace Lucid::Loaders
 {
 
+/*
+        Loads a Wavefront OBJ as a root node with one child per object, group or material range.
+        Diffuse textures from the referenced .mtl files are loaded once and shared between the children.
+*/
 class ObjLoader
 {
 public:
     static Core::SceneNodePtr Load(const std::filesystem::path& path);
 
 private:
+    using MaterialTextures = std::unordered_map<std::string, Core::TexturePtr>;
+    using TextureCache = std::map<std::filesystem::path, Core::TexturePtr>;
+
+    static MaterialTextures
+    LoadMaterials(const std::filesystem::path& directory, const std::vector<std::string>& libraries);
+    static void LoadMaterialLibrary(const std::filesystem::path& path, TextureCache& cache, MaterialTextures& result);
+    static Core::TexturePtr
+    LoadDiffuseTexture(const std::filesystem::path& directory, const std::string& name, TextureCache& cache);
+
+    static Core::Mesh
+    BuildMesh(const ObjParser::Result& obj, const ObjParser::Group& group, std::size_t& uniqueVertices);
 };
 
 } // namespace Lucid::Loaders
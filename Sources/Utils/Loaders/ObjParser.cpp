@@ -0,0 +1,560 @@
+#include "ObjParser.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <Utils/MappedFile.h>
+#include <Utils/ThreadPool.h>
+
+namespace Lucid::Loaders
+{
+
+namespace
+{
+
+const std::size_t MinChunkSize = 1 << 20;
+
+const std::array<double, 23> PowersOfTen = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                             1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+// Relative (negative) indices can point into previous chunks, they are resolved once all chunks are counted
+struct Fixup
+{
+    std::size_t corner;
+    std::size_t component;
+    std::int64_t localIndex;
+};
+
+struct Event
+{
+    std::size_t corner;
+    bool material;
+    std::string name;
+};
+
+struct Chunk
+{
+    std::vector<float> positions;
+    std::vector<float> uvs;
+    std::vector<float> normals;
+
+    // Positive values are absolute one based indices, zero means missing or fixed up later
+    std::vector<std::array<std::int32_t, 3>> corners;
+    std::vector<Fixup> fixups;
+    std::vector<Event> events;
+    std::vector<std::string> materialLibraries;
+
+    // Corners of the face being parsed, reused between faces
+    std::vector<std::array<std::int64_t, 3>> face;
+};
+
+bool
+IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+bool
+IsDigit(char c)
+{
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// True when all eight bytes are ASCII digits
+bool
+IsEightDigits(std::uint64_t value)
+{
+    return (((value & 0xF0F0F0F0F0F0F0F0ull) | (((value + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4))
+            == 0x3333333333333333ull);
+}
+
+// Converts eight little endian ASCII digits with three multiplies instead of eight
+std::uint64_t
+ParseEightDigits(std::uint64_t value)
+{
+    value = (value & 0x0F0F0F0F0F0F0F0Full) * 2561 >> 8;
+    value = (value & 0x00FF00FF00FF00FFull) * 6553601 >> 16;
+    return (value & 0x0000FFFF0000FFFFull) * 42949672960001ull >> 32;
+}
+
+/*
+        Accumulates a run of digits into mantissa, eight at a time while enough input is left.
+        Digits that no longer fit are dropped and counted in dropped.
+*/
+const char*
+ParseDigits(const char* cursor, const char* end, std::uint64_t& mantissa, std::int32_t& digits, std::int32_t& dropped)
+{
+    while (end - cursor >= 8 && mantissa < 100000000000ull)
+    {
+        std::uint64_t chunk;
+        std::memcpy(&chunk, cursor, sizeof(chunk));
+
+        if (!IsEightDigits(chunk))
+        {
+            break;
+        }
+
+        mantissa = mantissa * 100000000 + ParseEightDigits(chunk);
+        digits += 8;
+        cursor += 8;
+    }
+
+    for (; cursor < end && IsDigit(*cursor); cursor++)
+    {
+        if (mantissa < 100000000000000000ull)
+        {
+            mantissa = mantissa * 10 + static_cast<std::uint64_t>(*cursor - '0');
+            digits++;
+        }
+        else
+        {
+            dropped++;
+        }
+    }
+
+    return cursor;
+}
+
+const char*
+ParseFloat(const char* cursor, const char* end, float& value)
+{
+    bool negative = cursor < end && *cursor == '-';
+    if (cursor < end && (*cursor == '-' || *cursor == '+'))
+    {
+        cursor++;
+    }
+
+    const char* start = cursor;
+    std::uint64_t mantissa = 0;
+    std::int32_t digits = 0;
+    std::int32_t dropped = 0;
+    std::int32_t exponent = 0;
+
+    cursor = ParseDigits(cursor, end, mantissa, digits, dropped);
+    exponent += dropped;
+
+    if (cursor < end && *cursor == '.')
+    {
+        std::int32_t fractionDigits = 0;
+        std::int32_t fractionDropped = 0;
+        cursor = ParseDigits(cursor + 1, end, mantissa, fractionDigits, fractionDropped);
+        exponent -= fractionDigits;
+    }
+
+    if (cursor == start || (cursor == start + 1 && *start == '.'))
+    {
+        throw std::runtime_error("Can't load obj, invalid number");
+    }
+
+    if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+    {
+        cursor++;
+        bool negativeExponent = cursor < end && *cursor == '-';
+        if (cursor < end && (*cursor == '-' || *cursor == '+'))
+        {
+            cursor++;
+        }
+
+        std::int32_t explicitExponent = 0;
+        for (; cursor < end && IsDigit(*cursor); cursor++)
+        {
+            explicitExponent = std::min(explicitExponent * 10 + (*cursor - '0'), 1000);
+        }
+
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+
+    double result = static_cast<double>(mantissa);
+
+    if (exponent < 0)
+    {
+        result = -exponent < static_cast<std::int32_t>(PowersOfTen.size())
+            ? result / PowersOfTen.at(static_cast<std::size_t>(-exponent))
+            : result * std::pow(10.0, exponent);
+    }
+    else if (exponent > 0)
+    {
+        result = exponent < static_cast<std::int32_t>(PowersOfTen.size())
+            ? result * PowersOfTen.at(static_cast<std::size_t>(exponent))
+            : result * std::pow(10.0, exponent);
+    }
+
+    value = static_cast<float>(negative ? -result : result);
+    return cursor;
+}
+
+const char*
+ParseInteger(const char* cursor, const char* end, std::int64_t& value)
+{
+    bool negative = cursor < end && *cursor == '-';
+    if (cursor < end && (*cursor == '-' || *cursor == '+'))
+    {
+        cursor++;
+    }
+
+    if (cursor == end || !IsDigit(*cursor))
+    {
+        throw std::runtime_error("Can't load obj, invalid index");
+    }
+
+    value = 0;
+    for (; cursor < end && IsDigit(*cursor); cursor++)
+    {
+        value = std::min<std::int64_t>(value * 10 + (*cursor - '0'), std::numeric_limits<std::int32_t>::max());
+    }
+
+    value = negative ? -value : value;
+    return cursor;
+}
+
+const char*
+SkipSpaces(const char* cursor, const char* end)
+{
+    while (cursor < end && IsSpace(*cursor))
+    {
+        cursor++;
+    }
+
+    return cursor;
+}
+
+const char*
+ParseFloats(const char* cursor, const char* end, std::size_t count, std::vector<float>& output)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        float value;
+        cursor = ParseFloat(SkipSpaces(cursor, end), end, value);
+        output.push_back(value);
+    }
+
+    return cursor;
+}
+
+std::string
+ParseName(const char* cursor, const char* end)
+{
+    cursor = SkipSpaces(cursor, end);
+    while (end > cursor && IsSpace(*(end - 1)))
+    {
+        end--;
+    }
+
+    return { cursor, end };
+}
+
+void
+ParseFace(const char* cursor, const char* end, Chunk& chunk)
+{
+    std::vector<std::array<std::int64_t, 3>>& face = chunk.face;
+    face.clear();
+
+    std::array<std::size_t, 3> counts
+        = { chunk.positions.size() / 3, chunk.uvs.size() / 2, chunk.normals.size() / 3 };
+
+    while ((cursor = SkipSpaces(cursor, end)) < end)
+    {
+        std::array<std::int64_t, 3> corner {};
+
+        for (std::size_t component = 0; component < 3; component++)
+        {
+            if (component > 0)
+            {
+                if (cursor == end || *cursor != '/')
+                {
+                    break;
+                }
+
+                // Skip empty components, e.g. the uv in p//n
+                if (++cursor < end && *cursor == '/')
+                {
+                    continue;
+                }
+            }
+
+            cursor = ParseInteger(cursor, end, corner.at(component));
+        }
+
+        face.push_back(corner);
+    }
+
+    if (face.size() < 3)
+    {
+        throw std::runtime_error("Can't load obj, face with less than 3 corners");
+    }
+
+    auto emit = [&chunk, &counts](const std::array<std::int64_t, 3>& corner)
+    {
+        std::array<std::int32_t, 3> stored {};
+
+        for (std::size_t component = 0; component < 3; component++)
+        {
+            std::int64_t index = corner.at(component);
+
+            if (index > 0)
+            {
+                stored.at(component) = static_cast<std::int32_t>(index);
+            }
+            else if (index < 0)
+            {
+                chunk.fixups.push_back(
+                    { chunk.corners.size(), component, static_cast<std::int64_t>(counts.at(component)) + index });
+            }
+        }
+
+        chunk.corners.push_back(stored);
+    };
+
+    for (std::size_t i = 1; i + 1 < face.size(); i++)
+    {
+        emit(face.at(0));
+        emit(face.at(i));
+        emit(face.at(i + 1));
+    }
+}
+
+bool
+StartsWithKeyword(const char* cursor, const char* end, std::string_view keyword)
+{
+    auto length = static_cast<std::ptrdiff_t>(keyword.size());
+    return end - cursor > length && std::memcmp(cursor, keyword.data(), keyword.size()) == 0
+        && IsSpace(cursor[length]);
+}
+
+void
+ParseChunk(std::string_view text, Chunk& chunk)
+{
+    const char* cursor = text.data();
+    const char* const textEnd = text.data() + text.size();
+
+    while (cursor < textEnd)
+    {
+        const void* newline = std::memchr(cursor, '\n', static_cast<std::size_t>(textEnd - cursor));
+        const char* lineEnd = newline == nullptr ? textEnd : static_cast<const char*>(newline);
+
+        const char* line = SkipSpaces(cursor, lineEnd);
+
+        try
+        {
+            if (StartsWithKeyword(line, lineEnd, "v"))
+            {
+                ParseFloats(line + 2, lineEnd, 3, chunk.positions);
+            }
+            else if (StartsWithKeyword(line, lineEnd, "vt"))
+            {
+                ParseFloats(line + 3, lineEnd, 2, chunk.uvs);
+            }
+            else if (StartsWithKeyword(line, lineEnd, "vn"))
+            {
+                ParseFloats(line + 3, lineEnd, 3, chunk.normals);
+            }
+            else if (StartsWithKeyword(line, lineEnd, "f"))
+            {
+                ParseFace(line + 2, lineEnd, chunk);
+            }
+            else if (StartsWithKeyword(line, lineEnd, "o") || StartsWithKeyword(line, lineEnd, "g"))
+            {
+                chunk.events.push_back({ chunk.corners.size(), false, ParseName(line + 2, lineEnd) });
+            }
+            else if (StartsWithKeyword(line, lineEnd, "usemtl"))
+            {
+                chunk.events.push_back({ chunk.corners.size(), true, ParseName(line + 7, lineEnd) });
+            }
+            else if (StartsWithKeyword(line, lineEnd, "mtllib"))
+            {
+                chunk.materialLibraries.push_back(ParseName(line + 7, lineEnd));
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            throw std::runtime_error(std::string(ex.what()) + ": " + std::string(line, lineEnd));
+        }
+
+        cursor = lineEnd + 1;
+    }
+}
+
+} // namespace
+
+ObjParser::Result
+ObjParser::Parse(const std::filesystem::path& path)
+{
+    MappedFile file(path);
+
+    try
+    {
+        return Parse(file.View());
+    }
+    catch (const std::exception& ex)
+    {
+        throw std::runtime_error(std::string(ex.what()) + " in " + path.string());
+    }
+}
+
+ObjParser::Result
+ObjParser::Parse(std::string_view text)
+{
+    std::vector<std::string_view> texts = SplitChunks(text);
+    std::vector<Chunk> chunks(texts.size());
+
+    ThreadPool::Instance().ParallelFor(
+        chunks.size(),
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                ParseChunk(texts.at(i), chunks.at(i));
+            }
+        });
+
+    // Every chunk gets its slice of the merged arrays, offsets are prefix sums of the chunk sizes
+    struct Offsets
+    {
+        std::size_t positions = 0;
+        std::size_t uvs = 0;
+        std::size_t normals = 0;
+        std::size_t corners = 0;
+    };
+
+    std::vector<Offsets> offsets(chunks.size() + 1);
+    for (std::size_t i = 0; i < chunks.size(); i++)
+    {
+        offsets.at(i + 1).positions = offsets.at(i).positions + chunks.at(i).positions.size();
+        offsets.at(i + 1).uvs = offsets.at(i).uvs + chunks.at(i).uvs.size();
+        offsets.at(i + 1).normals = offsets.at(i).normals + chunks.at(i).normals.size();
+        offsets.at(i + 1).corners = offsets.at(i).corners + chunks.at(i).corners.size();
+    }
+
+    const Offsets& total = offsets.back();
+    std::array<std::size_t, 3> counts = { total.positions / 3, total.uvs / 2, total.normals / 3 };
+
+    if (counts.at(0) > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+    {
+        throw std::runtime_error("Can't load obj, too many vertices");
+    }
+
+    Result result;
+    result.positions.resize(total.positions);
+    result.uvs.resize(total.uvs);
+    result.normals.resize(total.normals);
+    result.corners.resize(total.corners);
+
+    ThreadPool::Instance().ParallelFor(
+        chunks.size(),
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                Chunk& chunk = chunks.at(i);
+                const Offsets& offset = offsets.at(i);
+                std::array<std::int64_t, 3> bases = { static_cast<std::int64_t>(offset.positions / 3),
+                                                      static_cast<std::int64_t>(offset.uvs / 2),
+                                                      static_cast<std::int64_t>(offset.normals / 3) };
+
+                std::copy(chunk.positions.begin(), chunk.positions.end(), result.positions.data() + offset.positions);
+                std::copy(chunk.uvs.begin(), chunk.uvs.end(), result.uvs.data() + offset.uvs);
+                std::copy(chunk.normals.begin(), chunk.normals.end(), result.normals.data() + offset.normals);
+
+                for (const Fixup& fixup : chunk.fixups)
+                {
+                    std::int64_t index = bases.at(fixup.component) + fixup.localIndex;
+
+                    if (index < 0)
+                    {
+                        throw std::runtime_error("Can't load obj, relative face index is out of range");
+                    }
+
+                    chunk.corners.at(fixup.corner).at(fixup.component) = static_cast<std::int32_t>(
+                        std::min<std::int64_t>(index + 1, std::numeric_limits<std::int32_t>::max()));
+                }
+
+                Corner* destination = result.corners.data() + offset.corners;
+
+                for (const auto& corner : chunk.corners)
+                {
+                    std::array<std::int32_t, 3> resolved;
+
+                    for (std::size_t component = 0; component < 3; component++)
+                    {
+                        resolved.at(component) = corner.at(component) - 1;
+
+                        if (resolved.at(component) >= static_cast<std::int64_t>(counts.at(component))
+                            || (component == 0 && resolved.at(component) < 0))
+                        {
+                            throw std::runtime_error("Can't load obj, face index is out of range");
+                        }
+                    }
+
+                    *destination++ = { resolved.at(0), resolved.at(1), resolved.at(2) };
+                }
+
+                // Free chunk memory as soon as it is merged to keep the peak down
+                chunk.positions = {};
+                chunk.uvs = {};
+                chunk.normals = {};
+                chunk.corners = {};
+            }
+        });
+
+    // Groups change whenever an object, group or material statement is seen, empty ones are dropped
+    Group current { "", "", 0, 0 };
+
+    auto close = [&result, &current](std::size_t corner)
+    {
+        current.cornerCount = corner - current.firstCorner;
+        if (current.cornerCount > 0)
+        {
+            result.groups.push_back(current);
+        }
+
+        current.firstCorner = corner;
+    };
+
+    for (std::size_t i = 0; i < chunks.size(); i++)
+    {
+        for (Event& event : chunks.at(i).events)
+        {
+            close(offsets.at(i).corners + event.corner);
+            (event.material ? current.material : current.name) = std::move(event.name);
+        }
+
+        for (std::string& library : chunks.at(i).materialLibraries)
+        {
+            result.materialLibraries.push_back(std::move(library));
+        }
+    }
+
+    close(total.corners);
+
+    return result;
+}
+
+std::vector<std::string_view>
+ObjParser::SplitChunks(std::string_view text)
+{
+    // A few chunks per thread keeps the workers busy when some chunks are denser than others
+    std::size_t target = std::max(MinChunkSize, text.size() / (ThreadPool::Instance().GetThreadCount() * 4 + 1));
+    std::vector<std::string_view> chunks;
+
+    while (!text.empty())
+    {
+        std::size_t split = text.size();
+
+        if (text.size() > target)
+        {
+            std::size_t newline = text.find('\n', target);
+            split = newline == std::string_view::npos ? text.size() : newline + 1;
+        }
+
+        chunks.push_back(text.substr(0, split));
+        text.remove_prefix(split);
+    }
+
+    return chunks;
+}
+
+} // namespace Lucid::Loaders
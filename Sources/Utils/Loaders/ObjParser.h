@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Lucid::Loaders
+{
+
+/*
+        Native Wavefront OBJ parser for large assets.
+        The file is split into line aligned chunks that are parsed in parallel and merged into preallocated arrays.
+        Supports v, vt, vn, f (fan triangulated), o, g, usemtl and mtllib, everything else is skipped.
+*/
+class ObjParser
+{
+public:
+    // Zero based attribute indices of a triangle corner, -1 when the attribute is missing
+    struct Corner
+    {
+        std::int32_t position;
+        std::int32_t uv;
+        std::int32_t normal;
+    };
+
+    // Consecutive range of corners sharing the same object or group name and material
+    struct Group
+    {
+        std::string name;
+        std::string material;
+        std::size_t firstCorner;
+        std::size_t cornerCount;
+    };
+
+    struct Result
+    {
+        std::vector<float> positions; // xyz
+        std::vector<float> uvs; // uv
+        std::vector<float> normals; // xyz
+        std::vector<Corner> corners; // Three per triangle
+        std::vector<Group> groups;
+        std::vector<std::string> materialLibraries;
+    };
+
+    static Result Parse(const std::filesystem::path& path);
+    static Result Parse(std::string_view text);
+
+private:
+    static std::vector<std::string_view> SplitChunks(std::string_view text);
+};
+
+} // namespace Lucid::Loaders
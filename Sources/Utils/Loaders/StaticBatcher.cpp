@@ -0,0 +1,194 @@
+#include "StaticBatcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+namespace Lucid::Loaders
+{
+
+namespace
+{
+
+struct Candidate
+{
+    Core::SceneNodePtr node;
+    glm::mat4 transform { 1.0f }; // Relative to the batching root
+    glm::vec3 center { 0.0f }; // Of the transformed bounds
+};
+
+glm::vec3
+TransformedCenter(const Core::Mesh& mesh, const glm::mat4& transform)
+{
+    glm::vec3 min = mesh.vertices.front().position;
+    glm::vec3 max = min;
+
+    for (const Core::Vertex& vertex : mesh.vertices)
+    {
+        min = glm::min(min, vertex.position);
+        max = glm::max(max, vertex.position);
+    }
+
+    return glm::vec3(transform * glm::vec4((min + max) * 0.5f, 1.0f));
+}
+
+} // namespace
+
+StaticBatcher::Statistics
+StaticBatcher::Batch(const Core::SceneNodePtr& root)
+{
+    Statistics statistics;
+
+    // Nodes per mesh, shared meshes stay instanced
+    std::vector<Core::SceneNodePtr> nodes;
+    std::unordered_map<const Core::Mesh*, std::size_t> references;
+    std::vector<Core::SceneNodePtr> stack = { root };
+
+    while (!stack.empty())
+    {
+        Core::SceneNodePtr node = stack.back();
+        stack.pop_back();
+
+        if (node->GetOptionalMesh().has_value())
+        {
+            nodes.push_back(node);
+            references[node->GetOptionalMesh().value().get()]++;
+        }
+
+        stack.insert(stack.end(), node->GetChildren().begin(), node->GetChildren().end());
+    }
+
+    glm::mat4 toRoot = glm::inverse(root->GetTransform());
+    std::vector<Candidate> candidates;
+
+    for (const Core::SceneNodePtr& node : nodes)
+    {
+        const Core::Mesh& mesh = *node->GetOptionalMesh().value();
+        if (references.at(&mesh) != 1 || mesh.vertices.empty() || mesh.vertices.size() > MaxVertices)
+        {
+            continue;
+        }
+
+        Candidate candidate;
+        candidate.node = node;
+        candidate.transform = toRoot * node->GetTransform();
+        candidate.center = TransformedCenter(mesh, candidate.transform);
+        candidates.push_back(candidate);
+    }
+
+    if (candidates.size() < 2)
+    {
+        return statistics;
+    }
+
+    glm::vec3 min = candidates.front().center;
+    glm::vec3 max = min;
+    for (const Candidate& candidate : candidates)
+    {
+        min = glm::min(min, candidate.center);
+        max = glm::max(max, candidate.center);
+    }
+
+    // Edge of a cube holding NodesPerCell nodes on average, over the axes the nodes actually spread along
+    glm::vec3 extent = max - min;
+    float largest = std::max({ extent.x, extent.y, extent.z });
+    float volume = 1.0f;
+    float dimensions = 0.0f;
+
+    for (glm::length_t axis = 0; axis < 3; axis++)
+    {
+        if (extent[axis] > largest * 0.01f)
+        {
+            volume *= extent[axis];
+            dimensions += 1.0f;
+        }
+    }
+
+    auto cellCount = static_cast<float>(std::max<std::size_t>(candidates.size() / NodesPerCell, 1));
+    float edge = dimensions > 0.0f ? std::pow(volume / cellCount, 1.0f / dimensions) : 1.0f;
+
+    glm::vec3 cells(1.0f);
+    for (glm::length_t axis = 0; axis < 3; axis++)
+    {
+        cells[axis] = std::clamp(std::ceil(extent[axis] / edge), 1.0f, static_cast<float>(MaxCellsPerAxis));
+    }
+
+    glm::vec3 cellSize = glm::max(extent / cells, glm::vec3(1e-6f));
+
+    auto cellOf = [&](const glm::vec3& center)
+    {
+        glm::vec3 cell = glm::min(glm::floor((center - min) / cellSize), cells - glm::vec3(1.0f));
+        auto x = static_cast<std::size_t>(cell.x);
+        auto y = static_cast<std::size_t>(cell.y);
+        auto z = static_cast<std::size_t>(cell.z);
+        return (z * MaxCellsPerAxis + y) * MaxCellsPerAxis + x;
+    };
+
+    // Grouped by material first, then by cell
+    std::map<std::tuple<const Core::Texture*, bool, std::size_t>, std::vector<const Candidate*>> groups;
+    for (const Candidate& candidate : candidates)
+    {
+        const Core::Mesh& mesh = *candidate.node->GetOptionalMesh().value();
+        groups[{ mesh.texture.get(), mesh.doubleSided, cellOf(candidate.center) }].push_back(&candidate);
+    }
+
+    for (const auto& [key, members] : groups)
+    {
+        if (members.size() < 2)
+        {
+            continue;
+        }
+
+        auto batch = std::make_shared<Core::Mesh>();
+        batch->texture = members.front()->node->GetOptionalMesh().value()->texture;
+        batch->doubleSided = members.front()->node->GetOptionalMesh().value()->doubleSided;
+
+        for (const Candidate* member : members)
+        {
+            StaticBatcher::Append(*batch, *member->node->GetOptionalMesh().value(), member->transform);
+            member->node->ClearMesh();
+        }
+
+        Core::SceneNodePtr node = Core::SceneNode::Create("Batch " + std::to_string(statistics.batches), root);
+        node->SetMesh(batch);
+        root->AddChildren(node);
+
+        statistics.nodes += members.size();
+        statistics.batches++;
+    }
+
+    return statistics;
+}
+
+void
+StaticBatcher::Append(Core::Mesh& batch, const Core::Mesh& mesh, const glm::mat4& transform)
+{
+    auto base = static_cast<std::uint32_t>(batch.vertices.size());
+    glm::mat3 normalTransform = glm::transpose(glm::inverse(glm::mat3(transform)));
+
+    for (Core::Vertex vertex : mesh.vertices)
+    {
+        vertex.position = glm::vec3(transform * glm::vec4(vertex.position, 1.0f));
+
+        glm::vec3 normal = normalTransform * vertex.normal;
+        float length = glm::length(normal);
+        vertex.normal = length > 0.0f ? normal / length : vertex.normal;
+
+        batch.vertices.push_back(vertex);
+    }
+
+    // Mirroring transforms flip the winding, swap two corners to keep triangles front facing
+    bool mirrored = glm::determinant(glm::mat3(transform)) < 0.0f;
+
+    for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        batch.indices.push_back(base + mesh.indices[i]);
+        batch.indices.push_back(base + mesh.indices[mirrored ? i + 2 : i + 1]);
+        batch.indices.push_back(base + mesh.indices[mirrored ? i + 1 : i + 2]);
+    }
+}
+
+} // namespace Lucid::Loaders
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+#include <Core/SceneNode.h>
+#include <Core/Types.h>
+
+namespace Lucid::Loaders
+{
+
+/*
+        Merges small static meshes sharing a material into one mesh per spatial cell, with the node transforms baked
+        into the vertices. Cubic cells split the bounds of the model into about NodesPerCell nodes each,
+        so merged meshes still cull separately. Meshes referenced by several nodes are left to instancing.
+*/
+class StaticBatcher
+{
+public:
+    // Larger meshes already amortize their draw
+    static const std::size_t MaxVertices = 16384;
+    static const std::size_t NodesPerCell = 64;
+    static const std::size_t MaxCellsPerAxis = 16;
+
+    struct Statistics
+    {
+        std::size_t nodes = 0; // Nodes whose mesh went into a batch
+        std::size_t batches = 0;
+    };
+
+    // Moves the meshes of batched nodes under root into new children of root
+    static Statistics Batch(const Core::SceneNodePtr& root);
+
+private:
+    static void Append(Core::Mesh& batch, const Core::Mesh& mesh, const glm::mat4& transform);
+};
+
+} // namespace Lucid::Loaders
@@ -0,0 +1,119 @@
+#include "VertexWelder.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace Lucid::Loaders
+{
+
+namespace
+{
+
+const std::size_t VertexWords = sizeof(Core::Vertex) / sizeof(std::uint32_t);
+
+static_assert(sizeof(Core::Vertex) == VertexWords * sizeof(std::uint32_t), "Vertex must not contain padding");
+
+std::array<std::uint32_t, VertexWords>
+ToWords(const Core::Vertex& vertex)
+{
+    std::array<std::uint32_t, VertexWords> words;
+    std::memcpy(words.data(), &vertex, sizeof(vertex));
+    return words;
+}
+
+} // namespace
+
+VertexWelder::VertexWelder(std::vector<Core::Vertex>& vertices, std::size_t expectedVertices)
+    : mVertices(vertices)
+{
+    // Keep the load factor under one half for the expected number of unique vertices
+    Rehash(std::bit_ceil(std::max<std::size_t>(expectedVertices * 2, 16)));
+}
+
+std::uint32_t
+VertexWelder::Add(const Core::Vertex& vertex)
+{
+    mInputCount++;
+
+    Core::Vertex canonical = Canonicalize(vertex);
+
+    for (std::size_t slot = HashVertex(canonical) & mMask;; slot = (slot + 1) & mMask)
+    {
+        std::uint32_t index = mSlots[slot];
+
+        if (index == EmptySlot)
+        {
+            if (mVertices.size() >= EmptySlot)
+            {
+                throw std::runtime_error("Can't weld vertices, mesh has too many unique vertices");
+            }
+
+            index = static_cast<std::uint32_t>(mVertices.size());
+            mVertices.push_back(canonical);
+            mSlots[slot] = index;
+
+            if (mVertices.size() * 2 > mSlots.size())
+            {
+                Rehash(mSlots.size() * 2);
+            }
+
+            return index;
+        }
+
+        if (std::memcmp(&mVertices[index], &canonical, sizeof(canonical)) == 0)
+        {
+            return index;
+        }
+    }
+}
+
+std::uint64_t
+VertexWelder::HashVertex(const Core::Vertex& vertex)
+{
+    // Multiply-xorshift over the raw bits, much cheaper than a byte wise hash for 44 byte keys
+    std::uint64_t hash = 0x9E3779B97F4A7C15ull;
+
+    for (std::uint32_t word : ToWords(vertex))
+    {
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+    }
+
+    return hash;
+}
+
+Core::Vertex
+VertexWelder::Canonicalize(const Core::Vertex& vertex)
+{
+    // Negative zero compares equal to zero but has different bits, adding positive zero folds it
+    Core::Vertex result = vertex;
+    result.position += glm::vec3(0.0f);
+    result.normal += glm::vec3(0.0f);
+    result.color += glm::vec3(0.0f);
+    result.uv += glm::vec2(0.0f);
+    return result;
+}
+
+void
+VertexWelder::Rehash(std::size_t capacity)
+{
+    mSlots.assign(capacity, EmptySlot);
+    mMask = capacity - 1;
+
+    for (std::size_t i = 0; i < mVertices.size(); i++)
+    {
+        std::size_t slot = HashVertex(mVertices[i]) & mMask;
+
+        while (mSlots[slot] != EmptySlot)
+        {
+            slot = (slot + 1) & mMask;
+        }
+
+        mSlots[slot] = static_cast<std::uint32_t>(i);
+    }
+}
+
+} // namespace Lucid::Loaders
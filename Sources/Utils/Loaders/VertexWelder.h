@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <Core/Vertex.h>
+
+namespace Lucid::Loaders
+{
+
+/*
+        Merges bitwise identical vertices while a mesh is being built.
+        Unique vertices are appended in first seen order,
+        lookups go through an open addressing table with linear probing.
+*/
+class VertexWelder
+{
+public:
+    VertexWelder(std::vector<Core::Vertex>& vertices, std::size_t expectedVertices);
+
+    // Returns the index of the unique copy of vertex, appending it on first use
+    std::uint32_t Add(const Core::Vertex& vertex);
+
+    [[nodiscard]] std::size_t GetInputCount() const { return mInputCount; }
+    [[nodiscard]] std::size_t GetUniqueCount() const { return mVertices.size(); }
+
+private:
+    static const std::uint32_t EmptySlot = 0xFFFFFFFF;
+
+    static std::uint64_t HashVertex(const Core::Vertex& vertex);
+    static Core::Vertex Canonicalize(const Core::Vertex& vertex);
+
+    void Rehash(std::size_t capacity);
+
+    std::vector<Core::Vertex>& mVertices;
+    std::vector<std::uint32_t> mSlots;
+    std::size_t mMask = 0;
+    std::size_t mInputCount = 0;
+};
+
+} // namespace Lucid::Loaders
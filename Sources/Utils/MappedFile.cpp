@@ -0,0 +1,136 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Lucid
+{
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    HANDLE file = CreateFileW(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("Can't open file: " + path.string());
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        throw std::runtime_error("Can't get file size: " + path.string());
+    }
+
+    mSize = static_cast<std::size_t>(size.QuadPart);
+
+    // Empty files can't be mapped, they are represented by a null view
+    if (mSize == 0)
+    {
+        CloseHandle(file);
+        return;
+    }
+
+    mMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    // The mapping keeps its own reference to the file
+    CloseHandle(file);
+
+    if (mMapping == nullptr)
+    {
+        throw std::runtime_error("Can't map file: " + path.string());
+    }
+
+    mData = static_cast<const std::uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    if (mData == nullptr)
+    {
+        CloseHandle(mMapping);
+        throw std::runtime_error("Can't map file: " + path.string());
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData != nullptr)
+    {
+        UnmapViewOfFile(mData);
+    }
+
+    if (mMapping != nullptr)
+    {
+        CloseHandle(mMapping);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (file == -1)
+    {
+        throw std::runtime_error("Can't open file: " + path.string());
+    }
+
+    struct stat status;
+    if (fstat(file, &status) == -1)
+    {
+        close(file);
+        throw std::runtime_error("Can't get file size: " + path.string());
+    }
+
+    mSize = static_cast<std::size_t>(status.st_size);
+
+    // Empty files can't be mapped, they are represented by a null view
+    if (mSize == 0)
+    {
+        close(file);
+        return;
+    }
+
+    void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, file, 0);
+
+    // The mapping keeps its own reference to the file
+    close(file);
+
+    if (data == MAP_FAILED)
+    {
+        throw std::runtime_error("Can't map file: " + path.string());
+    }
+
+    // Loaders touch most of the file right away, start reading it in ahead of the first faults
+    madvise(data, mSize, MADV_WILLNEED);
+    mData = static_cast<const std::uint8_t*>(data);
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData != nullptr)
+    {
+        munmap(const_cast<std::uint8_t*>(mData), mSize);
+    }
+}
+
+#endif
+
+} // namespace Lucid
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace Lucid
+{
+
+/*
+        Read only view of a whole file mapped into the address space.
+        Pages are brought in from the page cache on first access, nothing is copied up front.
+*/
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] const std::uint8_t* Data() const { return mData; }
+    [[nodiscard]] std::size_t Size() const { return mSize; }
+    [[nodiscard]] std::span<const std::uint8_t> Bytes() const { return { mData, mSize }; }
+    [[nodiscard]] std::string_view View() const { return { reinterpret_cast<const char*>(mData), mSize }; }
+
+private:
+    const std::uint8_t* mData = nullptr;
+    std::size_t mSize = 0;
+
+#ifdef _WIN32
+    void* mMapping = nullptr;
+#endif
+};
+
+using MappedFilePtr = std::shared_ptr<const MappedFile>;
+
+} // namespace Lucid
@@ -0,0 +1,403 @@
+#include "BlockCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <Utils/ThreadPool.h>
+
+namespace Lucid::Textures
+{
+
+namespace
+{
+
+// BC7 4 bit index interpolation weights, out of 64
+const std::array<std::uint32_t, 16> Bc7Weights = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+template <std::size_t Channels> using Color = std::array<float, Channels>;
+
+/*
+        Fits a line through the block colors with a few power iterations over the covariance matrix
+        and returns the extreme projections as endpoints.
+*/
+template <std::size_t Channels>
+void
+FindEndpoints(const std::array<std::uint8_t, 64>& block, Color<Channels>& low, Color<Channels>& high)
+{
+    Color<Channels> mean {};
+    for (std::size_t i = 0; i < 16; i++)
+    {
+        for (std::size_t c = 0; c < Channels; c++)
+        {
+            mean[c] += static_cast<float>(block[i * 4 + c]) / 16.0f;
+        }
+    }
+
+    std::array<Color<Channels>, Channels> covariance {};
+    for (std::size_t i = 0; i < 16; i++)
+    {
+        for (std::size_t a = 0; a < Channels; a++)
+        {
+            for (std::size_t b = 0; b < Channels; b++)
+            {
+                covariance[a][b] += (static_cast<float>(block[i * 4 + a]) - mean[a])
+                    * (static_cast<float>(block[i * 4 + b]) - mean[b]);
+            }
+        }
+    }
+
+    Color<Channels> axis;
+    axis.fill(1.0f);
+
+    for (std::size_t iteration = 0; iteration < 8; iteration++)
+    {
+        Color<Channels> next {};
+        for (std::size_t a = 0; a < Channels; a++)
+        {
+            for (std::size_t b = 0; b < Channels; b++)
+            {
+                next[a] += covariance[a][b] * axis[b];
+            }
+        }
+
+        float norm = 0.0f;
+        for (float value : next)
+        {
+            norm = std::max(norm, std::abs(value));
+        }
+
+        if (norm < 1e-6f)
+        {
+            // Flat block, every texel matches the mean
+            low = mean;
+            high = mean;
+            return;
+        }
+
+        for (std::size_t c = 0; c < Channels; c++)
+        {
+            axis[c] = next[c] / norm;
+        }
+    }
+
+    float axisLength = 0.0f;
+    for (float value : axis)
+    {
+        axisLength += value * value;
+    }
+
+    float minProjection = std::numeric_limits<float>::max();
+    float maxProjection = std::numeric_limits<float>::lowest();
+
+    for (std::size_t i = 0; i < 16; i++)
+    {
+        float projection = 0.0f;
+        for (std::size_t c = 0; c < Channels; c++)
+        {
+            projection += (static_cast<float>(block[i * 4 + c]) - mean[c]) * axis[c];
+        }
+
+        projection /= axisLength;
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    for (std::size_t c = 0; c < Channels; c++)
+    {
+        low[c] = std::clamp(mean[c] + axis[c] * minProjection, 0.0f, 255.0f);
+        high[c] = std::clamp(mean[c] + axis[c] * maxProjection, 0.0f, 255.0f);
+    }
+}
+
+std::uint16_t
+ToRgb565(const Color<3>& color)
+{
+    auto r = static_cast<std::uint32_t>(std::lround(color[0] * 31.0f / 255.0f));
+    auto g = static_cast<std::uint32_t>(std::lround(color[1] * 63.0f / 255.0f));
+    auto b = static_cast<std::uint32_t>(std::lround(color[2] * 31.0f / 255.0f));
+    return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+}
+
+std::array<std::int32_t, 3>
+FromRgb565(std::uint16_t color)
+{
+    std::int32_t r = (color >> 11) & 31;
+    std::int32_t g = (color >> 5) & 63;
+    std::int32_t b = color & 31;
+    return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+}
+
+class BitWriter
+{
+public:
+    void Write(std::uint32_t value, std::uint32_t count)
+    {
+        for (std::uint32_t i = 0; i < count; i++, mPosition++)
+        {
+            if ((value >> i) & 1u)
+            {
+                mBits.at(mPosition / 64) |= 1ull << (mPosition % 64);
+            }
+        }
+    }
+
+    void Store(unsigned char* output) const { std::memcpy(output, mBits.data(), sizeof(mBits)); }
+
+private:
+    std::array<std::uint64_t, 2> mBits {};
+    std::uint32_t mPosition = 0;
+};
+
+} // namespace
+
+void
+BlockCompressor::Compress(
+    Core::TextureFormat format,
+    const unsigned char* pixels,
+    const Core::Vector2d<std::uint32_t>& size,
+    unsigned char* output)
+{
+    std::size_t blocksX = (size.x + 3) / 4;
+    std::size_t blocksY = (size.y + 3) / 4;
+    std::size_t blockSize = format == Core::TextureFormat::Bc1Srgb ? 8 : 16;
+
+    if (format == Core::TextureFormat::Rgba8Srgb)
+    {
+        throw std::runtime_error("Block compressor requires a block compressed format");
+    }
+
+    // Rows of blocks are independent, every task writes its own slice of the output
+    ThreadPool::Instance().ParallelFor(
+        blocksY,
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t y = begin; y < end; y++)
+            {
+                for (std::size_t x = 0; x < blocksX; x++)
+                {
+                    Block block
+                        = FetchBlock(pixels, size, static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y));
+                    unsigned char* destination = output + (y * blocksX + x) * blockSize;
+
+                    if (format == Core::TextureFormat::Bc1Srgb)
+                    {
+                        EncodeBc1(block, destination);
+                    }
+                    else
+                    {
+                        EncodeBc7(block, destination);
+                    }
+                }
+            }
+        },
+        std::max<std::size_t>(1, 256 / blocksX));
+}
+
+BlockCompressor::Block
+BlockCompressor::FetchBlock(
+    const unsigned char* pixels,
+    const Core::Vector2d<std::uint32_t>& size,
+    std::uint32_t blockX,
+    std::uint32_t blockY)
+{
+    Block block;
+
+    // Partial blocks at the right and bottom edges repeat the last texel
+    for (std::uint32_t y = 0; y < 4; y++)
+    {
+        std::size_t sourceY = std::min(blockY * 4 + y, size.y - 1);
+
+        for (std::uint32_t x = 0; x < 4; x++)
+        {
+            std::size_t sourceX = std::min(blockX * 4 + x, size.x - 1);
+            std::memcpy(&block.at((y * 4 + x) * 4), pixels + (sourceY * size.x + sourceX) * 4, 4);
+        }
+    }
+
+    return block;
+}
+
+void
+BlockCompressor::EncodeBc1(const Block& block, unsigned char* output)
+{
+    Color<3> low;
+    Color<3> high;
+    FindEndpoints<3>(block, low, high);
+
+    // Inset the endpoints slightly, the fitted line overshoots on noisy blocks
+    for (std::size_t c = 0; c < 3; c++)
+    {
+        float inset = (high[c] - low[c]) / 16.0f;
+        low[c] += inset;
+        high[c] -= inset;
+    }
+
+    std::uint16_t color0 = ToRgb565(high);
+    std::uint16_t color1 = ToRgb565(low);
+
+    // Four color mode requires color0 > color1
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    std::array<std::int32_t, 3> endpoint0 = FromRgb565(color0);
+    std::array<std::int32_t, 3> endpoint1 = FromRgb565(color1);
+    std::array<std::array<std::int32_t, 3>, 4> palette;
+
+    for (std::size_t c = 0; c < 3; c++)
+    {
+        palette[0][c] = endpoint0[c];
+        palette[1][c] = endpoint1[c];
+        palette[2][c] = (2 * endpoint0[c] + endpoint1[c]) / 3;
+        palette[3][c] = (endpoint0[c] + 2 * endpoint1[c]) / 3;
+    }
+
+    std::uint32_t indices = 0;
+
+    if (color0 != color1)
+    {
+        for (std::uint32_t i = 0; i < 16; i++)
+        {
+            std::uint32_t bestIndex = 0;
+            std::int32_t bestError = std::numeric_limits<std::int32_t>::max();
+
+            for (std::uint32_t candidate = 0; candidate < 4; candidate++)
+            {
+                std::int32_t error = 0;
+                for (std::size_t c = 0; c < 3; c++)
+                {
+                    std::int32_t delta = palette[candidate][c] - block[i * 4 + c];
+                    error += delta * delta;
+                }
+
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestIndex = candidate;
+                }
+            }
+
+            indices |= bestIndex << (i * 2);
+        }
+    }
+
+    std::memcpy(output, &color0, 2);
+    std::memcpy(output + 2, &color1, 2);
+    std::memcpy(output + 4, &indices, 4);
+}
+
+void
+BlockCompressor::EncodeBc7(const Block& block, unsigned char* output)
+{
+    Color<4> low;
+    Color<4> high;
+    FindEndpoints<4>(block, low, high);
+
+    // Mode 6 endpoints are 7 bits per channel plus one shared p-bit per endpoint
+    std::array<std::array<std::uint32_t, 4>, 2> quantized;
+    std::array<std::uint32_t, 2> pbits;
+    std::array<std::array<std::int32_t, 4>, 2> endpoints;
+
+    for (std::size_t e = 0; e < 2; e++)
+    {
+        const Color<4>& source = e == 0 ? low : high;
+        float bestError = std::numeric_limits<float>::max();
+
+        for (std::uint32_t pbit = 0; pbit < 2; pbit++)
+        {
+            std::array<std::uint32_t, 4> candidate;
+            float error = 0.0f;
+
+            for (std::size_t c = 0; c < 4; c++)
+            {
+                float value = std::clamp(std::round((source[c] - static_cast<float>(pbit)) / 2.0f), 0.0f, 127.0f);
+                candidate[c] = static_cast<std::uint32_t>(value);
+
+                float delta = static_cast<float>((candidate[c] << 1) | pbit) - source[c];
+                error += delta * delta;
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                quantized[e] = candidate;
+                pbits[e] = pbit;
+            }
+        }
+
+        for (std::size_t c = 0; c < 4; c++)
+        {
+            endpoints[e][c] = static_cast<std::int32_t>((quantized[e][c] << 1) | pbits[e]);
+        }
+    }
+
+    std::array<std::array<std::int32_t, 4>, 16> palette;
+    for (std::size_t i = 0; i < 16; i++)
+    {
+        std::int32_t weight = static_cast<std::int32_t>(Bc7Weights.at(i));
+        for (std::size_t c = 0; c < 4; c++)
+        {
+            palette[i][c] = ((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6;
+        }
+    }
+
+    std::array<std::uint32_t, 16> indices;
+    for (std::size_t i = 0; i < 16; i++)
+    {
+        std::int32_t bestError = std::numeric_limits<std::int32_t>::max();
+
+        for (std::uint32_t candidate = 0; candidate < 16; candidate++)
+        {
+            std::int32_t error = 0;
+            for (std::size_t c = 0; c < 4; c++)
+            {
+                std::int32_t delta = palette[candidate][c] - block[i * 4 + c];
+                error += delta * delta;
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                indices[i] = candidate;
+            }
+        }
+    }
+
+    // The anchor index is stored without its top bit, swap endpoints so that it is clear
+    if (indices[0] >= 8)
+    {
+        std::swap(quantized[0], quantized[1]);
+        std::swap(pbits[0], pbits[1]);
+
+        for (std::uint32_t& index : indices)
+        {
+            index = 15 - index;
+        }
+    }
+
+    BitWriter writer;
+    writer.Write(1u << 6, 7);
+
+    for (std::size_t c = 0; c < 4; c++)
+    {
+        writer.Write(quantized[0][c], 7);
+        writer.Write(quantized[1][c], 7);
+    }
+
+    writer.Write(pbits[0], 1);
+    writer.Write(pbits[1], 1);
+    writer.Write(indices[0], 3);
+
+    for (std::size_t i = 1; i < 16; i++)
+    {
+        writer.Write(indices[i], 4);
+    }
+
+    writer.Store(output);
+}
+
+} // namespace Lucid::Textures
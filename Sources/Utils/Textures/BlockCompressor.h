@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <Core/Types.h>
+
+namespace Lucid::Textures
+{
+
+/*
+        CPU encoder for block compressed formats.
+        BC1 uses a principal axis fit, BC7 is encoded in mode 6 (single subset, RGBA endpoints, 4 bit indices).
+*/
+class BlockCompressor
+{
+public:
+    // Compresses one RGBA8 mip level, output must hold Core::Texture::LevelByteSize bytes
+    static void Compress(
+        Core::TextureFormat format,
+        const unsigned char* pixels,
+        const Core::Vector2d<std::uint32_t>& size,
+        unsigned char* output);
+
+private:
+    using Block = std::array<std::uint8_t, 64>;
+
+    static Block FetchBlock(
+        const unsigned char* pixels,
+        const Core::Vector2d<std::uint32_t>& size,
+        std::uint32_t blockX,
+        std::uint32_t blockY);
+
+    static void EncodeBc1(const Block& block, unsigned char* output);
+    static void EncodeBc7(const Block& block, unsigned char* output);
+};
+
+} // namespace Lucid::Textures
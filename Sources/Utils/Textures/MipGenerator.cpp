@@ -0,0 +1,430 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#include <Utils/ThreadPool.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LUCID_MIP_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define LUCID_MIP_NEON
+#endif
+
+namespace Lucid::Textures
+{
+
+namespace
+{
+
+// One RGBA texel in linear space, kept in a single vector register where available
+struct Float4
+{
+#if defined(LUCID_MIP_SSE)
+    __m128 value;
+#elif defined(LUCID_MIP_NEON)
+    float32x4_t value;
+#else
+    std::array<float, 4> value;
+#endif
+};
+
+inline Float4
+Set(float r, float g, float b, float a)
+{
+#if defined(LUCID_MIP_SSE)
+    return { _mm_setr_ps(r, g, b, a) };
+#elif defined(LUCID_MIP_NEON)
+    const std::array<float, 4> values = { r, g, b, a };
+    return { vld1q_f32(values.data()) };
+#else
+    return { { r, g, b, a } };
+#endif
+}
+
+inline Float4
+Load(const float* data)
+{
+#if defined(LUCID_MIP_SSE)
+    return { _mm_loadu_ps(data) };
+#elif defined(LUCID_MIP_NEON)
+    return { vld1q_f32(data) };
+#else
+    return { { data[0], data[1], data[2], data[3] } };
+#endif
+}
+
+inline void
+Store(float* data, const Float4& texel)
+{
+#if defined(LUCID_MIP_SSE)
+    _mm_storeu_ps(data, texel.value);
+#elif defined(LUCID_MIP_NEON)
+    vst1q_f32(data, texel.value);
+#else
+    std::copy(texel.value.begin(), texel.value.end(), data);
+#endif
+}
+
+inline Float4
+Zero()
+{
+    return Set(0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+// accumulator + texel * weight
+inline Float4
+MulAdd(const Float4& accumulator, const Float4& texel, float weight)
+{
+#if defined(LUCID_MIP_SSE)
+    return { _mm_add_ps(accumulator.value, _mm_mul_ps(texel.value, _mm_set1_ps(weight))) };
+#elif defined(LUCID_MIP_NEON)
+    return { vmlaq_n_f32(accumulator.value, texel.value, weight) };
+#else
+    Float4 result = accumulator;
+    for (std::size_t c = 0; c < 4; c++)
+    {
+        result.value[c] += texel.value[c] * weight;
+    }
+    return result;
+#endif
+}
+
+inline Float4
+Clamp(const Float4& texel)
+{
+#if defined(LUCID_MIP_SSE)
+    return { _mm_min_ps(_mm_max_ps(texel.value, _mm_setzero_ps()), _mm_set1_ps(1.0f)) };
+#elif defined(LUCID_MIP_NEON)
+    return { vminq_f32(vmaxq_f32(texel.value, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f)) };
+#else
+    Float4 result = texel;
+    for (float& value : result.value)
+    {
+        value = std::clamp(value, 0.0f, 1.0f);
+    }
+    return result;
+#endif
+}
+
+// Resolution of the linear to sRGB table, fine enough to round-trip every 8 bit value
+const std::size_t EncodeTableSize = 1 << 14;
+
+const std::array<float, 256>&
+GetDecodeTable()
+{
+    static const std::array<float, 256> table = []()
+    {
+        std::array<float, 256> result {};
+        for (std::size_t i = 0; i < result.size(); i++)
+        {
+            float value = static_cast<float>(i) / 255.0f;
+            result[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+        }
+        return result;
+    }();
+
+    return table;
+}
+
+const std::array<std::uint8_t, EncodeTableSize>&
+GetEncodeTable()
+{
+    static const std::array<std::uint8_t, EncodeTableSize> table = []()
+    {
+        std::array<std::uint8_t, EncodeTableSize> result {};
+        for (std::size_t i = 0; i < result.size(); i++)
+        {
+            float value = static_cast<float>(i) / static_cast<float>(EncodeTableSize - 1);
+            float encoded = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+            result[i] = static_cast<std::uint8_t>(std::lround(encoded * 255.0f));
+        }
+        return result;
+    }();
+
+    return table;
+}
+
+/*
+        6 taps at distances 0.5, 1.5 and 2.5 source texels from the destination texel center:
+        sinc with the cutoff at the destination Nyquist frequency, shaped by a Kaiser window (beta = 4).
+*/
+const std::array<float, 6>&
+GetKaiserWeights()
+{
+    static const std::array<float, 6> weights = []()
+    {
+        const double pi = 3.14159265358979323846;
+        const double beta = 4.0;
+        const double radius = 3.0;
+
+        auto besselI0 = [](double x)
+        {
+            double sum = 1.0;
+            double term = 1.0;
+            for (int k = 1; k < 32; k++)
+            {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+            }
+            return sum;
+        };
+
+        std::array<float, 6> result {};
+        double total = 0.0;
+
+        for (std::size_t i = 0; i < result.size(); i++)
+        {
+            double distance = static_cast<double>(i) - 2.5;
+            double x = distance / 2.0;
+            double sinc = std::sin(pi * x) / (pi * x);
+            double ratio = distance / radius;
+            double window = besselI0(beta * std::sqrt(1.0 - ratio * ratio)) / besselI0(beta);
+
+            result[i] = static_cast<float>(sinc * window);
+            total += sinc * window;
+        }
+
+        for (float& weight : result)
+        {
+            weight /= static_cast<float>(total);
+        }
+
+        return result;
+    }();
+
+    return weights;
+}
+
+// Base level, decoded from sRGB bytes on the fly
+struct SrgbSource
+{
+    const unsigned char* data;
+
+    Float4 Get(std::size_t index) const
+    {
+        const std::array<float, 256>& table = GetDecodeTable();
+        const unsigned char* texel = data + index * 4;
+        return Set(table[texel[0]], table[texel[1]], table[texel[2]], static_cast<float>(texel[3]) / 255.0f);
+    }
+};
+
+// Already filtered levels, linear floats
+struct LinearSource
+{
+    const float* data;
+
+    Float4 Get(std::size_t index) const { return Load(data + index * 4); }
+};
+
+template <typename Source>
+void
+DownsampleBox(
+    const Source& source,
+    const Core::Vector2d<std::uint32_t>& sourceSize,
+    float* output,
+    const Core::Vector2d<std::uint32_t>& size,
+    std::size_t beginRow,
+    std::size_t endRow)
+{
+    // Odd edges reuse the last row or column
+    for (std::size_t y = beginRow; y < endRow; y++)
+    {
+        std::size_t y0 = std::min<std::size_t>(y * 2, sourceSize.y - 1);
+        std::size_t y1 = std::min<std::size_t>(y * 2 + 1, sourceSize.y - 1);
+
+        for (std::size_t x = 0; x < size.x; x++)
+        {
+            std::size_t x0 = std::min<std::size_t>(x * 2, sourceSize.x - 1);
+            std::size_t x1 = std::min<std::size_t>(x * 2 + 1, sourceSize.x - 1);
+
+            Float4 sum = Zero();
+            sum = MulAdd(sum, source.Get(y0 * sourceSize.x + x0), 0.25f);
+            sum = MulAdd(sum, source.Get(y0 * sourceSize.x + x1), 0.25f);
+            sum = MulAdd(sum, source.Get(y1 * sourceSize.x + x0), 0.25f);
+            sum = MulAdd(sum, source.Get(y1 * sourceSize.x + x1), 0.25f);
+
+            Store(output + (y * size.x + x) * 4, sum);
+        }
+    }
+}
+
+template <typename Source>
+void
+DownsampleKaiser(
+    const Source& source,
+    const Core::Vector2d<std::uint32_t>& sourceSize,
+    float* output,
+    const Core::Vector2d<std::uint32_t>& size,
+    std::size_t beginRow,
+    std::size_t endRow)
+{
+    const std::array<float, 6>& weights = GetKaiserWeights();
+    std::vector<float> row(static_cast<std::size_t>(sourceSize.x) * 4);
+
+    auto clampTap = [](std::size_t center, std::size_t tap, std::uint32_t limit)
+    {
+        std::int64_t position = static_cast<std::int64_t>(center * 2 + tap) - 2;
+        return static_cast<std::size_t>(std::clamp<std::int64_t>(position, 0, limit - 1));
+    };
+
+    for (std::size_t y = beginRow; y < endRow; y++)
+    {
+        // Vertical pass into a single source wide row, then horizontal pass into the destination
+        for (std::size_t x = 0; x < sourceSize.x; x++)
+        {
+            Float4 sum = Zero();
+            for (std::size_t tap = 0; tap < weights.size(); tap++)
+            {
+                sum = MulAdd(sum, source.Get(clampTap(y, tap, sourceSize.y) * sourceSize.x + x), weights[tap]);
+            }
+            Store(row.data() + x * 4, sum);
+        }
+
+        for (std::size_t x = 0; x < size.x; x++)
+        {
+            Float4 sum = Zero();
+            for (std::size_t tap = 0; tap < weights.size(); tap++)
+            {
+                sum = MulAdd(sum, Load(row.data() + clampTap(x, tap, sourceSize.x) * 4), weights[tap]);
+            }
+
+            // Negative lobes may overshoot
+            Store(output + (y * size.x + x) * 4, Clamp(sum));
+        }
+    }
+}
+
+template <typename Source>
+void
+Downsample(
+    MipGenerator::Filter filter,
+    const Source& source,
+    const Core::Vector2d<std::uint32_t>& sourceSize,
+    float* output,
+    const Core::Vector2d<std::uint32_t>& size)
+{
+    // Roughly 16k destination texels per task
+    std::size_t grain = std::max<std::size_t>(1, (1 << 14) / size.x);
+
+    ThreadPool::Instance().ParallelFor(
+        size.y,
+        [&](std::size_t begin, std::size_t end)
+        {
+            if (filter == MipGenerator::Filter::Kaiser)
+            {
+                DownsampleKaiser(source, sourceSize, output, size, begin, end);
+            }
+            else
+            {
+                DownsampleBox(source, sourceSize, output, size, begin, end);
+            }
+        },
+        grain);
+}
+
+void
+Encode(const std::vector<float>& linear, unsigned char* output)
+{
+    const std::array<std::uint8_t, EncodeTableSize>& table = GetEncodeTable();
+    std::size_t texels = linear.size() / 4;
+
+    ThreadPool::Instance().ParallelFor(
+        texels,
+        [&](std::size_t begin, std::size_t end)
+        {
+            std::array<float, 4> texel {};
+            const float scale = static_cast<float>(EncodeTableSize - 1);
+
+            for (std::size_t i = begin; i < end; i++)
+            {
+                Store(texel.data(), Clamp(Load(linear.data() + i * 4)));
+
+                for (std::size_t c = 0; c < 3; c++)
+                {
+                    output[i * 4 + c] = table[static_cast<std::size_t>(texel[c] * scale + 0.5f)];
+                }
+
+                output[i * 4 + 3] = static_cast<unsigned char>(texel[3] * 255.0f + 0.5f);
+            }
+        },
+        1 << 14);
+}
+
+} // namespace
+
+Core::TexturePtr
+MipGenerator::Generate(const Core::Texture& source, Filter filter)
+{
+    if (source.format != Core::TextureFormat::Rgba8Srgb)
+    {
+        throw std::runtime_error("Can't generate mips, texture isn't RGBA8");
+    }
+
+    auto result = std::make_shared<Core::Texture>();
+    result->size = source.size;
+    result->format = source.format;
+    result->layers = source.layers;
+    result->mipLevels = GetMipLevels(source.size);
+    result->pixels.resize(result->ComputeLevelOffsets());
+
+    if (source.HasMipChain())
+    {
+        std::copy_n(source.pixels.begin(), result->LevelByteSize(0) * result->layers, result->pixels.begin());
+    }
+    else
+    {
+        source.DecodeInto(result->pixels.data());
+    }
+
+    GenerateLevels(*result, result->pixels.data(), filter);
+    return result;
+}
+
+void
+MipGenerator::GenerateLevels(const Core::Texture& layout, unsigned char* data, Filter filter)
+{
+    if (layout.format != Core::TextureFormat::Rgba8Srgb || !layout.HasMipChain())
+    {
+        throw std::runtime_error("Can't generate mips, layout must be RGBA8 with every level");
+    }
+
+    // Each level is filtered from the previous one kept in linear floats, which avoids requantization
+    std::vector<float> previous;
+    std::vector<float> current;
+
+    for (std::uint32_t layer = 0; layer < layout.layers; layer++)
+    {
+        for (std::uint32_t level = 1; level < layout.mipLevels; level++)
+        {
+            Core::Vector2d<std::uint32_t> sourceSize = layout.LevelSize(level - 1);
+            Core::Vector2d<std::uint32_t> size = layout.LevelSize(level);
+            current.resize(static_cast<std::size_t>(size.x) * size.y * 4);
+
+            if (level == 1)
+            {
+                const unsigned char* base = data + layout.levelOffsets.at(0) + layout.LevelByteSize(0) * layer;
+                Downsample(filter, SrgbSource { base }, sourceSize, current.data(), size);
+            }
+            else
+            {
+                Downsample(filter, LinearSource { previous.data() }, sourceSize, current.data(), size);
+            }
+
+            Encode(current, data + layout.levelOffsets.at(level) + layout.LevelByteSize(level) * layer);
+            std::swap(previous, current);
+        }
+    }
+}
+
+std::uint32_t
+MipGenerator::GetMipLevels(const Core::Vector2d<std::uint32_t>& size)
+{
+    return static_cast<std::uint32_t>(std::floor(std::log2(std::max(size.x, size.y)))) + 1;
+}
+
+} // namespace Lucid::Textures
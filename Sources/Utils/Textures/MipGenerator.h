@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Core/Types.h>
+
+namespace Lucid::Textures
+{
+
+/*
+        Builds complete mip chains for RGBA8 sRGB textures on the CPU.
+        Filtering happens in linear space, levels are spread over the thread pool.
+*/
+class MipGenerator
+{
+public:
+    enum class Filter
+    {
+        Box,   // 2x2 average
+        Kaiser // Separable 6 tap Kaiser windowed sinc, sharper distant levels
+    };
+
+    // Returns a texture holding every level back to back, described by levelOffsets
+    static Core::TexturePtr Generate(const Core::Texture& source, Filter filter = Filter::Box);
+
+    // Fills levels 1..n of data laid out as layout.levelOffsets in place, level 0 must already be there
+    static void GenerateLevels(const Core::Texture& layout, unsigned char* data, Filter filter = Filter::Box);
+
+    static std::uint32_t GetMipLevels(const Core::Vector2d<std::uint32_t>& size);
+};
+
+} // namespace Lucid::Textures
@@ -0,0 +1,116 @@
+#include "TextureCooker.h"
+
+#include <Utils/Defaults.hpp>
+#include <Utils/Textures/BlockCompressor.h>
+#include <Utils/Utils.h>
+
+namespace Lucid::Textures
+{
+
+Core::TexturePtr
+TextureCooker::Cook(const Core::Texture& source, Compression compression, MipGenerator::Filter filter)
+{
+    if (source.format != Core::TextureFormat::Rgba8Srgb)
+    {
+        throw std::runtime_error("Texture cooker expects RGBA8 source");
+    }
+
+    Core::TexturePtr chain;
+
+    if (source.HasMipChain())
+    {
+        chain = std::make_shared<Core::Texture>(source);
+        chain->Decode();
+    }
+    else
+    {
+        chain = MipGenerator::Generate(source, filter);
+    }
+
+    Core::TextureFormat format = SelectFormat(*chain, compression);
+
+    if (format == Core::TextureFormat::Rgba8Srgb)
+    {
+        return chain;
+    }
+
+    auto result = std::make_shared<Core::Texture>();
+    result->size = chain->size;
+    result->format = format;
+    result->mipLevels = chain->mipLevels;
+    result->layers = chain->layers;
+
+    std::size_t totalSize = result->ComputeLevelOffsets();
+    result->pixels.resize(totalSize);
+
+    for (std::uint32_t level = 0; level < result->mipLevels; level++)
+    {
+        for (std::uint32_t layer = 0; layer < result->layers; layer++)
+        {
+            BlockCompressor::Compress(
+                result->format,
+                chain->pixels.data() + chain->levelOffsets.at(level) + chain->LevelByteSize(level) * layer,
+                result->LevelSize(level),
+                result->pixels.data() + result->levelOffsets.at(level) + result->LevelByteSize(level) * layer);
+        }
+    }
+
+    return result;
+}
+
+std::filesystem::path
+TextureCooker::GetCachePath(const std::filesystem::path& source, Compression compression)
+{
+    return GetCachePath(std::vector<std::filesystem::path> { source }, compression);
+}
+
+std::filesystem::path
+TextureCooker::GetCachePath(const std::vector<std::filesystem::path>& sources, Compression compression)
+{
+    std::uint64_t hash = Hash(&Version, sizeof(Version));
+
+    for (const auto& source : sources)
+    {
+        std::filesystem::path absolute = std::filesystem::absolute(source);
+        auto writeTime = std::filesystem::last_write_time(absolute).time_since_epoch().count();
+        auto fileSize = std::filesystem::file_size(absolute);
+
+        hash = Hash(absolute.generic_string(), hash);
+        hash = Hash(&writeTime, sizeof(writeTime), hash);
+        hash = Hash(&fileSize, sizeof(fileSize), hash);
+    }
+
+    hash = Hash(&compression, sizeof(compression), hash);
+
+    std::string stem = sources.front().stem().string() + (sources.size() > 1 ? "-array" : "");
+    return std::filesystem::path(Defaults::CacheDirectory) / "Textures" / (stem + "-" + ToHex(hash) + ".ktx2");
+}
+
+Core::TextureFormat
+TextureCooker::SelectFormat(const Core::Texture& source, Compression compression)
+{
+    switch (compression)
+    {
+    case Compression::None:
+        return Core::TextureFormat::Rgba8Srgb;
+    case Compression::Bc1:
+        return Core::TextureFormat::Bc1Srgb;
+    case Compression::Bc7:
+        return Core::TextureFormat::Bc7Srgb;
+    case Compression::Auto:
+        break;
+    }
+
+    std::size_t texels = static_cast<std::size_t>(source.size.x) * source.size.y * source.layers;
+    for (std::size_t i = 0; i < texels; i++)
+    {
+        if (source.pixels[i * 4 + 3] != 255)
+        {
+            return Core::TextureFormat::Bc7Srgb;
+        }
+    }
+
+    return Core::TextureFormat::Bc1Srgb;
+}
+
+} // namespace Lucid::Textures
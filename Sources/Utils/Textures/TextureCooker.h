@@ -0,0 +1,42 @@
+#pragma once
+
+#include <filesystem>
+
+#include <Core/Types.h>
+#include <Utils/Textures/MipGenerator.h>
+
+namespace Lucid::Textures
+{
+
+/*
+        Converts decoded RGBA8 textures into their GPU ready form: full mip chain,
+        optionally block compressed. Results are stored as KTX2 in the cache directory.
+*/
+class TextureCooker
+{
+public:
+    enum class Compression
+    {
+        None,
+        Bc1,
+        Bc7,
+        Auto // BC1 for opaque textures, BC7 when alpha is used
+    };
+
+    static Core::TexturePtr Cook(
+        const Core::Texture& source,
+        Compression compression,
+        MipGenerator::Filter filter = MipGenerator::Filter::Box);
+    static std::filesystem::path GetCachePath(const std::filesystem::path& source, Compression compression);
+
+    // Key for textures assembled from several files, e.g. cubemap faces
+    static std::filesystem::path
+    GetCachePath(const std::vector<std::filesystem::path>& sources, Compression compression);
+    static Core::TextureFormat SelectFormat(const Core::Texture& source, Compression compression);
+
+private:
+    // Bump whenever cooked output changes, invalidates every cached texture
+    inline static const std::uint32_t Version = 3;
+};
+
+} // namespace Lucid::Textures
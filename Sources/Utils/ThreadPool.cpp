@@ -0,0 +1,173 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace Lucid
+{
+
+namespace
+{
+
+struct ParallelForState
+{
+    std::atomic<std::size_t> nextChunk = 0;
+    std::size_t chunkCount = 0;
+    std::size_t finishedChunks = 0;
+    std::exception_ptr exception;
+    std::mutex mutex;
+    std::condition_variable finished;
+};
+
+void
+RunChunks(
+    ParallelForState& state,
+    std::size_t count,
+    std::size_t grain,
+    const std::function<void(std::size_t, std::size_t)>& function)
+{
+    for (std::size_t chunk = state.nextChunk++; chunk < state.chunkCount; chunk = state.nextChunk++)
+    {
+        std::exception_ptr exception;
+
+        try
+        {
+            function(chunk * grain, std::min(count, (chunk + 1) * grain));
+        }
+        catch (...)
+        {
+            exception = std::current_exception();
+        }
+
+        std::lock_guard lock(state.mutex);
+
+        if (exception && !state.exception)
+        {
+            state.exception = exception;
+        }
+
+        if (++state.finishedChunks == state.chunkCount)
+        {
+            state.finished.notify_all();
+        }
+    }
+}
+
+} // namespace
+
+ThreadPool&
+ThreadPool::Instance()
+{
+    static ThreadPool instance;
+    return instance;
+}
+
+ThreadPool::ThreadPool()
+{
+    std::size_t threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+    for (std::size_t i = 0; i < threadCount; i++)
+    {
+        mWorkers.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mMutex);
+        mStopping = true;
+    }
+
+    mCondition.notify_all();
+
+    for (std::thread& worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+void
+ThreadPool::ParallelFor(
+    std::size_t count,
+    const std::function<void(std::size_t begin, std::size_t end)>& function,
+    std::size_t grain)
+{
+    grain = std::max<std::size_t>(grain, 1);
+    std::size_t chunkCount = (count + grain - 1) / grain;
+
+    if (chunkCount == 0)
+    {
+        return;
+    }
+
+    if (chunkCount == 1 || mWorkers.empty())
+    {
+        function(0, count);
+        return;
+    }
+
+    // Helpers that start after all chunks are taken simply return, the caller only waits for the chunks
+    auto state = std::make_shared<ParallelForState>();
+    state->chunkCount = chunkCount;
+
+    std::size_t helpers = std::min(mWorkers.size(), chunkCount - 1);
+    for (std::size_t i = 0; i < helpers; i++)
+    {
+        Enqueue([state, count, grain, function]() { RunChunks(*state, count, grain, function); });
+    }
+
+    RunChunks(*state, count, grain, function);
+
+    std::unique_lock lock(state->mutex);
+    state->finished.wait(lock, [&state]() { return state->finishedChunks == state->chunkCount; });
+
+    if (state->exception)
+    {
+        std::rethrow_exception(state->exception);
+    }
+}
+
+std::size_t
+ThreadPool::GetThreadCount() const
+{
+    return mWorkers.size() + 1;
+}
+
+void
+ThreadPool::Enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard lock(mMutex);
+        mTasks.push_back(std::move(task));
+    }
+
+    mCondition.notify_one();
+}
+
+void
+ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock lock(mMutex);
+            mCondition.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+
+            if (mStopping && mTasks.empty())
+            {
+                return;
+            }
+
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+} // namespace Lucid
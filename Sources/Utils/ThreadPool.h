@@ -0,0 +1,63 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Lucid
+{
+
+/*
+        Process wide pool of worker threads used by loaders and cookers.
+        ParallelFor lets the calling thread take part in the work, so it is safe to nest.
+*/
+class ThreadPool
+{
+public:
+    static ThreadPool& Instance();
+
+    ~ThreadPool();
+
+    template <typename Function> auto Submit(Function&& function) -> std::future<std::invoke_result_t<Function>>
+    {
+        using Result = std::invoke_result_t<Function>;
+
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+        std::future<Result> result = task->get_future();
+
+        Enqueue([task]() { (*task)(); });
+        return result;
+    }
+
+    // Calls function(begin, end) for consecutive ranges of at most grain items covering [0, count)
+    void ParallelFor(
+        std::size_t count,
+        const std::function<void(std::size_t begin, std::size_t end)>& function,
+        std::size_t grain = 1);
+
+    [[nodiscard]] std::size_t GetThreadCount() const;
+
+private:
+    ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    void operator=(const ThreadPool&) = delete;
+    void operator=(const ThreadPool&&) = delete;
+
+    void Enqueue(std::function<void()> task);
+    void WorkerLoop();
+
+    std::vector<std::thread> mWorkers;
+    std::deque<std::function<void()>> mTasks;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mStopping = false;
+};
+
+} // namespace Lucid
@@ -1 +1,41 @@
 #include "Utils.h"
+
+namespace Lucid
+{
+
+std::uint64_t
+Hash(const void* data, std::size_t size, std::uint64_t seed)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    std::uint64_t hash = seed;
+
+    for (std::size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+std::uint64_t
+Hash(const std::string& data, std::uint64_t seed)
+{
+    return Hash(data.data(), data.size(), seed);
+}
+
+std::string
+ToHex(std::uint64_t value)
+{
+    const char* digits = "0123456789abcdef";
+    std::string result(16, '0');
+
+    for (std::size_t i = 0; i < 16; i++)
+    {
+        result[15 - i] = digits[(value >> (i * 4)) & 0xF];
+    }
+
+    return result;
+}
+
+} // namespace Lucid
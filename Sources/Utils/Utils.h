@@ -1 +1,14 @@
 #pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Lucid
+{
+
+// 64 bit FNV-1a, stable between runs and platforms so it can key on-disk caches
+[[nodiscard]] std::uint64_t Hash(const void* data, std::size_t size, std::uint64_t seed = 14695981039346656037ull);
+[[nodiscard]] std::uint64_t Hash(const std::string& data, std::uint64_t seed = 14695981039346656037ull);
+[[nodiscard]] std::string ToHex(std::uint64_t value);
+
+} // namespace Lucid
@@ -0,0 +1,114 @@
+#include "VertexQuantizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <Utils/ThreadPool.h>
+
+namespace Lucid
+{
+
+namespace
+{
+
+const std::size_t Grain = 64 * 1024;
+
+} // namespace
+
+glm::mat4
+VertexQuantizer::Quantize(std::span<const Core::Vertex> vertices, std::span<Core::PackedVertex> output)
+{
+    if (output.size() < vertices.size())
+    {
+        throw std::runtime_error("Can't quantize vertices, output is too small");
+    }
+
+    if (vertices.empty())
+    {
+        return glm::mat4(1.0f);
+    }
+
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(std::numeric_limits<float>::lowest());
+    std::mutex mutex;
+
+    ThreadPool::Instance().ParallelFor(
+        vertices.size(),
+        [&vertices, &min, &max, &mutex](std::size_t begin, std::size_t end)
+        {
+            glm::vec3 localMin = vertices[begin].position;
+            glm::vec3 localMax = vertices[begin].position;
+
+            for (std::size_t i = begin + 1; i < end; i++)
+            {
+                localMin = glm::min(localMin, vertices[i].position);
+                localMax = glm::max(localMax, vertices[i].position);
+            }
+
+            std::lock_guard lock(mutex);
+            min = glm::min(min, localMin);
+            max = glm::max(max, localMax);
+        },
+        Grain);
+
+    // Flat meshes keep a tiny extent on their degenerate axis so the inverse stays finite
+    glm::vec3 center = (min + max) * 0.5f;
+    glm::vec3 extent = glm::max((max - min) * 0.5f, glm::vec3(std::numeric_limits<float>::min()));
+    glm::vec3 inverseExtent = glm::vec3(1.0f) / extent;
+
+    ThreadPool::Instance().ParallelFor(
+        vertices.size(),
+        [&vertices, &output, &center, &inverseExtent](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                output[i] = VertexQuantizer::Pack(vertices[i], center, inverseExtent);
+            }
+        },
+        Grain);
+
+    return glm::scale(glm::translate(glm::mat4(1.0f), center), extent);
+}
+
+std::uint32_t
+VertexQuantizer::EncodeOctahedral(const glm::vec3& normal)
+{
+    float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (!(sum > 0.0f))
+    {
+        return glm::packSnorm2x16(glm::vec2(0.0f, 0.0f));
+    }
+
+    glm::vec2 encoded(normal.x / sum, normal.y / sum);
+
+    // The lower hemisphere is folded over the diagonals of the square
+    if (normal.z < 0.0f)
+    {
+        encoded = glm::vec2(
+            (1.0f - std::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f),
+            (1.0f - std::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f));
+    }
+
+    return glm::packSnorm2x16(encoded);
+}
+
+Core::PackedVertex
+VertexQuantizer::Pack(const Core::Vertex& vertex, const glm::vec3& center, const glm::vec3& inverseExtent)
+{
+    glm::vec3 position = (vertex.position - center) * inverseExtent;
+
+    return Core::PackedVertex {
+        glm::packSnorm2x16(glm::vec2(position.x, position.y)),
+        glm::packSnorm2x16(glm::vec2(position.z, 0.0f)),
+        VertexQuantizer::EncodeOctahedral(vertex.normal),
+        glm::packHalf2x16(vertex.uv),
+        glm::packUnorm4x8(glm::vec4(vertex.color, 1.0f)),
+    };
+}
+
+} // namespace Lucid
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include <Core/Vertex.h>
+
+namespace Lucid
+{
+
+/*
+        Converts float vertices into the compact Core::PackedVertex layout used for GPU buffers.
+        Positions are normalized to the mesh bounds, the returned matrix maps them back to model space.
+*/
+class VertexQuantizer
+{
+public:
+    static glm::mat4 Quantize(std::span<const Core::Vertex> vertices, std::span<Core::PackedVertex> output);
+
+    // Octahedral mapping of a unit vector onto two snorm16 components
+    static std::uint32_t EncodeOctahedral(const glm::vec3& normal);
+
+private:
+    static Core::PackedVertex
+    Pack(const Core::Vertex& vertex, const glm::vec3& center, const glm::vec3& inverseExtent);
+};
+
+} // namespace Lucid
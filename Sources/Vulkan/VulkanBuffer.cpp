@@ -1,7 +1,11 @@
 #include "VulkanBuffer.h"
 
+#include <algorithm>
+#include <limits>
+
 #include <Core/UniformBufferObject.h>
 #include <Utils/Logger.hpp>
+#include <Utils/VertexQuantizer.h>
 #include <Vulkan/VulkanCommandPool.h>
 #include <Vulkan/VulkanDevice.h>
 
@@ -12,14 +16,15 @@ VulkanBuffer::VulkanBuffer(
     VulkanDevice& device,
     vk::DeviceSize size,
     vk::BufferUsageFlags usage,
-    vk::MemoryPropertyFlags properties)
+    vk::MemoryPropertyFlags properties,
+    vk::MemoryPropertyFlags preferredProperties)
     : mDevice(device)
 {
     auto createInfo = vk::BufferCreateInfo().setSize(size).setUsage(usage).setSharingMode(vk::SharingMode::eExclusive);
 
     mHandle = device.Handle()->createBufferUnique(createInfo);
     vk::MemoryRequirements requirements = device.Handle()->getBufferMemoryRequirements(Handle().get());
-    std::uint32_t memoryType = FindMemoryType(mDevice, requirements.memoryTypeBits, properties);
+    std::uint32_t memoryType = FindMemoryType(mDevice, requirements.memoryTypeBits, properties, preferredProperties);
 
     auto allocateInfo = vk::MemoryAllocateInfo().setAllocationSize(requirements.size).setMemoryTypeIndex(memoryType);
 
@@ -42,11 +47,67 @@ VulkanBuffer::Write(const void* pixels, std::size_t size, std::size_t offset)
     mDevice.Handle()->unmapMemory(mMemory.get());
 }
 
+void
+VulkanBuffer::Write(const std::function<void(void* memory)>& writer)
+{
+    void* deviceMemory = mDevice.Handle()->mapMemory(mMemory.get(), 0, mBufferSize);
+
+    try
+    {
+        writer(deviceMemory);
+    }
+    catch (...)
+    {
+        mDevice.Handle()->unmapMemory(mMemory.get());
+        throw;
+    }
+
+    mDevice.Handle()->unmapMemory(mMemory.get());
+}
+
+void
+VulkanBuffer::Read(const std::function<void(const void* memory)>& reader) const
+{
+    const void* deviceMemory = mDevice.Handle()->mapMemory(mMemory.get(), 0, mBufferSize);
+
+    try
+    {
+        reader(deviceMemory);
+    }
+    catch (...)
+    {
+        mDevice.Handle()->unmapMemory(mMemory.get());
+        throw;
+    }
+
+    mDevice.Handle()->unmapMemory(mMemory.get());
+}
+
 std::uint32_t
-VulkanBuffer::FindMemoryType(VulkanDevice& device, std::uint32_t filter, vk::MemoryPropertyFlags flags)
+VulkanBuffer::FindMemoryType(
+    VulkanDevice& device,
+    std::uint32_t filter,
+    vk::MemoryPropertyFlags flags,
+    vk::MemoryPropertyFlags preferredFlags)
 {
     vk::PhysicalDeviceMemoryProperties properties = device.GetPhysicalDevice().getMemoryProperties();
 
+    // Try with the preferred properties first, then settle for the required ones
+    if (preferredFlags)
+    {
+        for (std::uint32_t i = 0; i < properties.memoryTypeCount; i++)
+        {
+            bool validType = filter & (1 << i);
+            bool validProperties
+                = (properties.memoryTypes.at(i).propertyFlags & (flags | preferredFlags)) == (flags | preferredFlags);
+
+            if (validType && validProperties)
+            {
+                return i;
+            }
+        }
+    }
+
     for (std::uint32_t i = 0; i < properties.memoryTypeCount; i++)
     {
         bool validType = filter & (1 << i);
@@ -64,22 +125,52 @@ VulkanBuffer::FindMemoryType(VulkanDevice& device, std::uint32_t filter, vk::Mem
 VulkanVertexBuffer::VulkanVertexBuffer(
     VulkanDevice& device,
     VulkanCommandPool& manager,
-    const std::vector<Core::Vertex>& vertices)
+    const std::vector<Core::Vertex>& vertices,
+    Core::VertexFormat format)
     : VulkanBuffer(
         device,
-        vertices.size() * sizeof(vertices.at(0)),
+        vertices.size() * GetVertexSize(format),
         vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
         vk::MemoryPropertyFlagBits::eDeviceLocal)
     , mVerticesCount(vertices.size())
 {
     VulkanBuffer stagingBuffer(
         device,
-        vertices.size() * sizeof(vertices.at(0)),
+        vertices.size() * GetVertexSize(format),
         vk::BufferUsageFlagBits::eTransferSrc,
         vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
 
-    // Copy vertex data to staging buffer (CPU -> CPU + GPU)
-    stagingBuffer.Write(reinterpret_cast<const void*>(vertices.data()));
+    // Copy vertex data to staging buffer (CPU -> CPU + GPU), packed vertices are encoded straight into it
+    if (format == Core::VertexFormat::Packed)
+    {
+        stagingBuffer.Write(
+            [this, &vertices](void* memory)
+            {
+                std::span<Core::PackedVertex> packed(static_cast<Core::PackedVertex*>(memory), vertices.size());
+                mDequantization = VertexQuantizer::Quantize(vertices, packed);
+            });
+    }
+    else if (format == Core::VertexFormat::Position)
+    {
+        // Same quantization as the packed stream, a depth prepass must produce exactly the same depths
+        std::vector<Core::PackedVertex> packed(vertices.size());
+        mDequantization = VertexQuantizer::Quantize(vertices, packed);
+
+        stagingBuffer.Write(
+            [&packed](void* memory)
+            {
+                auto* positions = static_cast<Core::PackedPosition*>(memory);
+                for (std::size_t i = 0; i < packed.size(); i++)
+                {
+                    positions[i].positionXY = packed[i].positionXY;
+                    positions[i].positionZ = packed[i].positionZ;
+                }
+            });
+    }
+    else
+    {
+        stagingBuffer.Write(reinterpret_cast<const void*>(vertices.data()));
+    }
 
     // Copy staging buffer to vertex buffer (CPU + GPU -> GPU)
     Write(manager, stagingBuffer);
@@ -91,6 +182,28 @@ VulkanVertexBuffer::VerticesCount() const noexcept
     return mVerticesCount;
 }
 
+const glm::mat4&
+VulkanVertexBuffer::GetDequantization() const noexcept
+{
+    return mDequantization;
+}
+
+std::size_t
+VulkanVertexBuffer::GetVertexSize(Core::VertexFormat format)
+{
+    switch (format)
+    {
+    case Core::VertexFormat::Packed:
+        return sizeof(Core::PackedVertex);
+    case Core::VertexFormat::Position:
+        return sizeof(Core::PackedPosition);
+    case Core::VertexFormat::Float:
+        break;
+    }
+
+    return sizeof(Core::Vertex);
+}
+
 void
 VulkanBuffer::Write(VulkanCommandPool& pool, const VulkanBuffer& buffer)
 {
@@ -106,23 +219,49 @@ VulkanIndexBuffer::VulkanIndexBuffer(
     VulkanDevice& device,
     VulkanCommandPool& manager,
     const std::vector<std::uint32_t>& indices)
+    : VulkanIndexBuffer(device, manager, indices, ChooseIndexType(indices))
+{
+}
+
+VulkanIndexBuffer::VulkanIndexBuffer(
+    VulkanDevice& device,
+    VulkanCommandPool& manager,
+    const std::vector<std::uint32_t>& indices,
+    vk::IndexType type)
     : VulkanBuffer(
         device,
-        indices.size() * sizeof(indices.at(0)),
+        indices.size() * GetIndexSize(type),
         vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
         vk::MemoryPropertyFlagBits::eDeviceLocal)
     , mIndicesCount(indices.size())
+    , mIndexType(type)
 {
     VulkanBuffer stagingBuffer(
         device,
-        indices.size() * sizeof(indices.at(0)),
+        indices.size() * GetIndexSize(mIndexType),
         vk::BufferUsageFlagBits::eTransferSrc,
         vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
 
-    // Copy vertex data to staging buffer (CPU -> CPU + GPU)
-    stagingBuffer.Write(reinterpret_cast<const void*>(indices.data()));
+    // Copy index data to staging buffer (CPU -> CPU + GPU), narrowing to 16 bit on the way when possible
+    if (mIndexType == vk::IndexType::eUint16)
+    {
+        stagingBuffer.Write(
+            [&indices](void* memory)
+            {
+                auto* narrow = static_cast<std::uint16_t*>(memory);
+                std::transform(
+                    indices.begin(),
+                    indices.end(),
+                    narrow,
+                    [](std::uint32_t index) { return static_cast<std::uint16_t>(index); });
+            });
+    }
+    else
+    {
+        stagingBuffer.Write(reinterpret_cast<const void*>(indices.data()));
+    }
 
-    // Copy staging buffer to vertex buffer (CPU + GPU -> GPU)
+    // Copy staging buffer to index buffer (CPU + GPU -> GPU)
     Write(manager, stagingBuffer);
 }
 
@@ -132,6 +271,28 @@ VulkanIndexBuffer::IndicesCount() const noexcept
     return mIndicesCount;
 }
 
+vk::IndexType
+VulkanIndexBuffer::GetIndexType() const noexcept
+{
+    return mIndexType;
+}
+
+vk::IndexType
+VulkanIndexBuffer::ChooseIndexType(const std::vector<std::uint32_t>& indices)
+{
+    // 0xFFFF stays free, it is the primitive restart value for 16 bit indices
+    auto largest = std::max_element(indices.begin(), indices.end());
+    bool narrow = largest == indices.end() || *largest < std::numeric_limits<std::uint16_t>::max();
+
+    return narrow ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+}
+
+std::size_t
+VulkanIndexBuffer::GetIndexSize(vk::IndexType type)
+{
+    return type == vk::IndexType::eUint16 ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+}
+
 VulkanUniformBuffer::VulkanUniformBuffer(VulkanDevice& device)
     : VulkanBuffer(
         device,
@@ -141,4 +302,29 @@ VulkanUniformBuffer::VulkanUniformBuffer(VulkanDevice& device)
 {
 }
 
+VulkanIndirectBuffer::VulkanIndirectBuffer(VulkanDevice& device, std::size_t commandCount)
+    : VulkanBuffer(
+        device,
+        commandCount * sizeof(vk::DrawIndexedIndirectCommand),
+        vk::BufferUsageFlagBits::eIndirectBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent)
+{
+}
+
+VulkanInstanceBuffer::VulkanInstanceBuffer(VulkanDevice& device, std::size_t instanceCount)
+    : VulkanBuffer(
+        device,
+        instanceCount * sizeof(glm::mat4),
+        vk::BufferUsageFlagBits::eVertexBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent)
+    , mInstancesCount(instanceCount)
+{
+}
+
+std::size_t
+VulkanInstanceBuffer::InstancesCount() const noexcept
+{
+    return mInstancesCount;
+}
+
 } // namespace Lucid::Vulkan
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+
 #include <Core/Vertex.h>
 #include <Vulkan/VulkanEntity.h>
 #include <vulkan/vulkan.hpp>
@@ -18,11 +20,21 @@ public:
         VulkanDevice& device,
         vk::DeviceSize size,
         vk::BufferUsageFlags usage,
-        vk::MemoryPropertyFlags properties);
+        vk::MemoryPropertyFlags properties,
+        vk::MemoryPropertyFlags preferredProperties = {});
     void Write(const void* pixels, std::size_t size = 0, std::size_t offset = 0);
 
-    [[nodiscard]] static std::uint32_t
-    FindMemoryType(VulkanDevice& device, std::uint32_t filter, vk::MemoryPropertyFlags flags);
+    // Maps the whole buffer and lets writer fill it in place
+    void Write(const std::function<void(void* memory)>& writer);
+
+    // Maps the whole buffer for reading, host visible buffers only
+    void Read(const std::function<void(const void* memory)>& reader) const;
+
+    [[nodiscard]] static std::uint32_t FindMemoryType(
+        VulkanDevice& device,
+        std::uint32_t filter,
+        vk::MemoryPropertyFlags flags,
+        vk::MemoryPropertyFlags preferredFlags = {});
 
 protected:
     void Write(VulkanCommandPool& manager, const VulkanBuffer& buffer);
@@ -35,11 +47,22 @@ protected:
 class VulkanVertexBuffer : public VulkanBuffer
 {
 public:
-    VulkanVertexBuffer(VulkanDevice& device, VulkanCommandPool& manager, const std::vector<Core::Vertex>& vertices);
+    VulkanVertexBuffer(
+        VulkanDevice& device,
+        VulkanCommandPool& manager,
+        const std::vector<Core::Vertex>& vertices,
+        Core::VertexFormat format = Core::VertexFormat::Packed);
     [[nodiscard]] std::size_t VerticesCount() const noexcept;
 
+    // Maps stored positions to model space, identity for float vertices
+    [[nodiscard]] const glm::mat4& GetDequantization() const noexcept;
+
+    // Stride of a vertex stored in the given format
+    [[nodiscard]] static std::size_t GetVertexSize(Core::VertexFormat format);
+
 private:
     std::size_t mVerticesCount = 0;
+    glm::mat4 mDequantization = glm::mat4(1.0f);
 };
 
 class VulkanIndexBuffer : public VulkanBuffer
@@ -48,8 +71,21 @@ public:
     VulkanIndexBuffer(VulkanDevice& device, VulkanCommandPool& manager, const std::vector<std::uint32_t>& indices);
     [[nodiscard]] std::size_t IndicesCount() const noexcept;
 
+    // 16 bit when every index fits, 32 bit otherwise
+    [[nodiscard]] vk::IndexType GetIndexType() const noexcept;
+
 private:
+    VulkanIndexBuffer(
+        VulkanDevice& device,
+        VulkanCommandPool& manager,
+        const std::vector<std::uint32_t>& indices,
+        vk::IndexType type);
+
+    static vk::IndexType ChooseIndexType(const std::vector<std::uint32_t>& indices);
+    static std::size_t GetIndexSize(vk::IndexType type);
+
     std::size_t mIndicesCount = 0;
+    vk::IndexType mIndexType = vk::IndexType::eUint32;
 };
 
 class VulkanUniformBuffer : public VulkanBuffer
@@ -58,4 +94,22 @@ public:
     VulkanUniformBuffer(VulkanDevice& device);
 };
 
+// Host visible draw commands, rewritten by the CPU before every recording
+class VulkanIndirectBuffer : public VulkanBuffer
+{
+public:
+    VulkanIndirectBuffer(VulkanDevice& device, std::size_t commandCount);
+};
+
+// Host visible model matrices, read per instance as vertex attributes
+class VulkanInstanceBuffer : public VulkanBuffer
+{
+public:
+    VulkanInstanceBuffer(VulkanDevice& device, std::size_t instanceCount);
+    [[nodiscard]] std::size_t InstancesCount() const noexcept;
+
+private:
+    std::size_t mInstancesCount = 0;
+};
+
 } // namespace Lucid::Vulkan
@@ -52,7 +52,9 @@ void
 VulkanCommandPool::RecordCommandBuffers(
     VulkanSwapchain& swapchain,
     const VulkanRenderPass& renderPass,
-    std::function<void(vk::CommandBuffer& commandBuffer)> action)
+    std::function<void(vk::CommandBuffer& commandBuffer)> action,
+    std::function<void(vk::CommandBuffer& commandBuffer)> prologue,
+    std::function<void(vk::CommandBuffer& commandBuffer)> epilogue)
 {
     std::size_t imageCount = swapchain.GetFramebuffers().size();
 
@@ -63,6 +65,12 @@ VulkanCommandPool::RecordCommandBuffers(
             = vk::CommandBufferBeginInfo().setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
         commandBuffer->begin(commandBufferBeginInfo);
 
+        // Commands that are not allowed inside a render pass, e.g. query resets
+        if (prologue)
+        {
+            prologue(commandBuffer.get());
+        }
+
         vk::ClearValue clearColor = vk::ClearColorValue(Defaults::BackgroundColor);
         vk::ClearValue clearDepth = vk::ClearDepthStencilValue(1.0f, 0);
 
@@ -78,6 +86,13 @@ VulkanCommandPool::RecordCommandBuffers(
         commandBuffer->beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
         action(commandBuffer.get());
         commandBuffer->endRenderPass();
+
+        // Commands reading the results of the render pass, e.g. compute over its depth
+        if (epilogue)
+        {
+            epilogue(commandBuffer.get());
+        }
+
         commandBuffer->end();
     }
 }
@@ -31,7 +31,9 @@ public:
     void RecordCommandBuffers(
         VulkanSwapchain& swapchain,
         const VulkanRenderPass& renderPass,
-        std::function<void(vk::CommandBuffer& commandBuffer)> action);
+        std::function<void(vk::CommandBuffer& commandBuffer)> action,
+        std::function<void(vk::CommandBuffer& commandBuffer)> prologue = {},
+        std::function<void(vk::CommandBuffer& commandBuffer)> epilogue = {});
 
     void ExecuteSingleCommand(const std::function<void(vk::CommandBuffer&)>& function);
 
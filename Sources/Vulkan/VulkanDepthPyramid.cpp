@@ -0,0 +1,237 @@
+#include "VulkanDepthPyramid.h"
+
+#include <cstring>
+
+#include <Vulkan/VulkanDevice.h>
+#include <Vulkan/VulkanImage.h>
+#include <Vulkan/VulkanShader.h>
+
+namespace Lucid::Vulkan
+{
+
+namespace
+{
+
+// Push constants of DepthPyramid.comp
+struct LevelConstants
+{
+    glm::uvec2 sourceSize;
+    glm::uvec2 size;
+    std::uint32_t sourceOffset = 0;
+    std::uint32_t offset = 0;
+    std::uint32_t samples = 0;
+};
+
+const std::uint32_t GroupSize = 8;
+
+} // namespace
+
+VulkanDepthPyramid::VulkanDepthPyramid(VulkanDevice& device, const VulkanImage& depthImage, const vk::Extent2D& extent)
+    : mDevice(device)
+    , mDepthImage(depthImage)
+    , mExtent(extent)
+    , mPyramid(extent.width, extent.height)
+    , mBuffer(
+          device,
+          mPyramid.GetDepths().size_bytes(),
+          vk::BufferUsageFlagBits::eStorageBuffer,
+          vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+          vk::MemoryPropertyFlagBits::eHostCached)
+{
+    // Descriptors
+    auto depthBinding = vk::DescriptorSetLayoutBinding()
+                            .setBinding(0)
+                            .setDescriptorType(vk::DescriptorType::eSampledImage)
+                            .setDescriptorCount(1)
+                            .setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+    auto pyramidBinding = vk::DescriptorSetLayoutBinding()
+                              .setBinding(1)
+                              .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+                              .setDescriptorCount(1)
+                              .setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+    vk::DescriptorSetLayoutBinding bindings[] = { depthBinding, pyramidBinding };
+
+    auto layoutCreateInfo = vk::DescriptorSetLayoutCreateInfo()
+                                .setBindingCount(static_cast<std::uint32_t>(std::size(bindings)))
+                                .setPBindings(bindings);
+
+    mDescriptorSetLayout = device.Handle()->createDescriptorSetLayoutUnique(layoutCreateInfo);
+
+    vk::DescriptorPoolSize poolSizes[] = {
+        vk::DescriptorPoolSize().setType(vk::DescriptorType::eSampledImage).setDescriptorCount(1),
+        vk::DescriptorPoolSize().setType(vk::DescriptorType::eStorageBuffer).setDescriptorCount(1),
+    };
+
+    auto poolCreateInfo = vk::DescriptorPoolCreateInfo()
+                              .setPoolSizeCount(static_cast<std::uint32_t>(std::size(poolSizes)))
+                              .setPPoolSizes(poolSizes)
+                              .setMaxSets(1)
+                              .setFlags(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet);
+
+    mDescriptorPool = device.Handle()->createDescriptorPoolUnique(poolCreateInfo);
+
+    auto allocateInfo = vk::DescriptorSetAllocateInfo()
+                            .setDescriptorPool(mDescriptorPool.get())
+                            .setDescriptorSetCount(1)
+                            .setPSetLayouts(&mDescriptorSetLayout.get());
+
+    mDescriptorSet = std::move(device.Handle()->allocateDescriptorSetsUnique(allocateInfo).at(0));
+
+    auto imageInfo = vk::DescriptorImageInfo()
+                         .setImageView(depthImage.GetImageView())
+                         .setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+
+    auto bufferInfo = vk::DescriptorBufferInfo().setBuffer(mBuffer.Handle().get()).setOffset(0).setRange(VK_WHOLE_SIZE);
+
+    auto imageDescriptorWrite = vk::WriteDescriptorSet()
+                                    .setDstSet(mDescriptorSet.get())
+                                    .setDstBinding(0)
+                                    .setDescriptorCount(1)
+                                    .setDescriptorType(vk::DescriptorType::eSampledImage)
+                                    .setPImageInfo(&imageInfo);
+
+    auto bufferDescriptorWrite = vk::WriteDescriptorSet()
+                                     .setDstSet(mDescriptorSet.get())
+                                     .setDstBinding(1)
+                                     .setDescriptorCount(1)
+                                     .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+                                     .setPBufferInfo(&bufferInfo);
+
+    device.Handle()->updateDescriptorSets({ imageDescriptorWrite, bufferDescriptorWrite }, {});
+
+    // Pipeline
+    VulkanShader shader(device, VulkanShader::Type::Compute, "Resources/Shaders/DepthPyramid.comp");
+
+    auto pushConstant = vk::PushConstantRange()
+                            .setOffset(0)
+                            .setSize(sizeof(LevelConstants))
+                            .setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+    auto pipelineLayoutCreateInfo = vk::PipelineLayoutCreateInfo()
+                                        .setSetLayoutCount(1)
+                                        .setPSetLayouts(&mDescriptorSetLayout.get())
+                                        .setPushConstantRangeCount(1)
+                                        .setPPushConstantRanges(&pushConstant);
+
+    mPipelineLayout = device.Handle()->createPipelineLayoutUnique(pipelineLayoutCreateInfo);
+
+    auto stageInfo = vk::PipelineShaderStageCreateInfo()
+                         .setStage(vk::ShaderStageFlagBits::eCompute)
+                         .setModule(shader.Handle().get())
+                         .setPName("main");
+
+    auto pipelineCreateInfo = vk::ComputePipelineCreateInfo().setStage(stageInfo).setLayout(mPipelineLayout.get());
+    mPipeline = device.Handle()->createComputePipelineUnique({}, pipelineCreateInfo).value;
+}
+
+void
+VulkanDepthPyramid::Record(vk::CommandBuffer& commandBuffer) const
+{
+    auto depthRange = vk::ImageSubresourceRange()
+                          .setAspectMask(vk::ImageAspectFlagBits::eDepth)
+                          .setBaseMipLevel(0)
+                          .setLevelCount(1)
+                          .setBaseArrayLayer(0)
+                          .setLayerCount(1);
+
+    // Depth writes of the render pass land before the first level reads them
+    auto toShaderRead = vk::ImageMemoryBarrier()
+                            .setSrcAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+                            .setDstAccessMask(vk::AccessFlagBits::eShaderRead)
+                            .setOldLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal)
+                            .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+                            .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                            .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                            .setImage(mDepthImage.Handle())
+                            .setSubresourceRange(depthRange);
+
+    commandBuffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+        vk::PipelineStageFlagBits::eComputeShader,
+        {},
+        {},
+        {},
+        toShaderRead);
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, mPipeline.get());
+    commandBuffer.bindDescriptorSets(
+        vk::PipelineBindPoint::eCompute, mPipelineLayout.get(), 0, 1, &mDescriptorSet.get(), 0, {});
+
+    // Every level reads the one written by the previous dispatch
+    auto levelBarrier = vk::MemoryBarrier()
+                            .setSrcAccessMask(vk::AccessFlagBits::eShaderWrite)
+                            .setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+
+    const std::vector<Core::DepthPyramid::Level>& levels = mPyramid.GetLevels();
+
+    for (std::size_t i = 0; i < levels.size(); i++)
+    {
+        LevelConstants constants;
+        constants.size = glm::uvec2(levels[i].width, levels[i].height);
+        constants.offset = static_cast<std::uint32_t>(levels[i].offset);
+
+        if (i == 0)
+        {
+            constants.sourceSize = glm::uvec2(mExtent.width, mExtent.height);
+            constants.samples = static_cast<std::uint32_t>(mDevice.GetMsaaSamples());
+        }
+        else
+        {
+            constants.sourceSize = glm::uvec2(levels[i - 1].width, levels[i - 1].height);
+            constants.sourceOffset = static_cast<std::uint32_t>(levels[i - 1].offset);
+
+            commandBuffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::PipelineStageFlagBits::eComputeShader,
+                {},
+                levelBarrier,
+                {},
+                {});
+        }
+
+        commandBuffer.pushConstants(
+            mPipelineLayout.get(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(LevelConstants), &constants);
+
+        commandBuffer.dispatch(
+            (levels[i].width + GroupSize - 1) / GroupSize, (levels[i].height + GroupSize - 1) / GroupSize, 1);
+    }
+
+    // Depth goes back to the attachment for the passes that follow, the levels go to the host
+    auto toAttachment = vk::ImageMemoryBarrier()
+                            .setSrcAccessMask(vk::AccessFlagBits::eShaderRead)
+                            .setDstAccessMask(
+                                vk::AccessFlagBits::eDepthStencilAttachmentRead
+                                | vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+                            .setOldLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+                            .setNewLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal)
+                            .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                            .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                            .setImage(mDepthImage.Handle())
+                            .setSubresourceRange(depthRange);
+
+    auto toHost = vk::MemoryBarrier()
+                      .setSrcAccessMask(vk::AccessFlagBits::eShaderWrite)
+                      .setDstAccessMask(vk::AccessFlagBits::eHostRead);
+
+    commandBuffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests
+            | vk::PipelineStageFlagBits::eHost,
+        {},
+        toHost,
+        {},
+        toAttachment);
+}
+
+const Core::DepthPyramid&
+VulkanDepthPyramid::Read()
+{
+    std::span<float> depths = mPyramid.GetDepths();
+    mBuffer.Read([&depths](const void* memory) { std::memcpy(depths.data(), memory, depths.size_bytes()); });
+
+    return mPyramid;
+}
+
+} // namespace Lucid::Vulkan
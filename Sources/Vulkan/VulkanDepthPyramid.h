@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Core/DepthPyramid.h>
+#include <Vulkan/VulkanBuffer.h>
+#include <vulkan/vulkan.hpp>
+
+namespace Lucid::Vulkan
+{
+
+class VulkanDevice;
+class VulkanImage;
+
+/*
+        Builds a Core::DepthPyramid from the multisampled depth attachment, one compute dispatch per level.
+        Levels are written straight to host visible memory, the CPU reads them once the frame finished
+        and culls occluded instances against them.
+*/
+class VulkanDepthPyramid
+{
+public:
+    // The depth image needs sampled usage, see VulkanDevice::SupportsDepthSampling
+    VulkanDepthPyramid(VulkanDevice& device, const VulkanImage& depthImage, const vk::Extent2D& extent);
+
+    // After the render pass, the depth attachment is back in its attachment layout afterwards
+    void Record(vk::CommandBuffer& commandBuffer) const;
+
+    // Once the recorded commands finished on the device
+    [[nodiscard]] const Core::DepthPyramid& Read();
+
+private:
+    VulkanDevice& mDevice;
+    const VulkanImage& mDepthImage;
+    vk::Extent2D mExtent;
+
+    Core::DepthPyramid mPyramid;
+    VulkanBuffer mBuffer;
+
+    vk::UniqueDescriptorSetLayout mDescriptorSetLayout;
+    vk::UniqueDescriptorPool mDescriptorPool;
+    vk::UniqueDescriptorSet mDescriptorSet;
+    vk::UniquePipelineLayout mPipelineLayout;
+    vk::UniquePipeline mPipeline;
+};
+
+} // namespace Lucid::Vulkan
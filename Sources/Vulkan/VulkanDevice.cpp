@@ -69,8 +69,17 @@ VulkanDevice::InitLogicalDeviceForSurface(const VulkanSurface& surface) noexcept
 {
     QueueFamilies queueFamilies = { FindGraphicsQueueFamily(), FindPresentQueueFamily(surface) };
 
-    auto deviceFeatures
-        = vk::PhysicalDeviceFeatures().setFillModeNonSolid(true).setSamplerAnisotropy(true).setSampleRateShading(true);
+    mSupportsTextureCompression = mPhysicalDevice.getFeatures().textureCompressionBC;
+    mSupportsPipelineStatistics = mPhysicalDevice.getFeatures().pipelineStatisticsQuery;
+    mSupportsMultiDrawIndirect = mPhysicalDevice.getFeatures().multiDrawIndirect;
+
+    auto deviceFeatures = vk::PhysicalDeviceFeatures()
+                              .setFillModeNonSolid(true)
+                              .setSamplerAnisotropy(true)
+                              .setSampleRateShading(true)
+                              .setTextureCompressionBC(mSupportsTextureCompression)
+                              .setPipelineStatisticsQuery(mSupportsPipelineStatistics)
+                              .setMultiDrawIndirect(mSupportsMultiDrawIndirect);
 
     const float queuePriority = 1.0f;
 
@@ -244,6 +253,31 @@ VulkanDevice::DoesSupportBlitting(vk::Format format)
     return static_cast<bool>(properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear);
 }
 
+bool
+VulkanDevice::SupportsTextureCompression() const
+{
+    return mSupportsTextureCompression;
+}
+
+bool
+VulkanDevice::SupportsPipelineStatistics() const
+{
+    return mSupportsPipelineStatistics;
+}
+
+bool
+VulkanDevice::SupportsMultiDrawIndirect() const
+{
+    return mSupportsMultiDrawIndirect;
+}
+
+bool
+VulkanDevice::SupportsDepthSampling()
+{
+    auto properties = GetPhysicalDevice().getFormatProperties(FindSupportedDepthFormat());
+    return static_cast<bool>(properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
+}
+
 vk::SampleCountFlagBits
 VulkanDevice::GetMsaaSamples() const
 {
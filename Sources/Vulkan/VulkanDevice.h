@@ -45,6 +45,10 @@ public:
     [[nodiscard]] vk::PhysicalDevice& GetPhysicalDevice() noexcept;
     [[nodiscard]] vk::Format FindSupportedDepthFormat();
     [[nodiscard]] bool DoesSupportBlitting(vk::Format format);
+    [[nodiscard]] bool SupportsTextureCompression() const;
+    [[nodiscard]] bool SupportsPipelineStatistics() const;
+    [[nodiscard]] bool SupportsMultiDrawIndirect() const;
+    [[nodiscard]] bool SupportsDepthSampling(); // Shaders can read the depth attachment
     [[nodiscard]] vk::SampleCountFlagBits GetMsaaSamples() const;
 
 private:
@@ -55,6 +59,9 @@ private:
     vk::Queue mGraphicsQueue;
     vk::Queue mPresentQueue;
     vk::SampleCountFlagBits mMsaaSamples;
+    bool mSupportsTextureCompression = false;
+    bool mSupportsPipelineStatistics = false;
+    bool mSupportsMultiDrawIndirect = false;
 
 #if __APPLE__
     const std::vector<const char*> mExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME, "VK_KHR_portability_subset" };
@@ -1,9 +1,8 @@
 #include "VulkanImage.h"
 
-#include <numeric>
-
 #include <Utils/Files.h>
 #include <Utils/Logger.hpp>
+#include <Utils/Textures/MipGenerator.h>
 #include <Vulkan/VulkanBuffer.h>
 #include <Vulkan/VulkanCommandPool.h>
 #include <Vulkan/VulkanDevice.h>
@@ -11,35 +10,49 @@
 namespace Lucid::Vulkan
 {
 
-VulkanImage::VulkanImage(VulkanDevice& device, VulkanCommandPool& commandPool, const Core::TexturePtr& texture)
+VulkanImage::VulkanImage(
+    VulkanDevice& device,
+    VulkanCommandPool& commandPool,
+    const Core::TexturePtr& source,
+    vk::ImageCreateFlags flags)
     : mDevice(device)
 {
+    if (source->IsCompressed() && !device.SupportsTextureCompression())
+    {
+        throw std::runtime_error("Device doesn't support BC textures, disable Defaults::CompressTextures");
+    }
+
+    // Every level is prepared on the CPU, so uploading needs neither blit support nor per level barriers
+    Core::Texture layout = GetUploadLayout(*source);
+    vk::Format format = GetFormat(layout.format);
+
+    // Host cached memory keeps the reads done by mip generation fast
     VulkanBuffer stagingBuffer(
         device,
-        texture->pixels.size(),
+        layout.StoredByteSize(),
         vk::BufferUsageFlagBits::eTransferSrc,
-        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        vk::MemoryPropertyFlagBits::eHostCached);
 
-    stagingBuffer.Write(texture->pixels.data());
+    stagingBuffer.Write([&](void* memory) { Stage(*source, layout, static_cast<unsigned char*>(memory)); });
 
     auto createInfo = vk::ImageCreateInfo()
                           .setImageType(vk::ImageType::e2D)
-                          .setExtent(vk::Extent3D().setWidth(texture->size.x).setHeight(texture->size.y).setDepth(1))
+                          .setExtent(vk::Extent3D().setWidth(layout.size.x).setHeight(layout.size.y).setDepth(1))
                           .setMipLevels(1)
-                          .setArrayLayers(1)
-                          .setFormat(vk::Format::eR8G8B8A8Srgb)
+                          .setArrayLayers(layout.layers)
+                          .setFormat(format)
                           .setTiling(vk::ImageTiling::eOptimal)
                           .setInitialLayout(vk::ImageLayout::eUndefined)
-                          .setUsage(
-                              vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled
-                              | vk::ImageUsageFlagBits::eTransferSrc)
+                          .setUsage(vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled)
                           .setSharingMode(vk::SharingMode::eExclusive)
                           .setSamples(vk::SampleCountFlagBits::e1)
-                          .setMipLevels(texture->mipLevels);
+                          .setMipLevels(layout.mipLevels)
+                          .setFlags(flags);
 
     mUniqueImageHolder = device.Handle()->createImageUnique(createInfo);
     mHandle = mUniqueImageHolder.value().get();
-    mMipLevels = texture->mipLevels;
+    mMipLevels = layout.mipLevels;
 
     vk::MemoryRequirements requirements = device.Handle()->getImageMemoryRequirements(Handle());
     std::uint32_t memoryType
@@ -50,85 +63,17 @@ VulkanImage::VulkanImage(VulkanDevice& device, VulkanCommandPool& commandPool, c
     mDeviceMemory = device.Handle()->allocateMemoryUnique(allocateInfo);
     device.Handle()->bindImageMemory(Handle(), mDeviceMemory.get(), 0);
 
-    Transition(
-        commandPool, vk::Format::eR8G8B8A8Srgb, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
-    Write(commandPool, stagingBuffer, texture->size);
-    GenerateMipmaps(commandPool, texture->size, vk::Format::eR8G8B8A8Srgb);
-}
-
-VulkanImage::VulkanImage(
-    VulkanDevice& device,
-    VulkanCommandPool& commandPool,
-    const std::array<Core::TexturePtr, 6>& textures)
-    : mDevice(device)
-{
-    (void)commandPool;
-
-    std::size_t stagingSize = std::accumulate(
-        textures.begin(),
-        textures.end(),
-        static_cast<std::size_t>(0),
-        [](std::size_t accumulator, const Core::TexturePtr& value) { return accumulator + value->pixels.size(); });
-
-    VulkanBuffer stagingBuffer(
-        device,
-        stagingSize,
-        vk::BufferUsageFlagBits::eTransferSrc,
-        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-
-    std::size_t offset { 0 };
-    for (const auto& texture : textures)
-    {
-        stagingBuffer.Write(texture->pixels.data(), texture->pixels.size(), offset);
-        offset += texture->pixels.size();
-    }
-
-    auto& firstTexture = textures.at(0);
-
-    auto createInfo
-        = vk::ImageCreateInfo()
-              .setImageType(vk::ImageType::e2D)
-              .setExtent(vk::Extent3D().setWidth(firstTexture->size.x).setHeight(firstTexture->size.y).setDepth(1))
-              .setMipLevels(1)
-              .setArrayLayers(static_cast<std::uint32_t>(textures.size()))
-              .setFormat(vk::Format::eR8G8B8A8Srgb)
-              .setTiling(vk::ImageTiling::eOptimal)
-              .setInitialLayout(vk::ImageLayout::eUndefined)
-              .setUsage(
-                  vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled
-                  | vk::ImageUsageFlagBits::eTransferSrc)
-              .setSharingMode(vk::SharingMode::eExclusive)
-              .setSamples(vk::SampleCountFlagBits::e1)
-              .setMipLevels(firstTexture->mipLevels)
-              .setFlags(vk::ImageCreateFlagBits::eCubeCompatible);
-
-    mUniqueImageHolder = device.Handle()->createImageUnique(createInfo);
-    mHandle = mUniqueImageHolder.value().get();
-
-    vk::MemoryRequirements requirements = device.Handle()->getImageMemoryRequirements(Handle());
-    std::uint32_t memoryType
-        = VulkanBuffer::FindMemoryType(device, requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
-
-    auto allocateInfo = vk::MemoryAllocateInfo().setAllocationSize(requirements.size).setMemoryTypeIndex(memoryType);
-
-    mDeviceMemory = device.Handle()->allocateMemoryUnique(allocateInfo);
-    device.Handle()->bindImageMemory(Handle(), mDeviceMemory.get(), 0);
-
-    Transition(
-        commandPool,
-        vk::Format::eR8G8B8A8Srgb,
-        vk::ImageLayout::eUndefined,
-        vk::ImageLayout::eTransferDstOptimal,
-        textures.size());
-
-    Write(commandPool, stagingBuffer, firstTexture->size, textures.size());
+    std::vector<vk::BufferImageCopy> regions;
+    AppendCopyRegions(regions, layout, 0);
 
+    Transition(commandPool, format, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, layout.layers);
+    Write(commandPool, stagingBuffer, regions);
     Transition(
         commandPool,
-        vk::Format::eR8G8B8A8Srgb,
+        format,
         vk::ImageLayout::eTransferDstOptimal,
         vk::ImageLayout::eShaderReadOnlyOptimal,
-        textures.size());
+        layout.layers);
 }
 
 std::unique_ptr<VulkanImage>
@@ -138,13 +83,20 @@ VulkanImage::CreateDepthImage(
     vk::Format format,
     vk::ImageAspectFlags aspectFlags)
 {
+    // Sampled as well when possible, the depth pyramid reads it after the render pass
+    vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eDepthStencilAttachment;
+    if (device.SupportsDepthSampling())
+    {
+        usage |= vk::ImageUsageFlagBits::eSampled;
+    }
+
     VulkanImage result(
         device,
         swapchainExtent.width,
         swapchainExtent.height,
         device.FindSupportedDepthFormat(),
         vk::ImageTiling::eOptimal,
-        vk::ImageUsageFlagBits::eDepthStencilAttachment,
+        usage,
         vk::MemoryPropertyFlagBits::eDeviceLocal);
 
     result.GenerateImageView(format, aspectFlags, vk::ImageViewType::e2D);
@@ -164,11 +116,10 @@ VulkanImage::FromTexture(
     VulkanDevice& device,
     VulkanCommandPool& commandPool,
     const Core::TexturePtr& texture,
-    vk::Format format,
     vk::ImageAspectFlags aspectFlags)
 {
-    VulkanImage result(device, commandPool, texture);
-    result.GenerateImageView(format, aspectFlags, vk::ImageViewType::e2D);
+    VulkanImage result(device, commandPool, texture, {});
+    result.GenerateImageView(GetFormat(texture->format), aspectFlags, vk::ImageViewType::e2D);
     return std::make_unique<VulkanImage>(std::move(result));
 }
 
@@ -176,12 +127,16 @@ std::unique_ptr<VulkanImage>
 VulkanImage::FromCubemap(
     VulkanDevice& device,
     VulkanCommandPool& commandPool,
-    const std::array<Core::TexturePtr, 6>& textures,
-    vk::Format format,
+    const Core::TexturePtr& cubemap,
     vk::ImageAspectFlags aspectFlags)
 {
-    VulkanImage result(device, commandPool, textures);
-    result.GenerateImageView(format, aspectFlags, vk::ImageViewType::eCube, textures.size());
+    if (cubemap->layers != 6)
+    {
+        throw std::runtime_error("Cubemap texture must have 6 layers");
+    }
+
+    VulkanImage result(device, commandPool, cubemap, vk::ImageCreateFlagBits::eCubeCompatible);
+    result.GenerateImageView(GetFormat(cubemap->format), aspectFlags, vk::ImageViewType::eCube, cubemap->layers);
     return std::make_unique<VulkanImage>(std::move(result));
 }
 
@@ -311,27 +266,93 @@ void
 VulkanImage::Write(
     VulkanCommandPool& commandPool,
     const VulkanBuffer& buffer,
-    const Core::Vector2d<std::uint32_t>& size,
-    std::size_t layerCount)
+    const std::vector<vk::BufferImageCopy>& regions)
 {
+    // Every level and layer goes in a single copy command
     commandPool.ExecuteSingleCommand(
         [&, this](vk::CommandBuffer& commandBuffer)
         {
-            auto region = vk::BufferImageCopy()
-                              .setBufferOffset(0)
+            commandBuffer.copyBufferToImage(
+                buffer.Handle().get(), Handle(), vk::ImageLayout::eTransferDstOptimal, regions);
+        });
+}
+
+void
+VulkanImage::AppendCopyRegions(
+    std::vector<vk::BufferImageCopy>& regions,
+    const Core::Texture& texture,
+    std::size_t bufferOffset)
+{
+    std::uint32_t storedLevels = texture.HasMipChain() ? texture.mipLevels : 1;
+
+    // Layers of a level are tightly packed, so a single region covers all of them
+    for (std::uint32_t level = 0; level < storedLevels; level++)
+    {
+        Core::Vector2d<std::uint32_t> size = texture.LevelSize(level);
+        std::size_t offset = texture.levelOffsets.empty() ? 0 : texture.levelOffsets.at(level);
+
+        regions.push_back(vk::BufferImageCopy()
+                              .setBufferOffset(bufferOffset + offset)
                               .setBufferRowLength(0)
                               .setBufferImageHeight(0)
                               .setImageSubresource(vk::ImageSubresourceLayers()
                                                        .setAspectMask(vk::ImageAspectFlagBits::eColor)
-                                                       .setMipLevel(0)
+                                                       .setMipLevel(level)
                                                        .setBaseArrayLayer(0)
-                                                       .setLayerCount(static_cast<std::uint32_t>(layerCount)))
+                                                       .setLayerCount(texture.layers))
                               .setImageOffset({ 0, 0, 0 })
-                              .setImageExtent({ size.x, size.y, 1 });
+                              .setImageExtent({ size.x, size.y, 1 }));
+    }
+}
 
-            commandBuffer.copyBufferToImage(
-                buffer.Handle().get(), Handle(), vk::ImageLayout::eTransferDstOptimal, region);
-        });
+Core::Texture
+VulkanImage::GetUploadLayout(const Core::Texture& source)
+{
+    Core::Texture layout;
+    layout.size = source.size;
+    layout.format = source.format;
+    layout.layers = source.layers;
+
+    if (source.HasMipChain())
+    {
+        layout.mipLevels = source.mipLevels;
+        layout.levelOffsets = source.levelOffsets;
+    }
+    else
+    {
+        // Missing levels can only be generated for uncompressed data
+        layout.mipLevels = source.IsCompressed() ? 1 : Textures::MipGenerator::GetMipLevels(source.size);
+        layout.ComputeLevelOffsets();
+    }
+
+    return layout;
+}
+
+void
+VulkanImage::Stage(const Core::Texture& source, const Core::Texture& layout, unsigned char* destination)
+{
+    source.DecodeInto(destination);
+
+    if (!source.HasMipChain() && layout.mipLevels > 1)
+    {
+        Textures::MipGenerator::GenerateLevels(layout, destination);
+    }
+}
+
+vk::Format
+VulkanImage::GetFormat(Core::TextureFormat format)
+{
+    switch (format)
+    {
+    case Core::TextureFormat::Rgba8Srgb:
+        return vk::Format::eR8G8B8A8Srgb;
+    case Core::TextureFormat::Bc1Srgb:
+        return vk::Format::eBc1RgbSrgbBlock;
+    case Core::TextureFormat::Bc7Srgb:
+        return vk::Format::eBc7SrgbBlock;
+    }
+
+    throw std::runtime_error("Unknown texture format");
 }
 
 const vk::ImageView&
@@ -362,113 +383,6 @@ VulkanImage::GenerateImageView(
     mImageView = mDevice.Handle()->createImageViewUnique(imageViewCreateInfo);
 }
 
-void
-VulkanImage::GenerateMipmaps(
-    VulkanCommandPool& commandPool,
-    const Core::Vector2d<std::uint32_t>& size,
-    vk::Format format,
-    std::size_t layerCount)
-{
-    if (!mDevice.DoesSupportBlitting(format))
-    {
-        throw std::runtime_error("Device doesn't support blitting");
-    }
-
-    commandPool.ExecuteSingleCommand(
-        [&, this](vk::CommandBuffer& commandBuffer)
-        {
-            auto barrier = vk::ImageMemoryBarrier()
-                               .setImage(Handle())
-                               .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
-                               .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
-                               .setSubresourceRange(vk::ImageSubresourceRange()
-                                                        .setAspectMask(vk::ImageAspectFlagBits::eColor)
-                                                        .setLayerCount(static_cast<std::uint32_t>(layerCount))
-                                                        .setLevelCount(1)
-                                                        .setBaseArrayLayer(0));
-
-            std::uint32_t mipWidth = size.x;
-            std::uint32_t mipHeight = size.y;
-
-            for (std::uint32_t i = 1; i < mMipLevels; i++)
-            {
-                barrier.subresourceRange.setBaseMipLevel(i - 1);
-                barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal)
-                    .setNewLayout(vk::ImageLayout::eTransferSrcOptimal)
-                    .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
-                    .setDstAccessMask(vk::AccessFlagBits::eTransferRead);
-
-                commandBuffer.pipelineBarrier(
-                    vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, barrier);
-
-                auto srcOffsets = std::array<vk::Offset3D, 2> {
-                    vk::Offset3D(0, 0, 0),
-                    vk::Offset3D(static_cast<std::int32_t>(mipWidth), static_cast<std::int32_t>(mipHeight), 1)
-                };
-                auto dstOffsets
-                    = std::array<vk::Offset3D, 2> { vk::Offset3D(0, 0, 0),
-                                                    vk::Offset3D(
-                                                        static_cast<std::int32_t>(mipWidth > 1 ? mipWidth / 2 : 1),
-                                                        static_cast<std::int32_t>(mipHeight > 1 ? mipHeight / 2 : 1),
-                                                        1) };
-
-                auto blit = vk::ImageBlit()
-                                .setSrcOffsets(srcOffsets)
-                                .setSrcSubresource(vk::ImageSubresourceLayers()
-                                                       .setAspectMask(vk::ImageAspectFlagBits::eColor)
-                                                       .setMipLevel(i - 1)
-                                                       .setBaseArrayLayer(0)
-                                                       .setLayerCount(static_cast<std::uint32_t>(layerCount)))
-                                .setDstOffsets(dstOffsets)
-                                .setDstSubresource(vk::ImageSubresourceLayers()
-                                                       .setAspectMask(vk::ImageAspectFlagBits::eColor)
-                                                       .setMipLevel(i)
-                                                       .setBaseArrayLayer(0)
-                                                       .setLayerCount(static_cast<std::uint32_t>(layerCount)));
-
-                commandBuffer.blitImage(
-                    Handle(),
-                    vk::ImageLayout::eTransferSrcOptimal,
-                    Handle(),
-                    vk::ImageLayout::eTransferDstOptimal,
-                    blit,
-                    vk::Filter::eLinear);
-
-                barrier.setOldLayout(vk::ImageLayout::eTransferSrcOptimal)
-                    .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
-                    .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
-                    .setDstAccessMask(vk::AccessFlagBits::eShaderRead);
-
-                commandBuffer.pipelineBarrier(
-                    vk::PipelineStageFlagBits::eTransfer,
-                    vk::PipelineStageFlagBits::eFragmentShader,
-                    {},
-                    {},
-                    {},
-                    barrier);
-
-                if (mipWidth > 1)
-                {
-                    mipWidth /= 2;
-                }
-
-                if (mipHeight > 1)
-                {
-                    mipHeight /= 2;
-                }
-            }
-
-            barrier.subresourceRange.setBaseMipLevel(mMipLevels - 1);
-            barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal)
-                .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
-                .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
-                .setDstAccessMask(vk::AccessFlagBits::eShaderRead);
-
-            commandBuffer.pipelineBarrier(
-                vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, barrier);
-        });
-}
-
 bool
 VulkanImage::HasStencil(vk::Format format) const
 {
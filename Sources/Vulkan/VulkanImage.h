@@ -39,14 +39,12 @@ public:
         VulkanDevice& device,
         VulkanCommandPool& commandPool,
         const Core::TexturePtr& texture,
-        vk::Format format,
         vk::ImageAspectFlags aspectFlags);
 
     static std::unique_ptr<VulkanImage> FromCubemap(
         VulkanDevice& device,
         VulkanCommandPool& commandPool,
-        const std::array<Core::TexturePtr, 6>& textures,
-        vk::Format format,
+        const Core::TexturePtr& cubemap,
         vk::ImageAspectFlags aspectFlags);
 
     static std::unique_ptr<VulkanImage>
@@ -62,8 +60,15 @@ public:
     void Write(
         VulkanCommandPool& commandPool,
         const VulkanBuffer& buffer,
-        const Core::Vector2d<std::uint32_t>& size,
-        std::size_t layerCount = 1);
+        const std::vector<vk::BufferImageCopy>& regions);
+
+    // Adds one copy region per stored level of texture, read from bufferOffset onwards
+    static void AppendCopyRegions(
+        std::vector<vk::BufferImageCopy>& regions,
+        const Core::Texture& texture,
+        std::size_t bufferOffset);
+
+    static vk::Format GetFormat(Core::TextureFormat format);
 
     [[nodiscard]] const vk::ImageView& GetImageView() const;
     [[nodiscard]] bool HasStencil(vk::Format format) const;
@@ -81,9 +86,15 @@ private:
 
     VulkanImage(VulkanDevice& device, vk::Image image);
 
-    VulkanImage(VulkanDevice& device, VulkanCommandPool& commandPool, const Core::TexturePtr& texture);
+    VulkanImage(
+        VulkanDevice& device,
+        VulkanCommandPool& commandPool,
+        const Core::TexturePtr& source,
+        vk::ImageCreateFlags flags);
 
-    VulkanImage(VulkanDevice& device, VulkanCommandPool& commandPool, const std::array<Core::TexturePtr, 6>& textures);
+    // Describes the levels that end up in staging memory, including the ones generated on upload
+    static Core::Texture GetUploadLayout(const Core::Texture& source);
+    static void Stage(const Core::Texture& source, const Core::Texture& layout, unsigned char* destination);
 
     void GenerateImageView(
         vk::Format format,
@@ -91,12 +102,6 @@ private:
         vk::ImageViewType viewType,
         std::size_t layerCount = 1);
 
-    void GenerateMipmaps(
-        VulkanCommandPool& commandPool,
-        const Core::Vector2d<std::uint32_t>& size,
-        vk::Format format,
-        std::size_t layerCount = 1);
-
     VulkanDevice& mDevice;
     vk::UniqueDeviceMemory mDeviceMemory;
     vk::UniqueImageView mImageView;
@@ -1,61 +1,359 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <Core/Frustum.h>
 #include <Core/UniformBufferObject.h>
-#include <Utils/Files.h>
+#include <Utils/Defaults.hpp>
 #include <Vulkan/VulkanDevice.h>
 #include <Vulkan/VulkanMesh.h>
 
 namespace Lucid::Vulkan
 {
 
+namespace
+{
+
+// Scales the radius by the largest axis scale, which keeps the sphere conservative under non uniform scaling
+glm::vec4
+TransformSphere(const glm::vec4& sphere, const glm::mat4& transform)
+{
+    float scale = std::max({ glm::length(glm::vec3(transform[0])),
+                             glm::length(glm::vec3(transform[1])),
+                             glm::length(glm::vec3(transform[2])) });
+
+    return glm::vec4(glm::vec3(transform * glm::vec4(glm::vec3(sphere), 1.0f)), sphere.w * scale);
+}
+
+} // namespace
+
 VulkanMesh::VulkanMesh(
     VulkanDevice& device,
-    VulkanDescriptorPool& pool,
-    VulkanCommandPool& manager,
-    const Core::MeshPtr& mesh)
-    : mVertexBuffer(device, manager, mesh->vertices)
-    , mIndexBuffer(device, manager, mesh->indices)
-    , mUniformBuffer(device)
+    std::shared_ptr<const VulkanResourceCache::Geometry> geometry,
+    std::shared_ptr<const VulkanResourceCache::Texture> texture)
+    : mDevice(device)
+    , mGeometry(std::move(geometry))
+    , mTexture(std::move(texture))
+{
+    if (mGeometry->meshlets.size() > 1)
+    {
+        mIndirectBuffer = std::make_unique<VulkanIndirectBuffer>(device, mGeometry->meshlets.size());
+        mMultiDrawIndirect = device.SupportsMultiDrawIndirect();
+    }
+}
+
+void
+VulkanMesh::BindGeometry(vk::CommandBuffer& commandBuffer, bool positionsOnly) const
 {
-    static auto DefaultTexture = Lucid::Files::LoadTexture("Resources/Textures/Default.png");
+    const VulkanVertexBuffer& vertexBuffer = positionsOnly ? mGeometry->positionBuffer : mGeometry->vertexBuffer;
+    vk::Buffer vertexBuffers[] = { vertexBuffer.Handle().get() };
+    vk::DeviceSize offsets[] = { 0 };
+    commandBuffer.bindVertexBuffers(0, 1, vertexBuffers, offsets);
+    commandBuffer.bindIndexBuffer(mGeometry->indexBuffer.Handle().get(), 0, mGeometry->indexBuffer.GetIndexType());
+}
 
-    mTexture = VulkanImage::FromTexture(
-        device,
-        manager,
-        mesh->texture == nullptr ? DefaultTexture : mesh->texture,
-        vk::Format::eR8G8B8A8Srgb,
-        vk::ImageAspectFlagBits::eColor);
+void
+VulkanMesh::Draw(vk::CommandBuffer& commandBuffer) const
+{
+    if (mInstanceBuffer == nullptr || mVisibleTransforms.empty())
+    {
+        return;
+    }
 
-    mSampler = std::make_unique<VulkanSampler>(device, mTexture->GetMipLevels());
-    mDescriptorSet = std::make_unique<VulkanDescriptorSet>(device, pool);
+    vk::Buffer instanceBuffers[] = { mInstanceBuffer->Handle().get() };
+    vk::DeviceSize offsets[] = { 0 };
+    commandBuffer.bindVertexBuffers(1, 1, instanceBuffers, offsets);
+
+    if (mMeshletsCulled)
+    {
+        auto stride = static_cast<std::uint32_t>(sizeof(vk::DrawIndexedIndirectCommand));
+        auto count = static_cast<std::uint32_t>(mDrawCommands.size());
+
+        if (mMultiDrawIndirect)
+        {
+            commandBuffer.drawIndexedIndirect(mIndirectBuffer->Handle().get(), 0, count, stride);
+            return;
+        }
 
-    auto bufferInfo = vk::DescriptorBufferInfo()
-                          .setBuffer(mUniformBuffer.Handle().get())
-                          .setOffset(0)
-                          .setRange(sizeof(Core::UniformBufferObject));
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            commandBuffer.drawIndexedIndirect(mIndirectBuffer->Handle().get(), vk::DeviceSize(i) * stride, 1, stride);
+        }
+        return;
+    }
 
-    auto imageInfo = vk::DescriptorImageInfo()
-                         .setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
-                         .setImageView(mTexture->GetImageView())
-                         .setSampler(mSampler->Handle().get());
+    std::uint32_t firstInstance = 0;
+    for (std::size_t level = 0; level < mLevelInstances.size(); level++)
+    {
+        std::uint32_t count = mLevelInstances[level];
+        if (count == 0)
+        {
+            continue;
+        }
 
-    mDescriptorSet->Update(bufferInfo, imageInfo);
+        const VulkanResourceCache::Lod& lod = mGeometry->lods.at(level);
+        commandBuffer.drawIndexed(lod.indexCount, count, lod.firstIndex, 0, firstInstance);
+        firstInstance += count;
+    }
 }
 
 void
-VulkanMesh::Draw(vk::CommandBuffer& commandBuffer, VulkanPipeline& pipeline) const
+VulkanMesh::AddInstance(std::size_t nodeId)
 {
-    vk::Buffer vertexBuffers[] = { mVertexBuffer.Handle().get() };
-    vk::DeviceSize offsets[] = { 0 };
-    commandBuffer.bindVertexBuffers(0, 1, vertexBuffers, offsets);
-    commandBuffer.bindIndexBuffer(mIndexBuffer.Handle().get(), 0, vk::IndexType::eUint32);
-    commandBuffer.bindDescriptorSets(
-        vk::PipelineBindPoint::eGraphics, pipeline.Layout(), 0, 1, &mDescriptorSet->Handle().get(), 0, {});
-    commandBuffer.drawIndexed(static_cast<std::uint32_t>(mIndexBuffer.IndicesCount()), 1, 0, 0, 0);
+    mInstances.push_back(nodeId);
+    mLods.push_back(0);
+    mVisible.push_back(false);
+    mUnoccluded.push_back(false);
+    mSelected.push_back(false);
+}
+
+const std::vector<std::size_t>&
+VulkanMesh::GetInstances() const
+{
+    return mInstances;
+}
+
+void
+VulkanMesh::UpdateInstances(
+    const std::vector<glm::mat4>& transforms,
+    const std::vector<bool>& inFrustum,
+    const Core::UniformBufferObject& camera,
+    float viewportHeight,
+    bool occlusionCulling)
+{
+    if (mInstanceBuffer == nullptr || mInstanceBuffer->InstancesCount() < mInstances.size())
+    {
+        mInstanceBuffer = std::make_unique<VulkanInstanceBuffer>(mDevice, mInstances.size());
+    }
+
+    mTransforms = transforms;
+    mSpheres.resize(mInstances.size());
+
+    for (std::size_t i = 0; i < mInstances.size(); i++)
+    {
+        // Spheres of instances outside the frustum are never read
+        mVisible[i] = inFrustum.at(i);
+        if (mVisible[i])
+        {
+            mSpheres[i] = TransformSphere(mGeometry->boundingSphere, transforms.at(i));
+            mLods[i] = SelectLod(mLods[i], mSpheres[i], camera, viewportHeight);
+        }
+
+        // Instances occluded last frame are tested against this frame's depth first
+        mSelected[i] = mVisible[i] && (!occlusionCulling || mUnoccluded[i]);
+    }
+
+    WriteInstances(camera);
+}
+
+void
+VulkanMesh::CullOccluded(const Core::DepthPyramid& pyramid, const Core::UniformBufferObject& camera)
+{
+    glm::mat4 viewProjection = camera.projection * camera.view;
+
+    for (std::size_t i = 0; i < mInstances.size(); i++)
+    {
+        bool drawn = mSelected[i];
+        mUnoccluded[i] = mVisible[i] && !pyramid.IsOccluded(mSpheres[i], viewProjection);
+
+        // Drawn instances stay drawn even when they turn out occluded, they only drop out next frame
+        mSelected[i] = mUnoccluded[i] && !drawn;
+    }
+
+    WriteInstances(camera);
+}
+
+void
+VulkanMesh::WriteInstances(const Core::UniformBufferObject& camera)
+{
+    mLevelInstances.assign(mGeometry->lods.size(), 0);
+    mNearestDepth = std::numeric_limits<float>::max();
+
+    for (std::size_t i = 0; i < mInstances.size(); i++)
+    {
+        if (mSelected[i])
+        {
+            mLevelInstances[mLods[i]]++;
+
+            // The camera looks down negative z in view space
+            const glm::vec4& sphere = mSpheres[i];
+            float depth = -(camera.view * glm::vec4(glm::vec3(sphere), 1.0f)).z - sphere.w;
+            mNearestDepth = std::min(mNearestDepth, depth);
+        }
+    }
+
+    // Counting sort by level, each level then draws a contiguous range of instances
+    std::vector<std::uint32_t> offsets(mLevelInstances.size(), 0);
+    std::uint32_t visible = 0;
+    for (std::size_t level = 0; level < mLevelInstances.size(); level++)
+    {
+        offsets[level] = visible;
+        visible += mLevelInstances[level];
+    }
+
+    // Packed positions are relative to the mesh bounds, the dequantization goes in front of the instance transform
+    const glm::mat4& dequantization = mGeometry->vertexBuffer.GetDequantization();
+
+    mVisibleTransforms.resize(visible);
+    for (std::size_t i = 0; i < mInstances.size(); i++)
+    {
+        if (mSelected[i])
+        {
+            mVisibleTransforms[offsets[mLods[i]]++] = mTransforms[i] * dequantization;
+        }
+    }
+
+    if (!mVisibleTransforms.empty())
+    {
+        mInstanceBuffer->Write(mVisibleTransforms.data(), mVisibleTransforms.size() * sizeof(glm::mat4));
+    }
+
+    // Per meshlet culling pays off only when it doesn't split an instanced draw
+    mMeshletsCulled = mIndirectBuffer != nullptr && mInstances.size() == 1 && mSelected[0] && mLods[0] == 0;
+    if (mMeshletsCulled)
+    {
+        Core::UniformBufferObject ubo = camera;
+        ubo.model = mTransforms.at(0);
+        CullMeshlets(ubo);
+    }
+}
+
+std::size_t
+VulkanMesh::GetVisibleInstanceCount() const
+{
+    return mVisibleTransforms.size();
+}
+
+std::size_t
+VulkanMesh::GetOccludedInstanceCount() const
+{
+    std::size_t occluded = 0;
+    for (std::size_t i = 0; i < mInstances.size(); i++)
+    {
+        occluded += mVisible[i] && !mUnoccluded[i] ? 1u : 0u;
+    }
+
+    return occluded;
+}
+
+std::size_t
+VulkanMesh::GetDrawCount() const
+{
+    if (mVisibleTransforms.empty())
+    {
+        return 0;
+    }
+
+    if (mMeshletsCulled)
+    {
+        return mMultiDrawIndirect ? std::min<std::size_t>(mDrawCommands.size(), 1) : mDrawCommands.size();
+    }
+
+    return static_cast<std::size_t>(
+        std::count_if(mLevelInstances.begin(), mLevelInstances.end(), [](std::uint32_t count) { return count > 0; }));
+}
+
+float
+VulkanMesh::GetNearestDepth() const
+{
+    return mNearestDepth;
 }
 
 void
-VulkanMesh::UpdateTransform(const Core::UniformBufferObject& ubo)
+VulkanMesh::CullMeshlets(const Core::UniformBufferObject& ubo)
 {
-    mUniformBuffer.Write(const_cast<Core::UniformBufferObject*>(&ubo));
+    mDrawCommands.clear();
+    mVisibleMeshlets = 0;
+
+    // Both tests run in mesh space, back facing meshlets of double sided materials stay in
+    glm::mat4 modelView = ubo.view * ubo.model;
+    Core::Frustum frustum(ubo.projection * modelView);
+    glm::vec3 camera = glm::vec3(glm::inverse(modelView)[3]);
+    bool backFaceCulling = !mGeometry->doubleSided;
+
+    for (const Core::Meshlet& meshlet : mGeometry->meshlets)
+    {
+        if (frustum.IsOutside(meshlet.boundingSphere) || (backFaceCulling && meshlet.IsBackFacing(camera)))
+        {
+            continue;
+        }
+
+        mVisibleMeshlets++;
+
+        if (!mDrawCommands.empty()
+            && mDrawCommands.back().firstIndex + mDrawCommands.back().indexCount == meshlet.firstIndex)
+        {
+            mDrawCommands.back().indexCount += meshlet.indexCount;
+            continue;
+        }
+
+        mDrawCommands.push_back(vk::DrawIndexedIndirectCommand()
+                                    .setIndexCount(meshlet.indexCount)
+                                    .setInstanceCount(1)
+                                    .setFirstIndex(meshlet.firstIndex));
+    }
+
+    if (!mDrawCommands.empty())
+    {
+        mIndirectBuffer->Write(mDrawCommands.data(), mDrawCommands.size() * sizeof(vk::DrawIndexedIndirectCommand));
+    }
+}
+
+std::size_t
+VulkanMesh::GetMeshletCount() const
+{
+    return mMeshletsCulled ? mGeometry->meshlets.size() : 0;
+}
+
+std::size_t
+VulkanMesh::GetVisibleMeshletCount() const
+{
+    return mMeshletsCulled ? mVisibleMeshlets : 0;
+}
+
+std::size_t
+VulkanMesh::SelectLod(
+    std::size_t lod,
+    const glm::vec4& sphere,
+    const Core::UniformBufferObject& camera,
+    float viewportHeight) const
+{
+    const std::vector<VulkanResourceCache::Lod>& lods = mGeometry->lods;
+    if (lods.size() < 2)
+    {
+        return 0;
+    }
+
+    float radius = sphere.w;
+    float distance = glm::length(glm::vec3(camera.view * glm::vec4(glm::vec3(sphere), 1.0f)));
+
+    if (distance <= radius)
+    {
+        return 0;
+    }
+
+    // Radius of the bounds in pixels, the level errors scale with it
+    float projectedRadius = radius / distance * std::abs(camera.projection[1][1]) * viewportHeight * 0.5f;
+    auto pixelError = [&lods, projectedRadius](std::size_t level) { return lods.at(level).error * projectedRadius; };
+
+    // Refines only once the current level is clearly too coarse and coarsens only well below the threshold
+    if (pixelError(lod) > Defaults::LodPixelError * (1.0f + Defaults::LodHysteresis))
+    {
+        while (lod > 0 && pixelError(lod) > Defaults::LodPixelError)
+        {
+            lod--;
+        }
+    }
+    else
+    {
+        float coarsenBelow = Defaults::LodPixelError / (1.0f + Defaults::LodHysteresis);
+        while (lod + 1 < lods.size() && pixelError(lod + 1) <= coarsenBelow)
+        {
+            lod++;
+        }
+    }
+
+    return lod;
 }
 
 } // namespace Lucid::Vulkan
@@ -1,30 +1,106 @@
 #pragma once
 
+#include <Core/DepthPyramid.h>
 #include <Core/UniformBufferObject.h>
 #include <Vulkan/VulkanBuffer.h>
-#include <Vulkan/VulkanDescriptorPool.h>
-#include <Vulkan/VulkanDescriptorSet.h>
 #include <Vulkan/VulkanImage.h>
-#include <Vulkan/VulkanPipeline.h>
-#include <Vulkan/VulkanSampler.h>
+#include <Vulkan/VulkanResourceCache.h>
 
 namespace Lucid::Vulkan
 {
 
+/*
+        Every node drawing the same geometry with the same texture.
+        Visible instances are grouped by level in the instance buffer and drawn with one instanced draw per level.
+        Camera and texture descriptors are bound by the caller, so meshes sharing them are drawn without rebinding.
+*/
 class VulkanMesh
 {
 public:
-    VulkanMesh(VulkanDevice& device, VulkanDescriptorPool& pool, VulkanCommandPool& manager, const Core::MeshPtr& mesh);
-    void Draw(vk::CommandBuffer& commandBuffer, VulkanPipeline& pipeline) const;
-    void UpdateTransform(const Core::UniformBufferObject& ubo);
+    VulkanMesh(
+        VulkanDevice& device,
+        std::shared_ptr<const VulkanResourceCache::Geometry> geometry,
+        std::shared_ptr<const VulkanResourceCache::Texture> texture);
+
+    // Vertex and index buffers of the geometry, shared by every mesh drawing it
+    void BindGeometry(vk::CommandBuffer& commandBuffer, bool positionsOnly = false) const;
+    void Draw(vk::CommandBuffer& commandBuffer) const;
+
+    void AddInstance(std::size_t nodeId);
+    [[nodiscard]] const std::vector<std::size_t>& GetInstances() const;
+
+    /*
+            Picks the levels of the instances inside the frustum and writes the visible transforms.
+            Both vectors are in GetInstances() order, transforms of instances outside the frustum are ignored.
+            With occlusion culling only instances that passed the last occlusion test are written,
+            the others wait for CullOccluded.
+            A lone instance at the full level also gets its meshlets culled into indirect draws.
+    */
+    void UpdateInstances(
+        const std::vector<glm::mat4>& transforms,
+        const std::vector<bool>& inFrustum,
+        const Core::UniformBufferObject& camera,
+        float viewportHeight,
+        bool occlusionCulling);
+
+    /*
+            Second phase of occlusion culling, once the instances written by UpdateInstances were drawn
+            and the pyramid was built from their depth. Writes the held back instances that turned out visible
+            and remembers every unoccluded instance for the first phase of the next frame.
+    */
+    void CullOccluded(const Core::DepthPyramid& pyramid, const Core::UniformBufferObject& camera);
+
+    // Written for the current phase
+    [[nodiscard]] std::size_t GetVisibleInstanceCount() const;
+
+    // Inside the frustum but behind the depth pyramid, as of the last CullOccluded
+    [[nodiscard]] std::size_t GetOccludedInstanceCount() const;
+    [[nodiscard]] std::size_t GetDrawCount() const;
+
+    // View depth of the closest point of the closest visible instance bounds
+    [[nodiscard]] float GetNearestDepth() const;
+    [[nodiscard]] std::size_t GetMeshletCount() const;
+    [[nodiscard]] std::size_t GetVisibleMeshletCount() const;
 
 private:
-    VulkanVertexBuffer mVertexBuffer;
-    VulkanIndexBuffer mIndexBuffer;
-    VulkanUniformBuffer mUniformBuffer;
-    std::unique_ptr<VulkanImage> mTexture;
-    std::unique_ptr<VulkanSampler> mSampler;
-    std::unique_ptr<VulkanDescriptorSet> mDescriptorSet;
+    // Level for the next recorded frame from the projected size of the world space bounding sphere
+    [[nodiscard]] std::size_t SelectLod(
+        std::size_t lod,
+        const glm::vec4& sphere,
+        const Core::UniformBufferObject& camera,
+        float viewportHeight) const;
+
+    // Sorts the selected instances by level into the instance buffer
+    void WriteInstances(const Core::UniformBufferObject& camera);
+
+    void CullMeshlets(const Core::UniformBufferObject& ubo);
+
+    VulkanDevice& mDevice;
+
+    // Shared with every other node drawing the same Core::Mesh or Core::Texture
+    std::shared_ptr<const VulkanResourceCache::Geometry> mGeometry;
+    std::shared_ptr<const VulkanResourceCache::Texture> mTexture;
+
+    std::vector<std::size_t> mInstances; // Node ids
+    std::vector<std::size_t> mLods; // Per instance, kept while culled for the hysteresis
+    std::vector<bool> mVisible; // Per instance, inside the frustum
+    std::vector<bool> mUnoccluded; // Per instance, passed the last occlusion test
+    std::vector<bool> mSelected; // Per instance, written for the current phase
+    std::vector<glm::mat4> mTransforms; // Per instance, of the current frame
+    std::vector<glm::vec4> mSpheres; // Per instance, world space bounds
+
+    // Visible transforms ordered by level with the dequantization applied, reallocated once instances outgrow it
+    std::unique_ptr<VulkanInstanceBuffer> mInstanceBuffer;
+    std::vector<glm::mat4> mVisibleTransforms;
+    std::vector<std::uint32_t> mLevelInstances; // Visible instances per level
+    float mNearestDepth = 0.0f;
+
+    // Null unless the mesh has several meshlets
+    std::unique_ptr<VulkanIndirectBuffer> mIndirectBuffer;
+    std::vector<vk::DrawIndexedIndirectCommand> mDrawCommands; // Adjacent visible meshlets merged
+    std::size_t mVisibleMeshlets = 0;
+    bool mMeshletsCulled = false; // Draw through mIndirectBuffer this frame
+    bool mMultiDrawIndirect = false;
 };
 
 } // namespace Lucid::Vulkan
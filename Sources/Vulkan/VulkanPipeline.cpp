@@ -2,6 +2,7 @@
 
 #include <Core/Vertex.h>
 #include <Utils/Logger.hpp>
+#include <Vulkan/VulkanBuffer.h>
 #include <Vulkan/VulkanDescriptorPool.h>
 #include <Vulkan/VulkanDevice.h>
 #include <Vulkan/VulkanRenderPass.h>
@@ -17,8 +18,9 @@ VulkanPipeline::VulkanPipeline(
     VulkanRenderPass& renderPass,
     VulkanDescriptorPool& descriptorPool,
     const std::string& shaderName,
-    bool depthWriteTest,
-    vk::CullModeFlagBits cullMode)
+    DepthMode depthMode,
+    vk::CullModeFlagBits cullMode,
+    Core::VertexFormat vertexFormat)
 {
     VulkanShader vertexShader(device, VulkanShader::Type::Vertex, "Resources/Shaders/" + shaderName + ".vert");
     VulkanShader fragmentShader(device, VulkanShader::Type::Fragment, "Resources/Shaders/" + shaderName + ".frag");
@@ -35,8 +37,8 @@ VulkanPipeline::VulkanPipeline(
 
     vk::PipelineShaderStageCreateInfo shaderStages[] = { vertexShaderStageInfo, fragmentShaderStageInfo };
 
-    auto vertexBindingDescriptions = VulkanPipeline::GetBindingDescriptions();
-    auto vertexAttributeDescriptions = VulkanPipeline::GetAttributeDescriptions();
+    auto vertexBindingDescriptions = VulkanPipeline::GetBindingDescriptions(vertexFormat);
+    auto vertexAttributeDescriptions = VulkanPipeline::GetAttributeDescriptions(vertexFormat);
 
     auto vertexInputState
         = vk::PipelineVertexInputStateCreateInfo()
@@ -65,6 +67,7 @@ VulkanPipeline::VulkanPipeline(
                              .setScissorCount(1)
                              .setPScissors(&scissor);
 
+    // The projection flips y, so counter clockwise model triangles stay counter clockwise on screen
     auto rasterizationState = vk::PipelineRasterizationStateCreateInfo()
                                   .setDepthClampEnable(false)
                                   .setRasterizerDiscardEnable(false)
@@ -79,11 +82,16 @@ VulkanPipeline::VulkanPipeline(
                                 .setMinSampleShading(0.2f)
                                 .setRasterizationSamples(device.GetMsaaSamples());
 
-    auto colorBlendAttachmentState = vk::PipelineColorBlendAttachmentState()
-                                         .setColorWriteMask(
-                                             vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG
-                                             | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA)
-                                         .setBlendEnable(false);
+    vk::ColorComponentFlags colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG
+        | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+
+    if (depthMode == DepthMode::Prepass)
+    {
+        colorWriteMask = {};
+    }
+
+    auto colorBlendAttachmentState
+        = vk::PipelineColorBlendAttachmentState().setColorWriteMask(colorWriteMask).setBlendEnable(false);
 
     auto colorBlendState = vk::PipelineColorBlendStateCreateInfo()
                                .setLogicOpEnable(false)
@@ -106,10 +114,12 @@ VulkanPipeline::VulkanPipeline(
 
     mLayout = device.Handle()->createPipelineLayoutUnique(pipelineLayoutCreateInfo);
 
-    auto depthStencilState = vk::PipelineDepthStencilStateCreateInfo()
-                                 .setDepthTestEnable(depthWriteTest)
-                                 .setDepthWriteEnable(depthWriteTest)
-                                 .setDepthCompareOp(vk::CompareOp::eLess)
+    // Equal keeps the nearest surface of the prepass only, which needs bit identical depths from both pipelines
+    auto depthStencilState
+        = vk::PipelineDepthStencilStateCreateInfo()
+              .setDepthTestEnable(depthMode != DepthMode::Disabled)
+              .setDepthWriteEnable(depthMode == DepthMode::Less || depthMode == DepthMode::Prepass)
+              .setDepthCompareOp(depthMode == DepthMode::Equal ? vk::CompareOp::eEqual : vk::CompareOp::eLess)
                                  .setDepthBoundsTestEnable(false)
                                  .setStencilTestEnable(false);
 
@@ -135,10 +145,38 @@ VulkanPipeline::Default(
     VulkanDevice& device,
     const vk::Extent2D& extent,
     VulkanRenderPass& renderPass,
-    VulkanDescriptorPool& descriptorPool)
+    VulkanDescriptorPool& descriptorPool,
+    DepthMode depthMode,
+    vk::CullModeFlagBits cullMode)
+{
+    return std::make_unique<VulkanPipeline>(
+        device,
+        extent,
+        renderPass,
+        descriptorPool,
+        "Shader",
+        depthMode,
+        cullMode,
+        Core::VertexFormat::Packed);
+}
+
+std::unique_ptr<VulkanPipeline>
+VulkanPipeline::DepthPrepass(
+    VulkanDevice& device,
+    const vk::Extent2D& extent,
+    VulkanRenderPass& renderPass,
+    VulkanDescriptorPool& descriptorPool,
+    vk::CullModeFlagBits cullMode)
 {
     return std::make_unique<VulkanPipeline>(
-        device, extent, renderPass, descriptorPool, "Shader", true, vk::CullModeFlagBits::eNone);
+        device,
+        extent,
+        renderPass,
+        descriptorPool,
+        "Depth",
+        DepthMode::Prepass,
+        cullMode,
+        Core::VertexFormat::Position);
 }
 
 std::unique_ptr<VulkanPipeline>
@@ -149,7 +187,14 @@ VulkanPipeline::Skybox(
     VulkanDescriptorPool& descriptorPool)
 {
     return std::make_unique<VulkanPipeline>(
-        device, extent, renderPass, descriptorPool, "Skybox", false, vk::CullModeFlagBits::eNone);
+        device,
+        extent,
+        renderPass,
+        descriptorPool,
+        "Skybox",
+        DepthMode::Disabled,
+        vk::CullModeFlagBits::eNone,
+        Core::VertexFormat::Float);
 }
 
 const vk::PipelineLayout&
@@ -158,20 +203,91 @@ VulkanPipeline::Layout() const
     return mLayout.get();
 }
 
-std::array<vk::VertexInputBindingDescription, 1>
-VulkanPipeline::GetBindingDescriptions()
+std::vector<vk::VertexInputBindingDescription>
+VulkanPipeline::GetBindingDescriptions(Core::VertexFormat format)
 {
     auto description = vk::VertexInputBindingDescription()
                            .setBinding(0)
-                           .setStride(sizeof(Core::Vertex))
+                           .setStride(static_cast<std::uint32_t>(VulkanVertexBuffer::GetVertexSize(format)))
                            .setInputRate(vk::VertexInputRate::eVertex);
 
-    return { description };
+    if (format == Core::VertexFormat::Float)
+    {
+        return { description };
+    }
+
+    auto instanceDescription = vk::VertexInputBindingDescription()
+                                   .setBinding(1)
+                                   .setStride(static_cast<std::uint32_t>(sizeof(glm::mat4)))
+                                   .setInputRate(vk::VertexInputRate::eInstance);
+
+    return { description, instanceDescription };
 }
 
-std::array<vk::VertexInputAttributeDescription, 4>
-VulkanPipeline::GetAttributeDescriptions()
+std::vector<vk::VertexInputAttributeDescription>
+VulkanPipeline::GetAttributeDescriptions(Core::VertexFormat format)
 {
+    // A mat4 attribute takes four consecutive locations, one column each
+    auto appendInstanceModel = [](std::vector<vk::VertexInputAttributeDescription>& descriptions)
+    {
+        for (std::uint32_t column = 0; column < 4; column++)
+        {
+            descriptions.push_back(vk::VertexInputAttributeDescription()
+                                       .setBinding(1)
+                                       .setLocation(4 + column)
+                                       .setFormat(vk::Format::eR32G32B32A32Sfloat)
+                                       .setOffset(column * static_cast<std::uint32_t>(sizeof(glm::vec4))));
+        }
+    };
+
+    if (format == Core::VertexFormat::Position)
+    {
+        std::vector<vk::VertexInputAttributeDescription> descriptions = {
+            vk::VertexInputAttributeDescription()
+                .setBinding(0)
+                .setLocation(0)
+                .setFormat(vk::Format::eR16G16B16A16Snorm)
+                .setOffset(offsetof(Core::PackedPosition, positionXY)),
+        };
+
+        appendInstanceModel(descriptions);
+        return descriptions;
+    }
+
+    if (format == Core::VertexFormat::Packed)
+    {
+        // Locations stay the same as for float vertices, the formats let the input assembler unpack
+        auto positionDescription = vk::VertexInputAttributeDescription()
+                                       .setBinding(0)
+                                       .setLocation(0)
+                                       .setFormat(vk::Format::eR16G16B16A16Snorm)
+                                       .setOffset(offsetof(Core::PackedVertex, positionXY));
+
+        auto normalDescription = vk::VertexInputAttributeDescription()
+                                     .setBinding(0)
+                                     .setLocation(1)
+                                     .setFormat(vk::Format::eR16G16Snorm)
+                                     .setOffset(offsetof(Core::PackedVertex, normal));
+
+        auto colorDescription = vk::VertexInputAttributeDescription()
+                                    .setBinding(0)
+                                    .setLocation(2)
+                                    .setFormat(vk::Format::eR8G8B8A8Unorm)
+                                    .setOffset(offsetof(Core::PackedVertex, color));
+
+        auto uvDescription = vk::VertexInputAttributeDescription()
+                                 .setBinding(0)
+                                 .setLocation(3)
+                                 .setFormat(vk::Format::eR16G16Sfloat)
+                                 .setOffset(offsetof(Core::PackedVertex, uv));
+
+        std::vector<vk::VertexInputAttributeDescription> descriptions
+            = { positionDescription, normalDescription, colorDescription, uvDescription };
+
+        appendInstanceModel(descriptions);
+        return descriptions;
+    }
+
     auto positionDescription = vk::VertexInputAttributeDescription()
                                    .setBinding(0)
                                    .setLocation(0)
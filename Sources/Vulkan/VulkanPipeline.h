@@ -1,7 +1,9 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
+#include <Core/Vertex.h>
 #include <Vulkan/VulkanEntity.h>
 #include <vulkan/vulkan.hpp>
 
@@ -16,11 +18,29 @@ class VulkanDescriptorPool;
 class VulkanPipeline : public VulkanEntity<vk::UniquePipeline>
 {
 public:
+    enum class DepthMode
+    {
+        Disabled,
+        Less, // Test and write
+        Prepass, // Test and write depth only, color writes are masked
+        Equal, // Shade only what a prepass left visible, no writes
+    };
+
     static std::unique_ptr<VulkanPipeline> Default(
         VulkanDevice& device,
         const vk::Extent2D& extent,
         VulkanRenderPass& renderPass,
-        VulkanDescriptorPool& descriptorPool);
+        VulkanDescriptorPool& descriptorPool,
+        DepthMode depthMode = DepthMode::Less,
+        vk::CullModeFlagBits cullMode = vk::CullModeFlagBits::eBack);
+
+    // Same vertex transform as Default over positions only, so the depths match exactly
+    static std::unique_ptr<VulkanPipeline> DepthPrepass(
+        VulkanDevice& device,
+        const vk::Extent2D& extent,
+        VulkanRenderPass& renderPass,
+        VulkanDescriptorPool& descriptorPool,
+        vk::CullModeFlagBits cullMode = vk::CullModeFlagBits::eBack);
 
     static std::unique_ptr<VulkanPipeline> Skybox(
         VulkanDevice& device,
@@ -36,12 +56,16 @@ public:
         VulkanRenderPass& renderPass,
         VulkanDescriptorPool& descriptorPool,
         const std::string& shaderName,
-        bool depthWriteTest,
-        vk::CullModeFlagBits cullMode);
+        DepthMode depthMode,
+        vk::CullModeFlagBits cullMode,
+        Core::VertexFormat vertexFormat);
 
 private:
-    [[nodiscard]] static std::array<vk::VertexInputBindingDescription, 1> GetBindingDescriptions();
-    [[nodiscard]] static std::array<vk::VertexInputAttributeDescription, 4> GetAttributeDescriptions();
+    // Packed and position meshes also read a model matrix per instance from binding 1
+    [[nodiscard]] static std::vector<vk::VertexInputBindingDescription>
+    GetBindingDescriptions(Core::VertexFormat format);
+    [[nodiscard]] static std::vector<vk::VertexInputAttributeDescription>
+    GetAttributeDescriptions(Core::VertexFormat format);
 
     vk::UniquePipelineLayout mLayout;
 };
@@ -0,0 +1,79 @@
+#include "VulkanQueryPool.h"
+
+#include <array>
+
+#include <Vulkan/VulkanDevice.h>
+
+namespace Lucid::Vulkan
+{
+
+namespace
+{
+
+// Results are written in the order of the flag bits, which matches PipelineStatistics
+const vk::QueryPipelineStatisticFlags StatisticFlags = vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices
+    | vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations
+    | vk::QueryPipelineStatisticFlagBits::eClippingPrimitives
+    | vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+
+} // namespace
+
+VulkanQueryPool::VulkanQueryPool(VulkanDevice& device, std::uint32_t queryCount)
+    : mDevice(device)
+    , mQueryCount(queryCount)
+{
+    auto createInfo = vk::QueryPoolCreateInfo()
+                          .setQueryType(vk::QueryType::ePipelineStatistics)
+                          .setQueryCount(queryCount)
+                          .setPipelineStatistics(StatisticFlags);
+
+    mHandle = device.Handle()->createQueryPoolUnique(createInfo);
+}
+
+void
+VulkanQueryPool::Reset(vk::CommandBuffer& commandBuffer) const
+{
+    commandBuffer.resetQueryPool(Handle().get(), 0, mQueryCount);
+}
+
+void
+VulkanQueryPool::Begin(vk::CommandBuffer& commandBuffer, std::uint32_t query) const
+{
+    commandBuffer.beginQuery(Handle().get(), query, {});
+}
+
+void
+VulkanQueryPool::End(vk::CommandBuffer& commandBuffer, std::uint32_t query) const
+{
+    commandBuffer.endQuery(Handle().get(), query);
+}
+
+std::optional<VulkanQueryPool::PipelineStatistics>
+VulkanQueryPool::GetPipelineStatistics(std::uint32_t query) const
+{
+    std::array<std::uint64_t, 4> values {};
+
+    vk::Result result = mDevice.Handle()->getQueryPoolResults(
+        Handle().get(),
+        query,
+        1,
+        sizeof(values),
+        values.data(),
+        sizeof(values),
+        vk::QueryResultFlagBits::e64);
+
+    if (result != vk::Result::eSuccess)
+    {
+        return std::nullopt;
+    }
+
+    PipelineStatistics statistics;
+    statistics.inputVertices = values.at(0);
+    statistics.vertexShaderInvocations = values.at(1);
+    statistics.clippingPrimitives = values.at(2);
+    statistics.fragmentShaderInvocations = values.at(3);
+
+    return statistics;
+}
+
+} // namespace Lucid::Vulkan
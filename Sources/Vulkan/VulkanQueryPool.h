@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include <Vulkan/VulkanEntity.h>
+#include <vulkan/vulkan.hpp>
+
+namespace Lucid::Vulkan
+{
+
+class VulkanDevice;
+
+/*
+        Pipeline statistics queries around the passes of a frame, one per pass.
+        Every command buffer resets and records the same queries, only the submitted one writes them.
+*/
+class VulkanQueryPool : public VulkanEntity<vk::UniqueQueryPool>
+{
+public:
+    struct PipelineStatistics
+    {
+        std::uint64_t inputVertices = 0;
+        std::uint64_t vertexShaderInvocations = 0;
+        std::uint64_t clippingPrimitives = 0;
+        std::uint64_t fragmentShaderInvocations = 0;
+    };
+
+    VulkanQueryPool(VulkanDevice& device, std::uint32_t queryCount = 1);
+
+    // Every query, outside of a render pass
+    void Reset(vk::CommandBuffer& commandBuffer) const;
+
+    void Begin(vk::CommandBuffer& commandBuffer, std::uint32_t query = 0) const;
+    void End(vk::CommandBuffer& commandBuffer, std::uint32_t query = 0) const;
+
+    // Empty until the query was recorded and finished on the device
+    [[nodiscard]] std::optional<PipelineStatistics> GetPipelineStatistics(std::uint32_t query = 0) const;
+
+private:
+    VulkanDevice& mDevice;
+    std::uint32_t mQueryCount;
+};
+
+} // namespace Lucid::Vulkan
@@ -1,5 +1,7 @@
 #include "VulkanRender.h"
 
+#include <algorithm>
+
 #include <Core/InputController.h>
 #include <Core/UniformBufferObject.h>
 #include <Utils/Files.h>
@@ -28,11 +30,26 @@ VulkanRender::VulkanRender(const Core::IWindow& window, const Core::Scene& scene
     mDevice = std::make_unique<VulkanDevice>(mInstance->PickSuitableDeviceForSurface(*mSurface.get()));
     mDevice->InitLogicalDeviceForSurface(*mSurface.get());
 
+    if (Defaults::CompressTextures && !mDevice->SupportsTextureCompression())
+    {
+        LoggerWarning << "Device can't sample BC textures, textures are cooked uncompressed";
+    }
+
+    Files::SetTextureCompressionSupported(mDevice->SupportsTextureCompression());
+
     // Create descriptor pool
     mDescriptorPool = std::make_unique<VulkanDescriptorPool>(*mDevice.get());
 
     // Create command pool
     mCommandPool = std::make_unique<VulkanCommandPool>(*mDevice.get());
+    mLateCommandPool = std::make_unique<VulkanCommandPool>(*mDevice.get());
+    mResourceCache = std::make_unique<VulkanResourceCache>(*mDevice.get(), *mCommandPool.get());
+    mCameraBuffer = std::make_unique<VulkanUniformBuffer>(*mDevice.get());
+
+    if (mDevice->SupportsPipelineStatistics())
+    {
+        mQueryPool = std::make_unique<VulkanQueryPool>(*mDevice.get(), QueryCount);
+    }
 
     RecreateSwapchain();
 
@@ -211,44 +228,51 @@ VulkanRender::DrawFrame()
 {
     mDevice->Handle()->waitIdle();
 
+    ReadPipelineStatistics();
+
     Core::InputController::Instance().SetMouseDisabled(ImGui::GetIO().WantCaptureMouse);
 
     DrawOverlay();
+    UpdateVisibility();
 
     mCommandPool->RecordCommandBuffers(
         *mSwapchain.get(),
         *mRenderPass.get(),
         [this](vk::CommandBuffer& commandBuffer)
         {
+            mRecordStatistics = RecordStatistics();
+
             // Skybox
             if (mDrawSkybox)
             {
                 commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, mSkyboxPipeline->Handle().get());
                 mSkybox->Draw(commandBuffer, *mSkyboxPipeline.get());
+                mRecordStatistics.pipelineBinds++;
+                mRecordStatistics.draws++;
             }
 
-            // Push constants
-            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, mMeshPipeline->Handle().get());
+            // Geometry, with occlusion culling only what was visible last frame
+            RecordScene(commandBuffer, ShadingQuery, DepthPrepassQuery);
 
-            static Core::PushConstants constants;
-            constants.ambientColor = glm::make_vec4(Defaults::AmbientColor.data());
-            constants.lightPosition = glm::vec4(400.0, 50.0, 400.0, 1.0);
-            constants.lightColor = glm::vec4(1.0, 1.0, 1.0, 0.0);
-            commandBuffer.pushConstants(
-                mMeshPipeline->Layout(),
-                vk::ShaderStageFlagBits::eFragment,
-                0,
-                sizeof(Core::PushConstants),
-                &constants);
-
-            // Geometry
-            for (const auto& [id, mesh] : mMeshes)
+            // ImGui, drawn by the late pass with occlusion culling
+            if (mDepthPyramid == nullptr)
             {
-                mesh.Draw(commandBuffer, *mMeshPipeline.get());
+                ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
+            }
+        },
+        [this](vk::CommandBuffer& commandBuffer)
+        {
+            if (mQueryPool)
+            {
+                mQueryPool->Reset(commandBuffer);
+            }
+        },
+        [this](vk::CommandBuffer& commandBuffer)
+        {
+            if (mDepthPyramid)
+            {
+                mDepthPyramid->Record(commandBuffer);
             }
-
-            // ImGui
-            ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
         });
 
     // Render frame
@@ -271,22 +295,42 @@ VulkanRender::DrawFrame()
 
     UpdateUniformBuffers();
 
-    vk::Semaphore waitSemaphores[] = { mImagePresentedSemaphores[mCurrentFrame].get() };
-    vk::PipelineStageFlags waitStages[] = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
-
+    vk::Semaphore imagePresented = mImagePresentedSemaphores[mCurrentFrame].get();
     vk::Semaphore signalSemaphores[] = { mRenderFinishedSemaphores[mCurrentFrame].get() };
 
-    auto submitInfo = vk::SubmitInfo()
-                          .setWaitSemaphoreCount(static_cast<std::uint32_t>(std::size(waitSemaphores)))
-                          .setPWaitSemaphores(waitSemaphores)
-                          .setPWaitDstStageMask(waitStages)
-                          .setCommandBufferCount(1)
-                          .setPCommandBuffers(&mCommandPool->Get(imageIndex).get())
-                          .setSignalSemaphoreCount(static_cast<std::uint32_t>(std::size(signalSemaphores)))
-                          .setPSignalSemaphores(signalSemaphores);
+    if (mDepthPyramid)
+    {
+        // The early phase has to finish before its depth pyramid tells which held back instances are visible
+        Submit(mCommandPool->Get(imageIndex).get(), imagePresented, {});
 
-    mDevice->Handle()->resetFences(mInFlightFences[mCurrentFrame].get());
-    mDevice->GetGraphicsQueue().submit(submitInfo, mInFlightFences[mCurrentFrame].get());
+        auto earlyResult = mDevice->Handle()->waitForFences(
+            mInFlightFences[mCurrentFrame].get(), true, std::numeric_limits<std::uint64_t>::max());
+        (void)earlyResult;
+
+        CullOccluded();
+
+        // Recording restarts from the early statistics for every swapchain image
+        RecordStatistics earlyStatistics = mRecordStatistics;
+
+        mLateCommandPool->RecordCommandBuffers(
+            *mSwapchain.get(),
+            *mLateRenderPass.get(),
+            [this, earlyStatistics](vk::CommandBuffer& commandBuffer)
+            {
+                mRecordStatistics = earlyStatistics;
+
+                RecordScene(commandBuffer, LateShadingQuery, LateDepthPrepassQuery);
+                ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
+            });
+
+        Submit(mLateCommandPool->Get(imageIndex).get(), {}, signalSemaphores[0]);
+    }
+    else
+    {
+        Submit(mCommandPool->Get(imageIndex).get(), imagePresented, signalSemaphores[0]);
+    }
+
+    mQueryRecorded = mQueryPool != nullptr;
 
     // Present frame
     vk::SwapchainKHR swapchains[] = { mSwapchain->Handle().get() };
@@ -315,9 +359,50 @@ VulkanRender::DrawFrame()
 void
 VulkanRender::AddNode(const Core::SceneNodePtr& node)
 {
+    static auto DefaultTexture = Lucid::Files::LoadTexture("Resources/Textures/Default.png");
+
+    if (!mMeshNodes.insert(node->GetId()).second)
+    {
+        return;
+    }
 
     const Core::MeshPtr& mesh = node->GetOptionalMesh().value();
-    mMeshes.emplace(node->GetId(), VulkanMesh { *mDevice.get(), *mDescriptorPool.get(), *mCommandPool.get(), mesh });
+    auto geometry = mResourceCache->GetGeometry(mesh);
+    auto texture = mResourceCache->GetTexture(mesh->texture == nullptr ? DefaultTexture : mesh->texture);
+
+    // Mirroring transforms flip the winding on screen, the front faces of their instances turn clockwise
+    bool mirrored = glm::determinant(glm::mat3(node->GetTransform())) < 0.0f;
+    vk::CullModeFlagBits cullMode = mirrored ? vk::CullModeFlagBits::eFront : vk::CullModeFlagBits::eBack;
+    cullMode = geometry->doubleSided ? vk::CullModeFlagBits::eNone : cullMode;
+    auto pipeline = static_cast<std::uint32_t>(std::ranges::find(CullModes, cullMode) - CullModes.begin());
+
+    MeshKey key { geometry.get(), texture.get(), pipeline };
+    auto found = mMeshes.try_emplace(key, *mDevice.get(), geometry, texture).first;
+    found->second.AddInstance(node->GetId());
+
+    mGeometryIds.try_emplace(geometry.get(), static_cast<std::uint32_t>(mGeometryIds.size()));
+
+    if (mMaterials.contains(texture.get()))
+    {
+        return;
+    }
+
+    Material material;
+    material.id = static_cast<std::uint32_t>(mMaterials.size());
+    material.descriptorSet = std::make_unique<VulkanDescriptorSet>(*mDevice.get(), *mDescriptorPool.get());
+
+    auto bufferInfo = vk::DescriptorBufferInfo()
+                          .setBuffer(mCameraBuffer->Handle().get())
+                          .setOffset(0)
+                          .setRange(sizeof(Core::UniformBufferObject));
+
+    auto imageInfo = vk::DescriptorImageInfo()
+                         .setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+                         .setImageView(texture->image->GetImageView())
+                         .setSampler(texture->sampler->Handle().get());
+
+    material.descriptorSet->Update(bufferInfo, imageInfo);
+    mMaterials.emplace(texture.get(), std::move(material));
 }
 
 bool
@@ -343,10 +428,30 @@ VulkanRender::RecreateSwapchain()
 
     // Create render pass
     mRenderPass = std::make_unique<VulkanRenderPass>(*mDevice.get(), mSwapchain->GetImageFormat());
+    mLateRenderPass = std::make_unique<VulkanRenderPass>(*mDevice.get(), mSwapchain->GetImageFormat(), true);
 
     // Create pipelines
-    mMeshPipeline
-        = VulkanPipeline::Default(*mDevice.get(), mSwapchain->GetExtent(), *mRenderPass.get(), *mDescriptorPool.get());
+    // With a prepass the depth buffer is final before shading, the mesh pipeline only shades the matching depths
+    VulkanPipeline::DepthMode depthMode
+        = mDepthPrepass ? VulkanPipeline::DepthMode::Equal : VulkanPipeline::DepthMode::Less;
+
+    for (std::size_t i = 0; i < CullModes.size(); i++)
+    {
+        mMeshPipelines.at(i) = VulkanPipeline::Default(
+            *mDevice.get(),
+            mSwapchain->GetExtent(),
+            *mRenderPass.get(),
+            *mDescriptorPool.get(),
+            depthMode,
+            CullModes.at(i));
+
+        mDepthPrepassPipelines.at(i).reset();
+        if (mDepthPrepass)
+        {
+            mDepthPrepassPipelines.at(i) = VulkanPipeline::DepthPrepass(
+                *mDevice.get(), mSwapchain->GetExtent(), *mRenderPass.get(), *mDescriptorPool.get(), CullModes.at(i));
+        }
+    }
 
     if (mDrawSkybox)
     {
@@ -354,10 +459,23 @@ VulkanRender::RecreateSwapchain()
             *mDevice.get(), mSwapchain->GetExtent(), *mRenderPass.get(), *mDescriptorPool.get());
     }
 
-    // Create depth image
+    // Create depth image, the pyramid refers to it
+    mDepthPyramid.reset();
     mDepthImage = VulkanImage::CreateDepthImage(
         *mDevice.get(), mSwapchain->GetExtent(), mDevice->FindSupportedDepthFormat(), vk::ImageAspectFlagBits::eDepth);
 
+    if (mOcclusionCulling && !mDevice->SupportsDepthSampling())
+    {
+        LoggerWarning << "Device can't sample depth, occlusion culling disabled";
+        mOcclusionCulling = false;
+    }
+
+    if (mOcclusionCulling)
+    {
+        mDepthPyramid
+            = std::make_unique<VulkanDepthPyramid>(*mDevice.get(), *mDepthImage.get(), mSwapchain->GetExtent());
+    }
+
     // Create MSAA RenderTarget
     mResolveImage = VulkanImage::CreateImage(*mDevice.get(), mSwapchain->GetImageFormat(), mSwapchain->GetExtent());
 
@@ -369,31 +487,302 @@ VulkanRender::RecreateSwapchain()
 
 void
 VulkanRender::UpdateUniformBuffers()
+{
+    Core::UniformBufferObject ubo = GetCameraUniforms();
+    mCameraBuffer->Write(&ubo);
+
+    if (mDrawSkybox)
+    {
+        mSkybox->UpdateTransform(ubo);
+    }
+}
+
+void
+VulkanRender::UpdateVisibility()
+{
+    Core::UniformBufferObject ubo = GetCameraUniforms();
+    float viewportHeight = static_cast<float>(mSwapchain->GetExtent().height);
+
+    mInstanceCount = 0;
+    mVisibleInstanceCount = 0;
+    mMeshletCount = 0;
+    mVisibleMeshletCount = 0;
+
+    // The scene hierarchy rejects whole subtrees at once, only nodes inside the frustum are looked up
+    mScene.GetBvh().QueryFrustum(Core::Frustum(ubo.projection * ubo.view), mFrustumItems);
+    mFrustumNodes.assign(mFrustumNodes.size(), false);
+
+    for (std::uint32_t item : mFrustumItems)
+    {
+        std::size_t id = mScene.GetBoundedNode(item)->GetId();
+        if (id >= mFrustumNodes.size())
+        {
+            mFrustumNodes.resize(id + 1, false);
+        }
+
+        mFrustumNodes[id] = true;
+    }
+
+    std::vector<glm::mat4> transforms;
+    std::vector<bool> inFrustum;
+
+    for (auto& [key, mesh] : mMeshes)
+    {
+        transforms.clear();
+        inFrustum.clear();
+
+        for (std::size_t id : mesh.GetInstances())
+        {
+            bool inside = id < mFrustumNodes.size() && mFrustumNodes[id];
+            inFrustum.push_back(inside);
+            transforms.push_back(inside ? mScene.GetNodeById(id)->GetTransform() : glm::mat4(1.0f));
+        }
+
+        mesh.UpdateInstances(transforms, inFrustum, ubo, viewportHeight, mDepthPyramid != nullptr);
+
+        mInstanceCount += transforms.size();
+        mVisibleInstanceCount += mesh.GetVisibleInstanceCount();
+        mMeshletCount += mesh.GetMeshletCount();
+        mVisibleMeshletCount += mesh.GetVisibleMeshletCount();
+    }
+
+    QueueMeshes();
+}
+
+void
+VulkanRender::CullOccluded()
+{
+    const Core::DepthPyramid& pyramid = mDepthPyramid->Read();
+    Core::UniformBufferObject ubo = GetCameraUniforms();
+
+    mOccludedInstanceCount = 0;
+
+    for (auto& [key, mesh] : mMeshes)
+    {
+        mesh.CullOccluded(pyramid, ubo);
+
+        mVisibleInstanceCount += mesh.GetVisibleInstanceCount();
+        mOccludedInstanceCount += mesh.GetOccludedInstanceCount();
+        mVisibleMeshletCount += mesh.GetVisibleMeshletCount();
+    }
+
+    QueueMeshes();
+}
+
+void
+VulkanRender::QueueMeshes()
+{
+    mRenderQueue.Clear();
+    mQueuedMeshes.clear();
+
+    for (const auto& [key, mesh] : mMeshes)
+    {
+        if (mesh.GetVisibleInstanceCount() == 0)
+        {
+            continue;
+        }
+
+        const Material& material = mMaterials.at(key.texture);
+        std::uint32_t geometryId = mGeometryIds.at(key.geometry);
+
+        QueuedMesh queued;
+        queued.mesh = &mesh;
+        queued.descriptorSet = material.descriptorSet.get();
+        queued.geometry = key.geometry;
+        queued.pipeline = key.pipeline;
+
+        auto index = static_cast<std::uint32_t>(mQueuedMeshes.size());
+        std::uint64_t sortKey
+            = Core::RenderQueue::MakeKey(key.pipeline, material.id, mesh.GetNearestDepth(), geometryId);
+        mRenderQueue.Push(sortKey, index);
+        mQueuedMeshes.push_back(queued);
+    }
+
+    mRenderQueue.Sort();
+}
+
+void
+VulkanRender::RecordScene(vk::CommandBuffer& commandBuffer, std::uint32_t shadingQuery, std::uint32_t prepassQuery)
+{
+    // Depth prepass
+    if (mDepthPrepass)
+    {
+        if (mQueryPool)
+        {
+            mQueryPool->Begin(commandBuffer, prepassQuery);
+        }
+
+        RecordMeshes(commandBuffer, mDepthPrepassPipelines, true);
+
+        if (mQueryPool)
+        {
+            mQueryPool->End(commandBuffer, prepassQuery);
+        }
+    }
+
+    // Geometry
+    if (mQueryPool)
+    {
+        mQueryPool->Begin(commandBuffer, shadingQuery);
+    }
+
+    RecordMeshes(commandBuffer, mMeshPipelines, false);
+
+    if (mQueryPool)
+    {
+        mQueryPool->End(commandBuffer, shadingQuery);
+    }
+}
+
+void
+VulkanRender::RecordMeshes(vk::CommandBuffer& commandBuffer, const Pipelines& pipelines, bool depthOnly)
+{
+    const VulkanPipeline* boundPipeline = nullptr;
+    const VulkanDescriptorSet* boundDescriptorSet = nullptr;
+    const VulkanResourceCache::Geometry* boundGeometry = nullptr;
+
+    for (const Core::RenderQueue::Item& item : mRenderQueue.GetItems())
+    {
+        const QueuedMesh& queued = mQueuedMeshes.at(item.index);
+        const VulkanPipeline& pipeline = *pipelines.at(queued.pipeline);
+
+        // The queue is sorted by pipeline first, so every cull mode is bound once
+        if (&pipeline != boundPipeline)
+        {
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.Handle().get());
+            boundPipeline = &pipeline;
+            boundDescriptorSet = nullptr;
+            mRecordStatistics.pipelineBinds++;
+
+            if (!depthOnly)
+            {
+                static Core::PushConstants constants;
+                constants.ambientColor = glm::make_vec4(Defaults::AmbientColor.data());
+                constants.lightPosition = glm::vec4(400.0, 50.0, 400.0, 1.0);
+                constants.lightColor = glm::vec4(1.0, 1.0, 1.0, 0.0);
+                commandBuffer.pushConstants(
+                    pipeline.Layout(),
+                    vk::ShaderStageFlagBits::eFragment,
+                    0,
+                    sizeof(Core::PushConstants),
+                    &constants);
+            }
+        }
+
+        // Every set holds the camera uniforms, the depth pass reads nothing else
+        bool rebind = depthOnly ? boundDescriptorSet == nullptr : queued.descriptorSet != boundDescriptorSet;
+
+        if (rebind)
+        {
+            commandBuffer.bindDescriptorSets(
+                vk::PipelineBindPoint::eGraphics,
+                pipeline.Layout(),
+                0,
+                1,
+                &queued.descriptorSet->Handle().get(),
+                0,
+                {});
+
+            boundDescriptorSet = queued.descriptorSet;
+            mRecordStatistics.descriptorBinds++;
+        }
+
+        if (queued.geometry != boundGeometry)
+        {
+            queued.mesh->BindGeometry(commandBuffer, depthOnly);
+            boundGeometry = queued.geometry;
+            mRecordStatistics.geometryBinds++;
+        }
+
+        queued.mesh->Draw(commandBuffer);
+        mRecordStatistics.draws += queued.mesh->GetDrawCount();
+    }
+}
+
+Core::UniformBufferObject
+VulkanRender::GetCameraUniforms() const
 {
     vk::Extent2D extent = mSwapchain->GetExtent();
     float aspectRatio = static_cast<float>(extent.width) / static_cast<float>(extent.height);
 
     Core::UniformBufferObject ubo;
+    ubo.model = glm::mat4(1.0f);
     ubo.view = mScene.GetCamera()->Transform();
     ubo.projection = glm::perspective(glm::radians(mScene.GetCamera()->FieldOfView()), aspectRatio, 1.f, 100'000.0f);
     ubo.projection[1][1] *= -1;
 
-    for (const auto& [id, mesh] : mMeshes)
+    return ubo;
+}
+
+void
+VulkanRender::RecordCommandBuffers()
+{
+    mCommandPool->RecreateCommandBuffers(*mSwapchain.get());
+    mLateCommandPool->RecreateCommandBuffers(*mSwapchain.get());
+}
+
+void
+VulkanRender::Submit(const vk::CommandBuffer& commandBuffer, vk::Semaphore waitSemaphore, vk::Semaphore signalSemaphore)
+{
+    vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+
+    auto submitInfo = vk::SubmitInfo().setCommandBufferCount(1).setPCommandBuffers(&commandBuffer);
+
+    if (waitSemaphore)
     {
-        ubo.model = mScene.GetNodeById(id)->GetTransform();
-        mMeshes.at(id).UpdateTransform(ubo);
+        submitInfo.setWaitSemaphoreCount(1).setPWaitSemaphores(&waitSemaphore).setPWaitDstStageMask(&waitStage);
     }
 
-    if (mDrawSkybox)
+    if (signalSemaphore)
     {
-        mSkybox->UpdateTransform(ubo);
+        submitInfo.setSignalSemaphoreCount(1).setPSignalSemaphores(&signalSemaphore);
     }
+
+    mDevice->Handle()->resetFences(mInFlightFences[mCurrentFrame].get());
+    mDevice->GetGraphicsQueue().submit(submitInfo, mInFlightFences[mCurrentFrame].get());
 }
 
 void
-VulkanRender::RecordCommandBuffers()
+VulkanRender::ReadPipelineStatistics()
 {
-    mCommandPool->RecreateCommandBuffers(*mSwapchain.get());
+    // The query of the previous frame, the device is idle at this point
+    if (!mQueryRecorded)
+    {
+        return;
+    }
+
+    // Both phases of occlusion culling count, queries that were not recorded stay empty
+    auto read = [this](std::uint32_t early, std::uint32_t late)
+    {
+        std::optional<VulkanQueryPool::PipelineStatistics> statistics = mQueryPool->GetPipelineStatistics(early);
+        std::optional<VulkanQueryPool::PipelineStatistics> lateStatistics = mQueryPool->GetPipelineStatistics(late);
+
+        if (statistics.has_value() && lateStatistics.has_value())
+        {
+            statistics->inputVertices += lateStatistics->inputVertices;
+            statistics->vertexShaderInvocations += lateStatistics->vertexShaderInvocations;
+            statistics->clippingPrimitives += lateStatistics->clippingPrimitives;
+            statistics->fragmentShaderInvocations += lateStatistics->fragmentShaderInvocations;
+        }
+
+        return statistics;
+    };
+
+    mDepthPrepassStatistics = read(DepthPrepassQuery, LateDepthPrepassQuery);
+
+    std::optional<VulkanQueryPool::PipelineStatistics> statistics = read(ShadingQuery, LateShadingQuery);
+    if (!statistics.has_value())
+    {
+        return;
+    }
+
+    if (!mPipelineStatistics.has_value())
+    {
+        LoggerInfo << "Scene geometry: " << statistics->vertexShaderInvocations << " vertex shader invocations, "
+                   << statistics->fragmentShaderInvocations << " fragment shader invocations";
+    }
+
+    mPipelineStatistics = statistics;
 }
 
 void
@@ -424,10 +813,19 @@ VulkanRender::DrawOverlay()
         {
             ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(2.0f, 2.0f));
             ImGui::Checkbox("Properties", &drawTransform);
+            ImGui::Checkbox("Statistics", &mDrawStatistics);
             if (ImGui::Checkbox("Skybox", &mDrawSkybox))
             {
                 RecreateSwapchain();
             }
+            if (ImGui::Checkbox("Depth Prepass", &mDepthPrepass))
+            {
+                RecreateSwapchain();
+            }
+            if (ImGui::Checkbox("Occlusion Culling", &mOcclusionCulling))
+            {
+                RecreateSwapchain();
+            }
             ImGui::PopStyleVar();
             ImGui::EndMenu();
         }
@@ -457,6 +855,56 @@ VulkanRender::DrawOverlay()
         ImGui::End();
     }
 
+    if (mDrawStatistics)
+    {
+        const RecordStatistics& recorded = mRecordStatistics;
+        std::size_t stateChanges = recorded.pipelineBinds + recorded.descriptorBinds + recorded.geometryBinds;
+
+        ImGui::SetNextWindowSize({ 300.0f, 200.0f }, ImGuiCond_FirstUseEver);
+        ImGui::Begin("Statistics", &mDrawStatistics, ImGuiWindowFlags_NoFocusOnAppearing);
+        ImGui::Text("Draws: %zu", recorded.draws);
+        ImGui::Text(
+            "State changes: %zu (%zu pipelines, %zu descriptors, %zu buffers)",
+            stateChanges,
+            recorded.pipelineBinds,
+            recorded.descriptorBinds,
+            recorded.geometryBinds);
+        ImGui::Text("Instances: %zu / %zu in %zu meshes", mVisibleInstanceCount, mInstanceCount, mMeshes.size());
+
+        if (mDepthPyramid)
+        {
+            ImGui::Text("Occluded instances: %zu", mOccludedInstanceCount);
+        }
+
+        ImGui::Text("Meshlets: %zu / %zu", mVisibleMeshletCount, mMeshletCount);
+
+        if (mPipelineStatistics.has_value())
+        {
+            const VulkanQueryPool::PipelineStatistics& statistics = mPipelineStatistics.value();
+
+            // Input assembly vertices are three per triangle for indexed lists
+            double triangles = static_cast<double>(statistics.inputVertices) / 3.0;
+            double invocations = static_cast<double>(statistics.vertexShaderInvocations);
+            double perTriangle = triangles > 0.0 ? invocations / triangles : 0.0;
+
+            ImGui::Text("VS invocations: %llu", static_cast<unsigned long long>(statistics.vertexShaderInvocations));
+            ImGui::Text("VS per triangle: %.3f", perTriangle);
+            ImGui::Text("Clipping primitives: %llu", static_cast<unsigned long long>(statistics.clippingPrimitives));
+            ImGui::Text("FS invocations: %llu", static_cast<unsigned long long>(statistics.fragmentShaderInvocations));
+        }
+
+        if (mDepthPrepass && mDepthPrepassStatistics.has_value())
+        {
+            const VulkanQueryPool::PipelineStatistics& statistics = mDepthPrepassStatistics.value();
+
+            ImGui::Text(
+                "Prepass FS invocations: %llu",
+                static_cast<unsigned long long>(statistics.fragmentShaderInvocations));
+        }
+
+        ImGui::End();
+    }
+
     ImGui::Render();
     auto drawData = ImGui::GetDrawData();
     drawData->FramebufferScale = { 1.0, 1.0 };
@@ -1,15 +1,24 @@
 #pragma once
 
+#include <array>
+#include <map>
+#include <set>
+
 #include <Core/Interfaces.h>
+#include <Core/RenderQueue.h>
 #include <Core/Scene.h>
 #include <Utils/Defaults.hpp>
 #include <Vulkan/VulkanBuffer.h>
 #include <Vulkan/VulkanCommandPool.h>
+#include <Vulkan/VulkanDepthPyramid.h>
 #include <Vulkan/VulkanDescriptorPool.h>
+#include <Vulkan/VulkanDescriptorSet.h>
 #include <Vulkan/VulkanImage.h>
 #include <Vulkan/VulkanInstance.h>
 #include <Vulkan/VulkanMesh.h>
+#include <Vulkan/VulkanResourceCache.h>
 #include <Vulkan/VulkanPipeline.h>
+#include <Vulkan/VulkanQueryPool.h>
 #include <Vulkan/VulkanRenderPass.h>
 #include <Vulkan/VulkanSampler.h>
 #include <Vulkan/VulkanSkybox.h>
@@ -32,10 +41,35 @@ public:
 private:
     void RecreateSwapchain();
     void UpdateUniformBuffers();
+    void UpdateVisibility();
+
+    // Late phase of occlusion culling, after the early phase finished on the device
+    void CullOccluded();
+    void QueueMeshes();
+
+    // Queued meshes with the prepass when enabled, each pass inside its query
+    void RecordScene(vk::CommandBuffer& commandBuffer, std::uint32_t shadingQuery, std::uint32_t prepassQuery);
+
+    // Single sided meshes cull back faces, mirrored instances flip their winding, double sided meshes cull nothing
+    static constexpr std::array<vk::CullModeFlagBits, 3> CullModes = {
+        vk::CullModeFlagBits::eBack,
+        vk::CullModeFlagBits::eFront,
+        vk::CullModeFlagBits::eNone,
+    };
+
+    using Pipelines = std::array<std::unique_ptr<VulkanPipeline>, CullModes.size()>;
+
+    // Depth only binds positions and a single descriptor set for the camera uniforms
+    void RecordMeshes(vk::CommandBuffer& commandBuffer, const Pipelines& pipelines, bool depthOnly);
+
+    // Signals the in flight fence of the current frame, null semaphores are left out
+    void Submit(const vk::CommandBuffer& commandBuffer, vk::Semaphore waitSemaphore, vk::Semaphore signalSemaphore);
+    [[nodiscard]] Core::UniformBufferObject GetCameraUniforms() const;
     void RecordCommandBuffers();
     void SetupImgui();
     void DrawDockspace();
     void DrawOverlay();
+    void ReadPipelineStatistics();
 
     // Vulkan entities
     std::unique_ptr<VulkanInstance> mInstance;
@@ -43,14 +77,91 @@ private:
     std::unique_ptr<VulkanSurface> mSurface;
     std::unique_ptr<VulkanSwapchain> mSwapchain;
     std::unique_ptr<VulkanRenderPass> mRenderPass;
-    std::unique_ptr<VulkanPipeline> mMeshPipeline;
+    std::unique_ptr<VulkanRenderPass> mLateRenderPass; // Continues mRenderPass after occlusion culling
+    Pipelines mMeshPipelines; // Per cull mode
     std::unique_ptr<VulkanPipeline> mSkyboxPipeline;
+    Pipelines mDepthPrepassPipelines; // Null unless mDepthPrepass
     std::unique_ptr<VulkanCommandPool> mCommandPool;
+    std::unique_ptr<VulkanCommandPool> mLateCommandPool;
     std::unique_ptr<VulkanDescriptorPool> mDescriptorPool;
     std::unique_ptr<VulkanImage> mResolveImage;
     std::unique_ptr<VulkanImage> mDepthImage;
+    std::unique_ptr<VulkanDepthPyramid> mDepthPyramid; // Null unless mOcclusionCulling
     std::unique_ptr<VulkanSkybox> mSkybox;
-    std::map<std::size_t, VulkanMesh> mMeshes;
+    std::unique_ptr<VulkanResourceCache> mResourceCache;
+
+    // Nodes drawing the same geometry with the same texture and cull mode share one instanced mesh
+    struct MeshKey
+    {
+        const VulkanResourceCache::Geometry* geometry = nullptr;
+        const VulkanResourceCache::Texture* texture = nullptr;
+        std::uint32_t pipeline = 0; // Into CullModes
+
+        auto operator<=>(const MeshKey&) const = default;
+    };
+
+    std::map<MeshKey, VulkanMesh> mMeshes;
+    std::set<std::size_t> mMeshNodes;
+
+    // Result of the frustum query over the scene hierarchy, and the same nodes by id
+    std::vector<std::uint32_t> mFrustumItems;
+    std::vector<bool> mFrustumNodes;
+
+    // Camera uniforms and a texture, shared by every mesh drawing that texture
+    struct Material
+    {
+        std::uint32_t id = 0;
+        std::unique_ptr<VulkanDescriptorSet> descriptorSet;
+    };
+
+    std::unique_ptr<VulkanUniformBuffer> mCameraBuffer;
+    std::map<const VulkanResourceCache::Texture*, Material> mMaterials;
+    std::map<const VulkanResourceCache::Geometry*, std::uint32_t> mGeometryIds;
+
+    // Visible meshes of the frame, sorted by pipeline, material and depth
+    struct QueuedMesh
+    {
+        const VulkanMesh* mesh = nullptr;
+        const VulkanDescriptorSet* descriptorSet = nullptr;
+        const VulkanResourceCache::Geometry* geometry = nullptr;
+        std::uint32_t pipeline = 0;
+    };
+
+    Core::RenderQueue mRenderQueue;
+    std::vector<QueuedMesh> mQueuedMeshes;
+
+    // Commands recorded for the last frame
+    struct RecordStatistics
+    {
+        std::size_t draws = 0;
+        std::size_t pipelineBinds = 0;
+        std::size_t descriptorBinds = 0;
+        std::size_t geometryBinds = 0;
+    };
+
+    RecordStatistics mRecordStatistics;
+
+    // Pipeline statistics per pass, the late ones only run with occlusion culling
+    enum Query : std::uint32_t
+    {
+        ShadingQuery,
+        DepthPrepassQuery,
+        LateShadingQuery,
+        LateDepthPrepassQuery,
+        QueryCount,
+    };
+
+    // Null when the device has no pipeline statistics queries
+    std::unique_ptr<VulkanQueryPool> mQueryPool;
+    std::optional<VulkanQueryPool::PipelineStatistics> mPipelineStatistics;
+    std::optional<VulkanQueryPool::PipelineStatistics> mDepthPrepassStatistics;
+    bool mQueryRecorded = false;
+
+    std::size_t mInstanceCount = 0;
+    std::size_t mVisibleInstanceCount = 0;
+    std::size_t mOccludedInstanceCount = 0;
+    std::size_t mMeshletCount = 0;
+    std::size_t mVisibleMeshletCount = 0;
 
     // Synchronization
     std::vector<vk::UniqueSemaphore> mImagePresentedSemaphores;
@@ -65,6 +176,9 @@ private:
 
     // Settings
     bool mDrawSkybox = Defaults::DrawSkybox;
+    bool mDepthPrepass = Defaults::DepthPrepass;
+    bool mOcclusionCulling = Defaults::OcclusionCulling;
+    bool mDrawStatistics = false;
 };
 
 } // namespace Lucid::Vulkan
@@ -7,7 +7,7 @@
 namespace Lucid::Vulkan
 {
 
-VulkanRenderPass::VulkanRenderPass(VulkanDevice& device, vk::Format imageFormat)
+VulkanRenderPass::VulkanRenderPass(VulkanDevice& device, vk::Format imageFormat, bool loadAttachments)
 {
     // Create subpass
     auto colorAttachmentReference
@@ -40,24 +40,46 @@ VulkanRenderPass::VulkanRenderPass(VulkanDevice& device, vk::Format imageFormat)
               .setDstAccessMask(
                   vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite);
 
+    // Loaded attachments were written by the previous pass, its writes have to land before they are read
+    if (loadAttachments)
+    {
+        subpassDependency
+            .setSrcStageMask(
+                vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests
+                | vk::PipelineStageFlagBits::eLateFragmentTests)
+            .setSrcAccessMask(
+                vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+            .setDstAccessMask(
+                vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite
+                | vk::AccessFlagBits::eDepthStencilAttachmentRead
+                | vk::AccessFlagBits::eDepthStencilAttachmentWrite);
+    }
+
+    vk::AttachmentLoadOp loadOp = loadAttachments ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
+
     auto colorAttachment = vk::AttachmentDescription()
                                .setFormat(imageFormat)
                                .setSamples(device.GetMsaaSamples())
-                               .setLoadOp(vk::AttachmentLoadOp::eClear)
+                               .setLoadOp(loadOp)
                                .setStoreOp(vk::AttachmentStoreOp::eStore)
                                .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
                                .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
-                               .setInitialLayout(vk::ImageLayout::eUndefined)
+                               .setInitialLayout(
+                                   loadAttachments ? vk::ImageLayout::eColorAttachmentOptimal
+                                                   : vk::ImageLayout::eUndefined)
                                .setFinalLayout(vk::ImageLayout::eColorAttachmentOptimal);
 
+    // Depth is stored for the depth pyramid and for loading passes
     auto depthAttachment = vk::AttachmentDescription()
                                .setFormat(device.FindSupportedDepthFormat())
                                .setSamples(device.GetMsaaSamples())
-                               .setLoadOp(vk::AttachmentLoadOp::eClear)
-                               .setStoreOp(vk::AttachmentStoreOp::eDontCare)
+                               .setLoadOp(loadOp)
+                               .setStoreOp(vk::AttachmentStoreOp::eStore)
                                .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
                                .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
-                               .setInitialLayout(vk::ImageLayout::eUndefined)
+                               .setInitialLayout(
+                                   loadAttachments ? vk::ImageLayout::eDepthStencilAttachmentOptimal
+                                                   : vk::ImageLayout::eUndefined)
                                .setFinalLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal);
 
     auto resolveAttachment = vk::AttachmentDescription()
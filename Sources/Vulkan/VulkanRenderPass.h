@@ -10,10 +10,15 @@ class VulkanPipeline;
 class VulkanSwapchain;
 class VulkanDevice;
 
+/*
+        Color, depth and resolve attachments in a single subpass.
+        Loading variants continue an earlier pass of the frame, they are compatible with the clearing one,
+        so pipelines and framebuffers are shared.
+*/
 class VulkanRenderPass : public VulkanEntity<vk::UniqueRenderPass>
 {
 public:
-    VulkanRenderPass(VulkanDevice& device, vk::Format imageFormat);
+    VulkanRenderPass(VulkanDevice& device, vk::Format imageFormat, bool loadAttachments = false);
 };
 
 } // namespace Lucid::Vulkan
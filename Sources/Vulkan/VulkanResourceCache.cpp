@@ -0,0 +1,89 @@
+#include "VulkanResourceCache.h"
+
+#include <Vulkan/VulkanCommandPool.h>
+#include <Vulkan/VulkanDevice.h>
+
+namespace Lucid::Vulkan
+{
+
+VulkanResourceCache::VulkanResourceCache(VulkanDevice& device, VulkanCommandPool& commandPool)
+    : mDevice(device)
+    , mCommandPool(commandPool)
+{
+}
+
+std::shared_ptr<const VulkanResourceCache::Geometry>
+VulkanResourceCache::GetGeometry(const Core::MeshPtr& mesh)
+{
+    if (auto found = mGeometries.find(mesh); found != mGeometries.end())
+    {
+        return found->second;
+    }
+
+    std::vector<Lod> lods = { { 0, static_cast<std::uint32_t>(mesh->indices.size()), 0.0f } };
+    std::vector<std::uint32_t> levels;
+
+    if (!mesh->lods.empty())
+    {
+        levels = mesh->indices;
+        for (const Core::MeshLod& lod : mesh->lods)
+        {
+            lods.push_back({ static_cast<std::uint32_t>(levels.size()),
+                             static_cast<std::uint32_t>(lod.indices.size()),
+                             lod.error });
+            levels.insert(levels.end(), lod.indices.begin(), lod.indices.end());
+        }
+    }
+
+    auto geometry = std::make_shared<const Geometry>(Geometry {
+        VulkanVertexBuffer(mDevice, mCommandPool, mesh->vertices),
+        VulkanVertexBuffer(mDevice, mCommandPool, mesh->vertices, Core::VertexFormat::Position),
+        VulkanIndexBuffer(mDevice, mCommandPool, mesh->lods.empty() ? mesh->indices : levels),
+        std::move(lods),
+        mesh->meshlets,
+        GetBoundingSphere(mesh->vertices),
+        mesh->doubleSided,
+    });
+
+    mGeometries.emplace(mesh, geometry);
+    return geometry;
+}
+
+glm::vec4
+VulkanResourceCache::GetBoundingSphere(const std::vector<Core::Vertex>& vertices)
+{
+    if (vertices.empty())
+    {
+        return glm::vec4(0.0f);
+    }
+
+    // Box center and half diagonal, the same radius the simplifier measures its error against
+    glm::vec3 min = vertices.front().position;
+    glm::vec3 max = min;
+    for (const Core::Vertex& vertex : vertices)
+    {
+        min = glm::min(min, vertex.position);
+        max = glm::max(max, vertex.position);
+    }
+
+    glm::vec3 center = (min + max) * 0.5f;
+    return glm::vec4(center, glm::length(max - center));
+}
+
+std::shared_ptr<const VulkanResourceCache::Texture>
+VulkanResourceCache::GetTexture(const Core::TexturePtr& texture)
+{
+    if (auto found = mTextures.find(texture); found != mTextures.end())
+    {
+        return found->second;
+    }
+
+    auto image = VulkanImage::FromTexture(mDevice, mCommandPool, texture, vk::ImageAspectFlagBits::eColor);
+    auto sampler = std::make_unique<VulkanSampler>(mDevice, image->GetMipLevels());
+    auto result = std::make_shared<const Texture>(Texture { std::move(image), std::move(sampler) });
+
+    mTextures.emplace(texture, result);
+    return result;
+}
+
+} // namespace Lucid::Vulkan
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <Core/Types.h>
+#include <Vulkan/VulkanBuffer.h>
+#include <Vulkan/VulkanImage.h>
+#include <Vulkan/VulkanSampler.h>
+
+namespace Lucid::Vulkan
+{
+
+class VulkanDevice;
+class VulkanCommandPool;
+
+/*
+        Uploads every Core::Mesh and Core::Texture once.
+        Nodes referencing the same MeshPtr or TexturePtr share the buffers and images created for it.
+*/
+class VulkanResourceCache
+{
+public:
+    struct Lod
+    {
+        std::uint32_t firstIndex;
+        std::uint32_t indexCount;
+        float error; // Relative to the bounding sphere radius
+    };
+
+    struct Geometry
+    {
+        VulkanVertexBuffer vertexBuffer;
+        VulkanVertexBuffer positionBuffer; // Positions of vertexBuffer alone, for the depth prepass
+        VulkanIndexBuffer indexBuffer; // Every level back to back, the full mesh first
+        std::vector<Lod> lods;
+        std::vector<Core::Meshlet> meshlets; // Ranges of level 0
+        glm::vec4 boundingSphere; // Center and radius in mesh space
+        bool doubleSided = false; // Of the material, back faces are drawn and meshlets never rejected as back facing
+    };
+
+    struct Texture
+    {
+        std::unique_ptr<VulkanImage> image;
+        std::unique_ptr<VulkanSampler> sampler;
+    };
+
+    VulkanResourceCache(VulkanDevice& device, VulkanCommandPool& commandPool);
+
+    std::shared_ptr<const Geometry> GetGeometry(const Core::MeshPtr& mesh);
+    std::shared_ptr<const Texture> GetTexture(const Core::TexturePtr& texture);
+
+private:
+    static glm::vec4 GetBoundingSphere(const std::vector<Core::Vertex>& vertices);
+
+    VulkanDevice& mDevice;
+    VulkanCommandPool& mCommandPool;
+
+    // Keyed by the owning pointers, so a cached address can't be reused by another mesh or texture
+    std::map<Core::MeshPtr, std::shared_ptr<const Geometry>> mGeometries;
+    std::map<Core::TexturePtr, std::shared_ptr<const Texture>> mTextures;
+};
+
+} // namespace Lucid::Vulkan
@@ -1,19 +1,37 @@
 #include "VulkanShader.h"
 
+#include <cstring>
+#include <fstream>
+
+#include <Utils/Defaults.hpp>
 #include <Utils/Files.h>
 #include <Utils/Logger.hpp>
+#include <Utils/Utils.h>
 #include <Vulkan/VulkanDevice.h>
 
 namespace Lucid::Vulkan
 {
 
-VulkanShader::VulkanShader(VulkanDevice& device, Type type, const std::filesystem::path& path)
+namespace
 {
-    LoggerInfo << "Compiling " << path.string();
 
-    std::vector<char> code = Files::LoadFile(path);
-    std::string preprocessed = PreprocessShader({ code.begin(), code.end() }, type, path.string());
-    std::vector<std::uint32_t> compiled = CompileShader(preprocessed, type, path.string());
+const shaderc_optimization_level OptimizationLevel = shaderc_optimization_level_size;
+const std::uint32_t SpirvMagic = 0x07230203;
+
+// Compiled shaders of this process by source hash
+std::map<std::uint64_t, std::vector<std::uint32_t>>&
+GetCompiledShaders()
+{
+    static std::map<std::uint64_t, std::vector<std::uint32_t>> shaders;
+    return shaders;
+}
+
+} // namespace
+
+VulkanShader::VulkanShader(VulkanDevice& device, Type type, const std::filesystem::path& path)
+{
+    MappedFilePtr code = Files::LoadFile(path);
+    const std::vector<std::uint32_t>& compiled = GetSpirv(code->View(), type, path);
 
     auto shaderModuleCreateInfo
         = vk::ShaderModuleCreateInfo().setCodeSize(compiled.size() * sizeof(std::uint32_t)).setPCode(compiled.data());
@@ -21,15 +39,132 @@ VulkanShader::VulkanShader(VulkanDevice& device, Type type, const std::filesyste
     mHandle = device.Handle()->createShaderModuleUnique(shaderModuleCreateInfo);
 }
 
+const std::vector<std::uint32_t>&
+VulkanShader::GetSpirv(std::string_view source, Type type, const std::filesystem::path& path)
+{
+    std::uint64_t hash = HashSource(source, type);
+
+    auto& compiledShaders = GetCompiledShaders();
+    if (auto it = compiledShaders.find(hash); it != compiledShaders.end())
+    {
+        return it->second;
+    }
+
+    std::filesystem::path cachePath = GetCachePath(path, hash);
+    if (std::optional<std::vector<std::uint32_t>> cached = LoadCached(cachePath); cached.has_value())
+    {
+        LoggerInfo << "Loaded " << path.string() << " from " << cachePath.string();
+        return compiledShaders[hash] = std::move(cached.value());
+    }
+
+    LoggerInfo << "Compiling " << path.string();
+
+    std::string preprocessed = PreprocessShader(source, type, path.string());
+    std::vector<std::uint32_t> compiled = CompileShader(preprocessed, type, path.string());
+
+    // A shader that can't be cached still works, it is compiled again by the next process
+    try
+    {
+        SaveCached(cachePath, compiled);
+    }
+    catch (const std::exception& ex)
+    {
+        LoggerWarning << "Can't cache " << path.string() << ": " << ex.what();
+    }
+
+    return compiledShaders[hash] = std::move(compiled);
+}
+
+std::uint64_t
+VulkanShader::HashSource(std::string_view source, Type type)
+{
+    unsigned int spirvVersion = 0;
+    unsigned int spirvRevision = 0;
+    shaderc_get_spv_version(&spirvVersion, &spirvRevision);
+
+    std::uint64_t hash = Hash(&CacheVersion, sizeof(CacheVersion));
+    hash = Hash(&spirvVersion, sizeof(spirvVersion), hash);
+    hash = Hash(&spirvRevision, sizeof(spirvRevision), hash);
+    hash = Hash(&OptimizationLevel, sizeof(OptimizationLevel), hash);
+    hash = Hash(&type, sizeof(type), hash);
+    return Hash(source.data(), source.size(), hash);
+}
+
+std::filesystem::path
+VulkanShader::GetCachePath(const std::filesystem::path& path, std::uint64_t hash)
+{
+    // Stages share a stem, Shader.vert and Shader.frag
+    std::string name = path.filename().string() + "-" + ToHex(hash) + ".spv";
+    return std::filesystem::path(Defaults::CacheDirectory) / "Shaders" / name;
+}
+
+std::optional<std::vector<std::uint32_t>>
+VulkanShader::LoadCached(const std::filesystem::path& path)
+{
+    if (!std::filesystem::exists(path))
+    {
+        return std::nullopt;
+    }
+
+    MappedFilePtr file = Files::LoadFile(path);
+    std::uint32_t magic = 0;
+
+    if (file->Size() < sizeof(magic) || file->Size() % sizeof(std::uint32_t) != 0)
+    {
+        LoggerWarning << "Ignoring cached shader " << path.string() << ", size isn't a whole number of words";
+        return std::nullopt;
+    }
+
+    std::memcpy(&magic, file->Data(), sizeof(magic));
+    if (magic != SpirvMagic)
+    {
+        LoggerWarning << "Ignoring cached shader " << path.string() << ", not SPIR-V";
+        return std::nullopt;
+    }
+
+    std::vector<std::uint32_t> spirv(file->Size() / sizeof(std::uint32_t));
+    std::memcpy(spirv.data(), file->Data(), file->Size());
+    return spirv;
+}
+
+void
+VulkanShader::SaveCached(const std::filesystem::path& path, const std::vector<std::uint32_t>& spirv)
+{
+    std::filesystem::create_directories(path.parent_path());
+
+    // Written next to the final name and renamed, other processes never see a partial file
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Can't create " + temporary.string());
+        }
+
+        file.write(
+            reinterpret_cast<const char*>(spirv.data()),
+            static_cast<std::streamsize>(spirv.size() * sizeof(std::uint32_t)));
+
+        if (!file)
+        {
+            throw std::runtime_error("Can't write " + temporary.string());
+        }
+    }
+
+    std::filesystem::rename(temporary, path);
+}
+
 std::string
-VulkanShader::PreprocessShader(const std::string& source, Type type, const std::string& name)
+VulkanShader::PreprocessShader(std::string_view source, Type type, const std::string& name)
 {
     shaderc::Compiler compiler;
     shaderc::CompileOptions options;
     shaderc_shader_kind kind = VulkanShader::TypeMap.at(type);
 
     shaderc::PreprocessedSourceCompilationResult result
-        = compiler.PreprocessGlsl(source.data(), kind, name.data(), options);
+        = compiler.PreprocessGlsl(source.data(), source.size(), kind, name.data(), options);
 
     if (shaderc_compilation_status::shaderc_compilation_status_success != result.GetCompilationStatus())
     {
@@ -44,7 +179,7 @@ VulkanShader::CompileShader(const std::string& source, Type type, const std::str
 {
     shaderc::Compiler compiler;
     shaderc::CompileOptions options;
-    options.SetOptimizationLevel(shaderc_optimization_level_size);
+    options.SetOptimizationLevel(OptimizationLevel);
     shaderc_shader_kind kind = VulkanShader::TypeMap.at(type);
 
     shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(source.data(), kind, name.data(), options);
@@ -2,6 +2,8 @@
 
 #include <filesystem>
 #include <map>
+#include <optional>
+#include <string_view>
 
 #include <Vulkan/VulkanEntity.h>
 #include <shaderc/shaderc.hpp>
@@ -12,25 +14,46 @@ namespace Lucid::Vulkan
 
 class VulkanDevice;
 
+/*
+        Shader module compiled from GLSL with shaderc. SPIR-V is cached by a hash of the source, stage and
+        compiler options, in memory for the process and on disk in the cache directory, so every shader is
+        compiled once and pipeline rebuilds on resize only create modules.
+*/
 class VulkanShader : public VulkanEntity<vk::UniqueShaderModule>
 {
 public:
     enum class Type
     {
         Vertex,
-        Fragment
+        Fragment,
+        Compute
     };
 
+    // Bump whenever compile options change, invalidates every cached shader
+    inline static const std::uint32_t CacheVersion = 1;
+
     VulkanShader(VulkanDevice& device, Type type, const std::filesystem::path& path);
 
 private:
-    [[nodiscard]] std::string PreprocessShader(const std::string& source, Type type, const std::string& name);
-    [[nodiscard]] std::vector<std::uint32_t>
+    [[nodiscard]] static const std::vector<std::uint32_t>&
+    GetSpirv(std::string_view source, Type type, const std::filesystem::path& path);
+
+    // Sources are self contained, without an includer the hash of the text covers its defines as well
+    [[nodiscard]] static std::uint64_t HashSource(std::string_view source, Type type);
+    [[nodiscard]] static std::filesystem::path GetCachePath(const std::filesystem::path& path, std::uint64_t hash);
+
+    // Empty when missing or not SPIR-V
+    [[nodiscard]] static std::optional<std::vector<std::uint32_t>> LoadCached(const std::filesystem::path& path);
+    static void SaveCached(const std::filesystem::path& path, const std::vector<std::uint32_t>& spirv);
+
+    [[nodiscard]] static std::string PreprocessShader(std::string_view source, Type type, const std::string& name);
+    [[nodiscard]] static std::vector<std::uint32_t>
     CompileShader(const std::string& source, Type type, const std::string& name);
 
     inline static const std::map<Type, shaderc_shader_kind> TypeMap {
         { Type::Fragment, shaderc_shader_kind::shaderc_fragment_shader },
         { Type::Vertex, shaderc_shader_kind::shaderc_vertex_shader },
+        { Type::Compute, shaderc_shader_kind::shaderc_compute_shader },
     };
 };
 
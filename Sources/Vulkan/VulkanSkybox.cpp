@@ -1,6 +1,9 @@
 #include "VulkanSkybox.h"
 
+#include <chrono>
+
 #include <Utils/Files.h>
+#include <Utils/Logger.hpp>
 
 namespace Lucid::Vulkan
 {
@@ -9,19 +12,31 @@ VulkanSkybox::VulkanSkybox(VulkanDevice& device, VulkanDescriptorPool& pool, Vul
     : mDescriptorSet(device, pool)
     , mUniformBuffer(device)
 {
-    Core::MeshPtr mesh = Files::LoadModel("Resources/Models/Cube.obj")->GetOptionalMesh().value();
+    // The cube is a single OBJ object, its mesh lives on the only child of the root
+    Core::SceneNodePtr cube = Files::LoadModel("Resources/Models/Cube.obj");
+    if (cube->GetChildren().size() != 1)
+    {
+        throw std::runtime_error("Can't create skybox, cube model must contain exactly one mesh");
+    }
+
+    Core::MeshPtr mesh = cube->GetChildren().front()->GetOptionalMesh().value();
     mIndexBuffer = std::make_unique<VulkanIndexBuffer>(device, manager, mesh->indices);
-    mVertexBuffer = std::make_unique<VulkanVertexBuffer>(device, manager, mesh->vertices);
+    // The skybox shader samples the cubemap with raw positions, the cube stays in float
+    mVertexBuffer = std::make_unique<VulkanVertexBuffer>(device, manager, mesh->vertices, Core::VertexFormat::Float);
+
+    auto start = std::chrono::steady_clock::now();
+
+    Core::TexturePtr cubemap = Files::LoadCubemap({ "Resources/Skyboxes/BACK.jpeg",
+                                                    "Resources/Skyboxes/FRONT.jpeg",
+                                                    "Resources/Skyboxes/LEFT.jpeg",
+                                                    "Resources/Skyboxes/RIGHT.jpeg",
+                                                    "Resources/Skyboxes/UP.jpeg",
+                                                    "Resources/Skyboxes/DOWN.jpeg" });
 
-    std::array<Core::TexturePtr, 6> textures { Lucid::Files::LoadTexture("Resources/Skyboxes/BACK.jpeg"),
-                                               Lucid::Files::LoadTexture("Resources/Skyboxes/FRONT.jpeg"),
-                                               Lucid::Files::LoadTexture("Resources/Skyboxes/LEFT.jpeg"),
-                                               Lucid::Files::LoadTexture("Resources/Skyboxes/RIGHT.jpeg"),
-                                               Lucid::Files::LoadTexture("Resources/Skyboxes/UP.jpeg"),
-                                               Lucid::Files::LoadTexture("Resources/Skyboxes/DOWN.jpeg") };
+    mTexture = VulkanImage::FromCubemap(device, manager, cubemap, vk::ImageAspectFlagBits::eColor);
 
-    mTexture = VulkanImage::FromCubemap(
-        device, manager, textures, vk::Format::eR8G8B8A8Srgb, vk::ImageAspectFlagBits::eColor);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LoggerInfo << "Skybox uploaded in " << elapsed.count() << " ms";
 
     mSampler = std::make_unique<VulkanSampler>(device, mTexture->GetMipLevels());
 
@@ -47,7 +62,7 @@ VulkanSkybox::Draw(vk::CommandBuffer& commandBuffer, VulkanPipeline& pipeline) c
     vk::Buffer vertexBuffers[] = { mVertexBuffer->Handle().get() };
     vk::DeviceSize offsets[] = { 0 };
     commandBuffer.bindVertexBuffers(0, 1, vertexBuffers, offsets);
-    commandBuffer.bindIndexBuffer(mIndexBuffer->Handle().get(), 0, vk::IndexType::eUint32);
+    commandBuffer.bindIndexBuffer(mIndexBuffer->Handle().get(), 0, mIndexBuffer->GetIndexType());
     commandBuffer.drawIndexed(static_cast<std::uint32_t>(mIndexBuffer->IndicesCount()), 1, 0, 0, 0);
 }
 